@@ -31,6 +31,7 @@ public class FireflyAbilitySystem : ModuleRules
                 "DeveloperSettings",
                 "EnhancedInput",
                 "DataRegistry",
+                "NetCore",
                 // ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -266,19 +266,13 @@ void UFireflyAbility::Client_CancelAbility_Implementation()
 
 bool UFireflyAbility::CheckAbilityCost_Implementation() const
 {
-	bool bCostMaySucceed = true;
-	for (auto CostSetting : CostSettings)
+	UFireflyAbilitySystemComponent* Manager = GetOwnerManager();
+	if (!IsValid(Manager))
 	{
-		if (GetOwnerManager()->CanApplyModifierInstant(CostSetting.AttributeType, CostSetting.ModOperator, CostSetting.ModValue))
-		{
-			continue;
-		}
-
-		bCostMaySucceed = false;
-		break;
+		return false;
 	}
 
-	return bCostMaySucceed;
+	return Manager->CanApplyModifiersInstant(CostSettings);
 }
 
 void UFireflyAbility::ApplyAbilityCost()
@@ -289,10 +283,11 @@ void UFireflyAbility::ApplyAbilityCost()
 		return;
 	}
 
-	FFireflyEffectDynamicConstructor CostSetup;
-	CostSetup.DurationPolicy = EFireflyEffectDurationPolicy::Instant;
-	CostSetup.Modifiers = CostSettings;
-	GetOwnerManager()->ApplyEffectDynamicConstructorToOwner(nullptr, CostSetup);
+	/** 不创建效果实例，在一次属性修改事务中检验并应用所有消耗，计算器的修改值以效果类型的默认对象为上下文解析 */
+	if (!Manager->TryApplyModifiersInstant(CostSettings, this))
+	{
+		return;
+	}
 
 	GetOwnerManager()->OnAbilityCostCommitted.Broadcast(AbilityID, GetClass());
 }
@@ -310,7 +305,7 @@ bool UFireflyAbility::CheckAbilityCooldown_Implementation() const
 		return false;
 	}
 
-	return Manager->GetActiveEffectsByTag(CooldownTags).Num() <= 0;
+	return !Manager->IsOnCooldown(CooldownTags);
 }
 
 void UFireflyAbility::ApplyAbilityCooldown()
@@ -321,11 +316,7 @@ void UFireflyAbility::ApplyAbilityCooldown()
 		return;
 	}
 
-	FFireflyEffectDynamicConstructor CostSetup;
-	CostSetup.DurationPolicy = EFireflyEffectDurationPolicy::HasDuration;
-	CostSetup.Duration = CooldownTime;
-	CostSetup.TagsForEffectAsset = CooldownTags;
-	GetOwnerManager()->ApplyEffectDynamicConstructorToOwner(nullptr, CostSetup);
+	Manager->ApplyCooldown(CooldownTags, CooldownTime);
 
 	GetOwnerManager()->OnAbilityCooldownCommitted.Broadcast(AbilityID, GetClass(), CooldownTime);
 }
@@ -424,7 +415,8 @@ void UFireflyAbility::ExecuteAbilityTagRequirementToOwner(bool bIsActivated)
 
 	UFireflyAbilitySystemComponent* Manager = GetOwnerManager();
 
-	Manager->UpdateBlockAndCancelAbilityTags(TagsOfAbilitiesWillBeBlocked, TagsOfAbilitiesWillBeCanceled, bIsActivated);
+	BuildTagBits();
+	Manager->UpdateBlockAndCancelAbilityTags(TagsOfAbilitiesWillBeBlocked, TagsOfAbilitiesWillBeCanceledBits, bIsActivated);
 	if (bIsActivated)
 	{
 		Manager->AddTagsToManager(TagsApplyToOwnerOnActivated, 1);
@@ -435,6 +427,27 @@ void UFireflyAbility::ExecuteAbilityTagRequirementToOwner(bool bIsActivated)
 	}
 }
 
+const FFireflyGameplayTagBits& UFireflyAbility::GetTagsForAbilityAssetBits() const
+{
+	BuildTagBits();
+
+	return TagsForAbilityAssetBits;
+}
+
+void UFireflyAbility::BuildTagBits() const
+{
+	if (bTagBitsBuilt)
+	{
+		return;
+	}
+
+	TagsForAbilityAssetBits = FFireflyGameplayTagBits::MakeExact(TagsForAbilityAsset);
+	TagsRequireOwnerHasForActivationBits = FFireflyGameplayTagBits::MakeExact(TagsRequireOwnerHasForActivation);
+	TagsBlockActivationOnOwnerHasBits = FFireflyGameplayTagBits::MakeExact(TagsBlockActivationOnOwnerHas);
+	TagsOfAbilitiesWillBeCanceledBits = FFireflyGameplayTagBits::MakeExact(TagsOfAbilitiesWillBeCanceled);
+	bTagBitsBuilt = true;
+}
+
 bool UFireflyAbility::CanActivateAbility() const
 {
 	if (bIsActivating || !IsValid(GetOwnerManager()))
@@ -444,10 +457,10 @@ bool UFireflyAbility::CanActivateAbility() const
 
 	UFireflyAbilitySystemComponent* Manager = GetOwnerManager();
 
-	FGameplayTagContainer OwnerTags = Manager->GetContainedTags();
+	BuildTagBits();
 
 	/** Owner的Tag管理器是否包含阻挡该技能激活的Tag */
-	if (OwnerTags.HasAnyExact(TagsBlockActivationOnOwnerHas))
+	if (Manager->GetOwnedTagBits().HasAny(TagsBlockActivationOnOwnerHasBits))
 	{
 		return false;
 	}
@@ -459,7 +472,7 @@ bool UFireflyAbility::CanActivateAbility() const
 	}
 
 	/** Owner的Tag管理器是否包含该技能激活需要的所有Tag */
-	bool bOwnerHasRequiredTags = OwnerTags.HasAll(TagsRequireOwnerHasForActivation);
+	bool bOwnerHasRequiredTags = Manager->GetOwnedTagBitsWithParents().HasAll(TagsRequireOwnerHasForActivationBits);
 
 	/** 蓝图端是否满足技能激活的条件 */
 	bool bBlueprintCanActivate = true;
@@ -877,6 +890,20 @@ void UFireflyAbility::ApplyEffectToTargetByClass(AActor* Target, TSubclassOf<UFi
 	FireflyAbilitySystem->ApplyEffectToTargetByClass(Target, EffectType, EffectID, StackToApply);
 }
 
+TArray<EFireflyEffectApplicationResult> UFireflyAbility::ApplyEffectToTargetsByClass(const TArray<AActor*>& Targets,
+	TSubclassOf<UFireflyEffect> EffectType, FName EffectID, int32 StackToApply)
+{
+	UFireflyAbilitySystemComponent* FireflyAbilitySystem = GetOwnerManager();
+	if (!IsValid(FireflyAbilitySystem))
+	{
+		TArray<EFireflyEffectApplicationResult> Results;
+		Results.Init(EFireflyEffectApplicationResult::InvalidTarget, Targets.Num());
+		return Results;
+	}
+
+	return FireflyAbilitySystem->ApplyEffectToTargetsByClass(Targets, EffectType, EffectID, StackToApply);
+}
+
 void UFireflyAbility::ApplyEffectDynamicConstructorToOwner(FFireflyEffectDynamicConstructor EffectSetup,
 	int32 StackToApply)
 {
@@ -0,0 +1,22 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyAbilityCooldown.h"
+
+#include "FireflyAbilitySystemComponent.h"
+
+void FFireflyAbilityCooldownEntry::PostReplicatedAdd(const FFireflyAbilityCooldownContainer& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.Owner))
+	{
+		InArraySerializer.Owner->OnAbilityCooldownReplicated(*this);
+	}
+}
+
+void FFireflyAbilityCooldownEntry::PostReplicatedChange(const FFireflyAbilityCooldownContainer& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.Owner))
+	{
+		InArraySerializer.Owner->OnAbilityCooldownReplicated(*this);
+	}
+}
@@ -5,7 +5,12 @@
 
 #include "EnhancedInputComponent.h"
 #include "FireflyAbilitySystemLibrary.h"
+#include "FireflyAbilitySystemModule.h"
+#include "FireflyAbilitySystemSettings.h"
+#include "FireflyAttributeStoreSubsystem.h"
+#include "FireflyEffectModifierCalculator.h"
 #include "Engine/ActorChannel.h"
+#include "GameFramework/GameStateBase.h"
 #include "Net/UnrealNetwork.h"
 
 // Sets default values for this component's properties
@@ -16,6 +21,19 @@ UFireflyAbilitySystemComponent::UFireflyAbilitySystemComponent(const FObjectInit
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
 	SetIsReplicatedByDefault(true);
+
+	for (int16& AttributeIndex : AttributeLookupTable)
+	{
+		AttributeIndex = INDEX_NONE;
+	}
+
+	for (int16& AttributeIndex : StructAttributeLookupTable)
+	{
+		AttributeIndex = INDEX_NONE;
+	}
+	StructAttributes.Owner = this;
+	AbilityCooldowns.Owner = this;
+	ReplicatedTagCounts.Owner = this;
 }
 
 
@@ -23,6 +41,29 @@ UFireflyAbilitySystemComponent::UFireflyAbilitySystemComponent(const FObjectInit
 void UFireflyAbilitySystemComponent::BeginPlay()
 {
 	Super::BeginPlay();
+
+	InitializeAttributeHistory();
+}
+
+void UFireflyAbilitySystemComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterAttributesFromStore();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UFireflyAbilitySystemComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	UFireflyAbilitySystemLibrary::RegisterFireflyAbilitySystem(this);
+}
+
+void UFireflyAbilitySystemComponent::OnUnregister()
+{
+	UFireflyAbilitySystemLibrary::UnregisterFireflyAbilitySystem(this);
+
+	Super::OnUnregister();
 }
 
 
@@ -30,6 +71,12 @@ void UFireflyAbilitySystemComponent::BeginPlay()
 void UFireflyAbilitySystemComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	/** 属性修改事务的开始和提交必须在同一帧内成对调用，帧末仍未提交说明调用不配对 */
+	if (IsInModifierTransaction())
+	{
+		CloseUnbalancedModifierTransactions();
+	}
 }
 
 bool UFireflyAbilitySystemComponent::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch,
@@ -71,6 +118,21 @@ void UFireflyAbilitySystemComponent::GetLifetimeReplicatedProps(TArray<FLifetime
 	DOREPLIFETIME(UFireflyAbilitySystemComponent, GrantedAbilities);
 	DOREPLIFETIME(UFireflyAbilitySystemComponent, ActiveEffects);
 	DOREPLIFETIME(UFireflyAbilitySystemComponent, AttributeContainer);
+	DOREPLIFETIME(UFireflyAbilitySystemComponent, StructAttributes);
+	DOREPLIFETIME_CONDITION(UFireflyAbilitySystemComponent, AbilityCooldowns, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UFireflyAbilitySystemComponent, ReplicatedTagCounts,
+		UFireflyAbilitySystemSettings::Get()->bReplicateTagCountsToOwnerOnly ? COND_OwnerOnly : COND_None);
+}
+
+void UFireflyAbilitySystemComponent::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	UFireflyAbilitySystemComponent* This = CastChecked<UFireflyAbilitySystemComponent>(InThis);
+	for (FFireflyStructAttribute& Attribute : This->StructAttributes.Items)
+	{
+		Attribute.Modifiers.AddReferencedObjects(Collector, This);
+	}
+
+	Super::AddReferencedObjects(InThis, Collector);
 }
 
 bool UFireflyAbilitySystemComponent::HasAuthority() const
@@ -297,7 +359,7 @@ void UFireflyAbilitySystemComponent::Server_TryActivateAbility_Implementation(UF
 		return;
 	}
 
-	if (Ability->TagsForAbilityAsset.HasAnyExact(GetBlockAbilityTags()))
+	if (Ability->GetTagsForAbilityAssetBits().HasAny(BlockAbilityTagBits))
 	{
 		return;
 	}
@@ -334,8 +396,7 @@ bool UFireflyAbilitySystemComponent::TryActivateAbilityByID(FName AbilityID)
 	if (GetOwnerRole() == ROLE_AutonomousProxy)
 	{
 		return Ability->CanActivateAbility()
-			&& Ability->TagsForAbilityAsset.HasAnyExact(
-				GetBlockAbilityTags());
+			&& Ability->GetTagsForAbilityAssetBits().HasAny(BlockAbilityTagBits);
 	}
 
 	return Ability->bIsActivating;
@@ -360,8 +421,7 @@ bool UFireflyAbilitySystemComponent::TryActivateAbilityByClass(
 	if (GetOwnerRole() == ROLE_AutonomousProxy)
 	{
 		return Ability->CanActivateAbility()
-			&& Ability->TagsForAbilityAsset.HasAnyExact(
-				GetBlockAbilityTags());
+			&& Ability->GetTagsForAbilityAssetBits().HasAny(BlockAbilityTagBits);
 	}
 
 	return Ability->bIsActivating;
@@ -396,9 +456,19 @@ void UFireflyAbilitySystemComponent::CancelAbilitiesWithTags(FGameplayTagContain
 		return;
 	}
 
+	CancelAbilitiesWithTagBits(FFireflyGameplayTagBits::MakeExact(CancelTags));
+}
+
+void UFireflyAbilitySystemComponent::CancelAbilitiesWithTagBits(const FFireflyGameplayTagBits& CancelTagBits)
+{
+	if (!HasAuthority() || CancelTagBits.IsEmpty())
+	{
+		return;
+	}
+
 	for (auto Ability : GetActivatingAbilities())
 	{
-		if (Ability->TagsForAbilityAsset.HasAnyExact(CancelTags))
+		if (Ability->GetTagsForAbilityAssetBits().HasAny(CancelTagBits))
 		{
 			Ability->CancelAbility();
 		}
@@ -410,6 +480,33 @@ void UFireflyAbilitySystemComponent::OnAbilityEndActivation(UFireflyAbility* Abi
 	ActivatingAbilities.RemoveSingle(AbilityJustEnded);
 }
 
+template<typename FuncType>
+void UFireflyAbilitySystemComponent::ForEachActiveCooldownEntry(const FGameplayTagContainer& CooldownTags,
+	FuncType&& Func) const
+{
+	if (CooldownTags.IsEmpty())
+	{
+		return;
+	}
+
+	/** 携带所有冷却标签的记录必然位于第一个标签的下标列表中 */
+	const TArray<int32, TInlineAllocator<2>>* EntryIndices = CooldownEntriesByTag.Find(CooldownTags.First());
+	if (!EntryIndices)
+	{
+		return;
+	}
+
+	const double Now = GetCooldownServerTime();
+	for (const int32 EntryIndex : *EntryIndices)
+	{
+		const FFireflyAbilityCooldownEntry& Entry = AbilityCooldowns.Items[EntryIndex];
+		if (Entry.ExpireServerTime > Now && Entry.CooldownTags.HasAllExact(CooldownTags))
+		{
+			Func(EntryIndex, Entry.ExpireServerTime - Now);
+		}
+	}
+}
+
 void UFireflyAbilitySystemComponent::SetAbilityCooldownRemaining(TSubclassOf<UFireflyAbility> AbilityType,
 	float NewTimeRemaining)
 {
@@ -424,48 +521,143 @@ void UFireflyAbilitySystemComponent::SetAbilityCooldownRemaining(TSubclassOf<UFi
 		return;
 	}
 
-	TArray<UFireflyEffect*> CooldownEffects = GetActiveEffectsByTag(Ability->CooldownTags);
-	if (!CooldownEffects.IsValidIndex(0))
+	if (!IsOnCooldown(Ability->CooldownTags))
+	{
+		return;
+	}
+
+	float TotalDuration = 0.f;
+	ForEachActiveCooldownEntry(Ability->CooldownTags, [this, &TotalDuration](int32 EntryIndex, double)
+	{
+		TotalDuration = FMath::Max(TotalDuration, AbilityCooldowns.Items[EntryIndex].TotalDuration);
+	});
+
+	SetCooldownRemaining(Ability->CooldownTags, NewTimeRemaining);
+
+	OnAbilityCooldownRemainingChanged.Broadcast(Ability->AbilityID, AbilityType, NewTimeRemaining, TotalDuration);
+}
+
+bool UFireflyAbilitySystemComponent::IsOnCooldown(const FGameplayTagContainer& CooldownTags) const
+{
+	return GetCooldownTimeRemaining(CooldownTags) > 0.f;
+}
+
+float UFireflyAbilitySystemComponent::GetCooldownTimeRemaining(const FGameplayTagContainer& CooldownTags) const
+{
+	double Remaining = 0.0;
+	ForEachActiveCooldownEntry(CooldownTags, [&Remaining](int32, double EntryRemaining)
+	{
+		Remaining = FMath::Max(Remaining, EntryRemaining);
+	});
+
+	return static_cast<float>(Remaining);
+}
+
+void UFireflyAbilitySystemComponent::ApplyCooldown(const FGameplayTagContainer& CooldownTags, float Duration)
+{
+	if (!HasAuthority() || Duration <= 0.f || CooldownTags.IsEmpty())
+	{
+		return;
+	}
+
+	FFireflyAbilityCooldownEntry& Entry = FindOrAddCooldownEntry(CooldownTags);
+	Entry.ExpireServerTime = GetCooldownServerTime() + Duration;
+	Entry.TotalDuration = Duration;
+	AbilityCooldowns.MarkItemDirty(Entry);
+}
+
+void UFireflyAbilitySystemComponent::SetCooldownRemaining(const FGameplayTagContainer& CooldownTags,
+	float NewTimeRemaining)
+{
+	if (!HasAuthority())
 	{
 		return;
 	}
 
-	CooldownEffects[0]->SetTimeRemainingOfDuration(NewTimeRemaining);
+	const double ExpireTime = GetCooldownServerTime() + FMath::Max(NewTimeRemaining, 0.f);
+	ForEachActiveCooldownEntry(CooldownTags, [this, ExpireTime](int32 EntryIndex, double)
+	{
+		FFireflyAbilityCooldownEntry& Entry = AbilityCooldowns.Items[EntryIndex];
+		Entry.ExpireServerTime = ExpireTime;
+		AbilityCooldowns.MarkItemDirty(Entry);
+	});
+}
+
+double UFireflyAbilitySystemComponent::GetCooldownServerTime() const
+{
+	const UWorld* World = GetWorld();
+	if (!IsValid(World))
+	{
+		return 0.0;
+	}
+
+	if (const AGameStateBase* GameState = World->GetGameState())
+	{
+		return GameState->GetServerWorldTimeSeconds();
+	}
+
+	return World->GetTimeSeconds();
+}
+
+void UFireflyAbilitySystemComponent::OnAbilityCooldownReplicated(const FFireflyAbilityCooldownEntry& Entry)
+{
+	const int32 EntryIndex = static_cast<int32>(&Entry - AbilityCooldowns.Items.GetData());
+	if (!AbilityCooldowns.Items.IsValidIndex(EntryIndex))
+	{
+		return;
+	}
 
-	OnAbilityCooldownRemainingChanged.Broadcast(Ability->AbilityID, AbilityType, NewTimeRemaining, CooldownEffects[0]->Duration);
+	/** 冷却记录的标签创建后不再改变，客户端只需在首次同步时建立下标，结束时间直接读取同步的记录 */
+	for (const FGameplayTag& CooldownTag : Entry.CooldownTags)
+	{
+		CooldownEntriesByTag.FindOrAdd(CooldownTag).AddUnique(EntryIndex);
+	}
 }
 
-FGameplayTagContainer UFireflyAbilitySystemComponent::GetBlockAbilityTags() const
+FFireflyAbilityCooldownEntry& UFireflyAbilitySystemComponent::FindOrAddCooldownEntry(const FGameplayTagContainer& CooldownTags)
 {
-	FGameplayTagContainer OutTags;
-	for (auto TagCount : BlockAbilityTags)
+	/** 冷却记录不会被删除，同一组冷却标签再次进入冷却时复用原记录，只同步改变的时间戳 */
+	if (const TArray<int32, TInlineAllocator<2>>* EntryIndices = CooldownEntriesByTag.Find(CooldownTags.First()))
+	{
+		for (const int32 EntryIndex : *EntryIndices)
+		{
+			if (AbilityCooldowns.Items[EntryIndex].CooldownTags == CooldownTags)
+			{
+				return AbilityCooldowns.Items[EntryIndex];
+			}
+		}
+	}
+
+	const int32 NewIndex = AbilityCooldowns.Items.AddDefaulted();
+	AbilityCooldowns.Items[NewIndex].CooldownTags = CooldownTags;
+	for (const FGameplayTag& CooldownTag : CooldownTags)
 	{
-		OutTags.AddTag(TagCount.Key);
+		CooldownEntriesByTag.FindOrAdd(CooldownTag).Add(NewIndex);
 	}
 
-	return OutTags;
+	return AbilityCooldowns.Items[NewIndex];
 }
 
-void UFireflyAbilitySystemComponent::UpdateBlockAndCancelAbilityTags(FGameplayTagContainer BlockTags,
-                                                                     FGameplayTagContainer CancelTags, bool bIsActivated)
+void UFireflyAbilitySystemComponent::UpdateBlockAndCancelAbilityTags(const FGameplayTagContainer& BlockTags,
+	const FFireflyGameplayTagBits& CancelTagBits, bool bIsActivated)
 {
 	if (bIsActivated)
 	{
-		CancelAbilitiesWithTags(CancelTags);
+		CancelAbilitiesWithTagBits(CancelTagBits);
 
-		TArray<FGameplayTag> Tags;
-		BlockTags.GetGameplayTagArray(Tags);
-		for (auto TagToAdd : Tags)
+		for (const FGameplayTag& TagToAdd : BlockTags)
 		{
 			int32& Count = BlockAbilityTags.FindOrAdd(TagToAdd);
-			++Count;
+			if (++Count == 1)
+			{
+				BlockAbilityTagContainer.AddTag(TagToAdd);
+				BlockAbilityTagBits.SetBit(FFireflyGameplayTagBitRegistry::Get().FindOrAddBitIndex(TagToAdd));
+			}
 		}
 	}
 	else
 	{
-		TArray<FGameplayTag> Tags;
-		BlockTags.GetGameplayTagArray(Tags);
-		for (auto TagToRemove : Tags)
+		for (const FGameplayTag& TagToRemove : BlockTags)
 		{
 			if (!BlockAbilityTags.Contains(TagToRemove))
 			{
@@ -478,6 +670,8 @@ void UFireflyAbilitySystemComponent::UpdateBlockAndCancelAbilityTags(FGameplayTa
 			if (*CountToMinus == 0)
 			{
 				BlockAbilityTags.Remove(TagToRemove);
+				BlockAbilityTagContainer.RemoveTag(TagToRemove);
+				BlockAbilityTagBits.ClearBit(FFireflyGameplayTagBitRegistry::Get().FindOrAddBitIndex(TagToRemove));
 			}
 		}
 	}
@@ -743,311 +937,1022 @@ void UFireflyAbilitySystemComponent::OnAbilityInputActionCompleted(UInputAction*
 
 UFireflyAttribute* UFireflyAbilitySystemComponent::GetAttributeByType(EFireflyAttributeType AttributeType) const
 {
-	UFireflyAttribute* OutAttribute = nullptr;
-	for (auto Attribute : AttributeContainer)
+	if (AttributeType >= AttributeType_Max)
 	{
-		if (Attribute->AttributeType == AttributeType)
-		{
-			OutAttribute = Attribute;
-			break;
-		}
+		return nullptr;
+	}
+
+	const int16 AttributeIndex = AttributeLookupTable[AttributeType];
+	if (!AttributeContainer.IsValidIndex(AttributeIndex))
+	{
+		return nullptr;
 	}
 
-	return OutAttribute;
+	return AttributeContainer[AttributeIndex];
 }
 
 UFireflyAttribute* UFireflyAbilitySystemComponent::GetAttributeByName(FName AttributeName) const
 {
-	const UEnum* EnumPtr = FindObject<UEnum>(ANY_PACKAGE, TEXT("EFireflyAttributeType"), true);
-	if (!EnumPtr)
+	return GetAttributeByType(UFireflyAbilitySystemLibrary::GetAttributeTypeByName(AttributeName));
+}
+
+void UFireflyAbilitySystemComponent::AddAttributeToContainer(UFireflyAttribute* NewAttribute)
+{
+	const int32 NewIndex = AttributeContainer.Emplace(NewAttribute);
+
+	const EFireflyAttributeType AttributeType = NewAttribute->AttributeType;
+	if (AttributeType < AttributeType_Max && AttributeLookupTable[AttributeType] == INDEX_NONE)
 	{
-		return nullptr;
+		AttributeLookupTable[AttributeType] = NewIndex;
+	}
+
+	RegisterAttributeToStore(NewAttribute);
+
+	TArray<EFireflyAttributeType, TInlineAllocator<4>> SourceTypes;
+	NewAttribute->GetDependencySourceTypes(SourceTypes);
+	RegisterAttributeDependencies(AttributeType, SourceTypes);
+
+	/** 新属性的加入可能改变依赖它的属性的当前值 */
+	const EFireflyAttributeType Roots[] = { AttributeType };
+	UpdateAttributesInDependencyOrder(Roots, false);
+}
+
+void UFireflyAbilitySystemComponent::RebuildAttributeLookupTable()
+{
+	for (int16& AttributeIndex : AttributeLookupTable)
+	{
+		AttributeIndex = INDEX_NONE;
 	}
 
-	UFireflyAttribute* OutAttribute = nullptr;
-	for (auto Attribute : AttributeContainer)
+	for (int32 i = 0; i < AttributeContainer.Num(); ++i)
 	{
-		if (EnumPtr->GetDisplayNameTextByValue(Attribute->AttributeType).ToString() == AttributeName.ToString())
+		const UFireflyAttribute* Attribute = AttributeContainer[i];
+		if (!IsValid(Attribute) || Attribute->AttributeType >= AttributeType_Max)
 		{
-			OutAttribute = Attribute;
-			break;
+			continue;
+		}
+
+		if (AttributeLookupTable[Attribute->AttributeType] == INDEX_NONE)
+		{
+			AttributeLookupTable[Attribute->AttributeType] = i;
 		}
 	}
+}
 
-	return OutAttribute;
+void UFireflyAbilitySystemComponent::OnRep_AttributeContainer()
+{
+	RebuildAttributeLookupTable();
 }
 
-float UFireflyAbilitySystemComponent::GetAttributeValue(EFireflyAttributeType AttributeType) const
+FFireflyAttributeValueChangeNativeDelegate& UFireflyAbilitySystemComponent::GetAttributeValueChangeDelegate(
+	EFireflyAttributeType AttributeType)
 {
-	for (const auto Attribute : AttributeContainer)
+	TUniquePtr<FFireflyAttributeValueChangeNativeDelegate>& NativeDelegate = AttributeValueChangeDelegates.FindOrAdd(AttributeType);
+	if (!NativeDelegate.IsValid())
 	{
-		if (Attribute->AttributeType == AttributeType)
-		{
-			return Attribute->GetCurrentValue();
-		}
+		NativeDelegate = MakeUnique<FFireflyAttributeValueChangeNativeDelegate>();
 	}
 
-	return 0.f;
+	return *NativeDelegate;
 }
 
-float UFireflyAbilitySystemComponent::GetAttributeBaseValue(EFireflyAttributeType AttributeType) const
+FFireflyAttributeValueChangeNativeDelegate& UFireflyAbilitySystemComponent::GetAttributeBaseValueChangeDelegate(
+	EFireflyAttributeType AttributeType)
 {
-	float OutBaseValue = 0.f;
-	for (auto Attribute : AttributeContainer)
+	TUniquePtr<FFireflyAttributeValueChangeNativeDelegate>& NativeDelegate = AttributeBaseValueChangeDelegates.FindOrAdd(AttributeType);
+	if (!NativeDelegate.IsValid())
 	{
-		if (Attribute->AttributeType == AttributeType)
-		{
-			OutBaseValue = Attribute->GetBaseValueToUse();
-			break;
-		}
+		NativeDelegate = MakeUnique<FFireflyAttributeValueChangeNativeDelegate>();
 	}
 
-	return OutBaseValue;
+	return *NativeDelegate;
 }
 
-void UFireflyAbilitySystemComponent::ConstructAttributeByConstructor(FFireflyAttributeConstructor AttributeConstructor)
+void UFireflyAbilitySystemComponent::BroadcastAttributeValueChanged(EFireflyAttributeType AttributeType, float NewValue,
+	float OldValue)
 {
-	if (!HasAuthority())
+	/** 处于属性修改事务中时，记录事务开始前的当前值，由事务提交时统一广播 */
+	if (IsInModifierTransaction())
 	{
+		for (const FFireflyDirtyAttribute& DirtyAttribute : DirtyAttributes)
+		{
+			if (DirtyAttribute.AttributeType == AttributeType)
+			{
+				return;
+			}
+		}
+
+		DirtyAttributes.Emplace(FFireflyDirtyAttribute(AttributeType, GetAttributeRawBaseValue(AttributeType), OldValue));
 		return;
 	}
 
-	UFireflyAttribute* NewAttribute = NewObject<UFireflyAttribute>(this);
-	if (!IsValid(NewAttribute))
+	if (AttributeHistoryHead != INDEX_NONE && NewValue != OldValue)
 	{
-		return;
+		RecordAttributeHistory(AttributeType, OldValue);
+	}
+
+	if (const TUniquePtr<FFireflyAttributeValueChangeNativeDelegate>* NativeDelegate = AttributeValueChangeDelegates.Find(AttributeType))
+	{
+		(*NativeDelegate)->Broadcast(AttributeType, NewValue, OldValue);
 	}
-	NewAttribute->AttributeType = AttributeConstructor.AttributeType;
-	NewAttribute->bAttributeHasRange = AttributeConstructor.bAttributeHasRange;
-	NewAttribute->RangeMinValue = AttributeConstructor.RangeMinValue;
-	NewAttribute->RangeMaxValue = AttributeConstructor.RangeMaxValue;
-	NewAttribute->RangeMaxValueType = AttributeConstructor.RangeMaxValueType;
-	NewAttribute->InitAttributeInstance();
 
-	AttributeContainer.Emplace(NewAttribute);
+	if (OnAttributeValueChanged.IsBound())
+	{
+		OnAttributeValueChanged.Broadcast(AttributeType, NewValue, OldValue);
+	}
 }
 
-void UFireflyAbilitySystemComponent::ConstructAttributeByClass(TSubclassOf<UFireflyAttribute> AttributeClass)
+void UFireflyAbilitySystemComponent::BroadcastAttributeBaseValueChanged(EFireflyAttributeType AttributeType,
+	float NewValue, float OldValue)
 {
-	if (!IsValid(AttributeClass) || !HasAuthority())
+	if (const TUniquePtr<FFireflyAttributeValueChangeNativeDelegate>* NativeDelegate = AttributeBaseValueChangeDelegates.Find(AttributeType))
 	{
-		return;
+		(*NativeDelegate)->Broadcast(AttributeType, NewValue, OldValue);
 	}
 
-	UFireflyAttribute* NewAttribute = NewObject<UFireflyAttribute>(this, AttributeClass);
-	if (!IsValid(NewAttribute))
+	if (OnAttributeBaseValueChanged.IsBound())
 	{
-		return;
-	}NewAttribute->InitAttributeInstance();
-
-	AttributeContainer.Emplace(NewAttribute);
+		OnAttributeBaseValueChanged.Broadcast(AttributeType, NewValue, OldValue);
+	}
 }
 
-void UFireflyAbilitySystemComponent::ConstructAttributeByType(EFireflyAttributeType AttributeType)
+FFireflyAttributeModifierContainer* UFireflyAbilitySystemComponent::GetAttributeModifiers(EFireflyAttributeType AttributeType)
 {
-	if (!HasAuthority())
+	if (FFireflyStructAttribute* StructAttribute = GetStructAttributeByType(AttributeType))
 	{
-		return;
+		return &StructAttribute->Modifiers;
 	}
 
-	UFireflyAttribute* NewAttribute = NewObject<UFireflyAttribute>(this);
-	if (!IsValid(NewAttribute))
+	UFireflyAttribute* Attribute = GetAttributeByType(AttributeType);
+	if (!IsValid(Attribute))
 	{
-		return;
+		return nullptr;
 	}
-	NewAttribute->AttributeType = AttributeType;
-	NewAttribute->InitAttributeInstance();
 
-	AttributeContainer.Emplace(NewAttribute);
+	return &Attribute->Modifiers;
 }
 
-void UFireflyAbilitySystemComponent::InitializeAttributeByType(EFireflyAttributeType AttributeType, float NewInitValue)
+float UFireflyAbilitySystemComponent::GetAttributeRawBaseValue(EFireflyAttributeType AttributeType) const
 {
-	if (!HasAuthority())
+	if (const FFireflyStructAttribute* StructAttribute = GetStructAttributeByType(AttributeType))
 	{
-		return;
+		return StructAttribute->BaseValue;
 	}
 
-	UFireflyAttribute* AttributeToInit = GetAttributeByType(AttributeType);
-	if (!IsValid(AttributeToInit))
+	const UFireflyAttribute* Attribute = GetAttributeByType(AttributeType);
+	if (!IsValid(Attribute))
 	{
-		return;
+		return 0.f;
 	}
 
-	AttributeToInit->InitializeAttributeValue(NewInitValue);
+	return Attribute->BaseValue;
 }
 
-void UFireflyAbilitySystemComponent::InitializeAttributeByName(FName AttributeName, float NewInitValue)
+float UFireflyAbilitySystemComponent::GetAttributeRawCurrentValue(EFireflyAttributeType AttributeType) const
 {
-	if (!HasAuthority())
+	if (const FFireflyStructAttribute* StructAttribute = GetStructAttributeByType(AttributeType))
 	{
-		return;
+		return StructAttribute->CurrentValue;
 	}
 
-	UFireflyAttribute* AttributeToInit = GetAttributeByName(AttributeName);
-	if (!IsValid(AttributeToInit))
+	const UFireflyAttribute* Attribute = GetAttributeByType(AttributeType);
+	if (!IsValid(Attribute))
 	{
-		return;
+		return 0.f;
 	}
 
-	AttributeToInit->InitializeAttributeValue(NewInitValue);
+	return Attribute->GetCurrentValue();
 }
 
-void UFireflyAbilitySystemComponent::PreModiferApplied(EFireflyAttributeType AttributeType,
-	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply)
+void UFireflyAbilitySystemComponent::UpdateAttributeCurrentValueByType(EFireflyAttributeType AttributeType)
 {
+	if (FFireflyStructAttribute* StructAttribute = GetStructAttributeByType(AttributeType))
+	{
+		UpdateStructAttributeCurrentValue(*StructAttribute);
+		return;
+	}
+
+	if (UFireflyAttribute* Attribute = GetAttributeByType(AttributeType))
+	{
+		Attribute->UpdateCurrentValue();
+	}
 }
 
-void UFireflyAbilitySystemComponent::PostModiferApplied(EFireflyAttributeType AttributeType,
-	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply)
+void UFireflyAbilitySystemComponent::UpdateAttributeBaseValueByType(EFireflyAttributeType AttributeType,
+	EFireflyAttributeModOperator ModOperator, float ModValue)
 {
-}
+	if (FFireflyStructAttribute* StructAttribute = GetStructAttributeByType(AttributeType))
+	{
+		UpdateStructAttributeBaseValue(*StructAttribute, ModOperator, ModValue);
+		return;
+	}
 
-#define FIREFLY_ATTRIBUTE_MODIFIER_APPLY(ModOperatorName) \
-	{ \
-		if (!AttributeToMod->##ModOperatorName##Mods.Contains(FFireflyAttributeModifier(ModSource, ModValue))) \
-		{ \
-			AttributeToMod->##ModOperatorName##Mods.Push(FFireflyAttributeModifier(ModSource, ModValue, StackToApply)); \
-			break; \
-		} \
-		\
-		for (FFireflyAttributeModifier& Modifier : AttributeToMod->##ModOperatorName##Mods) \
-		{ \
-			if (Modifier.ModSource == ModSource) \
-			{ \
-				Modifier.StackCount = StackToApply; \
-				break; \
-			} \
-		} \
-		break; \
+	if (UFireflyAttribute* Attribute = GetAttributeByType(AttributeType))
+	{
+		Attribute->UpdateBaseValue(ModOperator, ModValue);
 	}
+}
 
-void UFireflyAbilitySystemComponent::ApplyModifierToAttribute(EFireflyAttributeType AttributeType,
-	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply)
+float UFireflyAbilitySystemComponent::GetAttributeValue(EFireflyAttributeType AttributeType) const
 {
-	if (!HasAuthority() || !IsValid(ModSource))
+	if (bIsAttributeRewound && AttributeType < AttributeType_Max && RewoundAttributeMask[AttributeType])
 	{
-		return;
+		return RewoundAttributeValues[AttributeType];
 	}
 
-	UFireflyAttribute* AttributeToMod = GetAttributeByType(AttributeType);
-	if (!IsValid(AttributeToMod))
+	return GetLiveAttributeValue(AttributeType);
+}
+
+float UFireflyAbilitySystemComponent::GetLiveAttributeValue(EFireflyAttributeType AttributeType) const
+{
+	/** 事务中读取过期的属性值时，先重新计算所有待重新计算的属性 */
+	if (IsAttributeValueStale(AttributeType))
 	{
-		return;
+		const_cast<UFireflyAbilitySystemComponent*>(this)->RecomputePendingAttributes();
 	}
 
-	switch (ModOperator)
+	if (const FFireflyStructAttribute* StructAttribute = GetStructAttributeByType(AttributeType))
 	{
-	case EFireflyAttributeModOperator::None:
-		{
-			break;
-		}
-	case EFireflyAttributeModOperator::Plus:
-		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY(Plus);
-		}
-	case EFireflyAttributeModOperator::Minus:
-		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY(Minus);
-		}
-	case EFireflyAttributeModOperator::Multiply:
-		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY(Multiply);
-		}
-	case EFireflyAttributeModOperator::Divide:
-		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY(Divide);
-		}
-	case EFireflyAttributeModOperator::InnerOverride:
-		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY(InnerOverride);
-		}
-	case EFireflyAttributeModOperator::OuterOverride:
-		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY(OuterOverride);
-		}
+		return StructAttribute->CurrentValue;
 	}
 
-	PreModiferApplied(AttributeType, ModOperator, ModSource, ModValue, StackToApply);
-
-	AttributeToMod->UpdateCurrentValue();
+	const UFireflyAttribute* Attribute = GetAttributeByType(AttributeType);
+	if (!IsValid(Attribute))
+	{
+		return 0.f;
+	}
 
-	PostModiferApplied(AttributeType, ModOperator, ModSource, ModValue, StackToApply);
+	return Attribute->GetCurrentValue();
 }
 
-#define FIREFLY_ATTRIBUTE_MODIFIER_REMOVE(ModOperatorName) \
-	{ \
-		if (AttributeToMod->##ModOperatorName##Mods.Contains(ModifierToRemove)) \
-		{ \
-			AttributeToMod->##ModOperatorName##Mods.RemoveSingle(ModifierToRemove); \
-		} \
-		break; \
+bool UFireflyAbilitySystemComponent::IsAttributeValueClamped(EFireflyAttributeType AttributeType) const
+{
+	if (const FFireflyStructAttribute* StructAttribute = GetStructAttributeByType(AttributeType))
+	{
+		return StructAttribute->bAttributeHasRange || StructAttribute->bAttributeMustNotLessThanSelection;
+	}
+
+	const UFireflyAttribute* Attribute = GetAttributeByType(AttributeType);
+	if (!IsValid(Attribute))
+	{
+		return false;
 	}
 
-void UFireflyAbilitySystemComponent::RemoveModifierFromAttribute(EFireflyAttributeType AttributeType,
-	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue)
+	return Attribute->bAttributeHasRange || Attribute->bAttributeMustNotLessThanSelection;
+}
+
+float UFireflyAbilitySystemComponent::GetAttributeBaseValue(EFireflyAttributeType AttributeType) const
 {
-	if (!HasAuthority() || !IsValid(ModSource))
+	if (const FFireflyStructAttribute* StructAttribute = GetStructAttributeByType(AttributeType))
 	{
-		return;
+		return StructAttribute->GetBaseValueToUse();
 	}
 
-	UFireflyAttribute* AttributeToMod = GetAttributeByType(AttributeType);
-	if (!IsValid(AttributeToMod))
+	const UFireflyAttribute* Attribute = GetAttributeByType(AttributeType);
+	if (!IsValid(Attribute))
 	{
-		return;
+		return 0.f;
 	}
 
-	FFireflyAttributeModifier ModifierToRemove = FFireflyAttributeModifier(ModSource, ModValue);
+	return Attribute->GetBaseValueToUse();
+}
 
-	switch (ModOperator)
+void UFireflyAbilitySystemComponent::ConstructAttributeByConstructor(FFireflyAttributeConstructor AttributeConstructor)
+{
+	if (!HasAuthority())
 	{
-	case EFireflyAttributeModOperator::None:
+		return;
+	}
+
+	if (CanConstructStructAttribute(UFireflyAttribute::StaticClass()))
+	{
+		FFireflyStructAttribute NewAttribute;
+		NewAttribute.InitializeFromTemplate(GetDefault<UFireflyAttribute>());
+		NewAttribute.AttributeType = AttributeConstructor.AttributeType;
+		NewAttribute.bAttributeHasRange = AttributeConstructor.bAttributeHasRange;
+		NewAttribute.RangeMinValue = AttributeConstructor.RangeMinValue;
+		NewAttribute.RangeMaxValue = AttributeConstructor.RangeMaxValue;
+		NewAttribute.RangeMaxValueType = AttributeConstructor.RangeMaxValueType;
+
+		AddStructAttribute(NewAttribute);
+		return;
+	}
+
+	UFireflyAttribute* NewAttribute = NewObject<UFireflyAttribute>(this);
+	if (!IsValid(NewAttribute))
+	{
+		return;
+	}
+	NewAttribute->AttributeType = AttributeConstructor.AttributeType;
+	NewAttribute->bAttributeHasRange = AttributeConstructor.bAttributeHasRange;
+	NewAttribute->RangeMinValue = AttributeConstructor.RangeMinValue;
+	NewAttribute->RangeMaxValue = AttributeConstructor.RangeMaxValue;
+	NewAttribute->RangeMaxValueType = AttributeConstructor.RangeMaxValueType;
+	NewAttribute->InitAttributeInstance();
+
+	AddAttributeToContainer(NewAttribute);
+}
+
+void UFireflyAbilitySystemComponent::ConstructAttributeByClass(TSubclassOf<UFireflyAttribute> AttributeClass)
+{
+	if (!IsValid(AttributeClass) || !HasAuthority())
+	{
+		return;
+	}
+
+	if (CanConstructStructAttribute(AttributeClass))
+	{
+		FFireflyStructAttribute NewAttribute;
+		NewAttribute.InitializeFromTemplate(AttributeClass->GetDefaultObject<UFireflyAttribute>());
+
+		AddStructAttribute(NewAttribute);
+		return;
+	}
+
+	UFireflyAttribute* NewAttribute = NewObject<UFireflyAttribute>(this, AttributeClass);
+	if (!IsValid(NewAttribute))
+	{
+		return;
+	}
+	NewAttribute->InitAttributeInstance();
+
+	AddAttributeToContainer(NewAttribute);
+}
+
+void UFireflyAbilitySystemComponent::ConstructAttributeByType(EFireflyAttributeType AttributeType)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	if (CanConstructStructAttribute(UFireflyAttribute::StaticClass()))
+	{
+		FFireflyStructAttribute NewAttribute;
+		NewAttribute.InitializeFromTemplate(GetDefault<UFireflyAttribute>());
+		NewAttribute.AttributeType = AttributeType;
+
+		AddStructAttribute(NewAttribute);
+		return;
+	}
+
+	UFireflyAttribute* NewAttribute = NewObject<UFireflyAttribute>(this);
+	if (!IsValid(NewAttribute))
+	{
+		return;
+	}
+	NewAttribute->AttributeType = AttributeType;
+	NewAttribute->InitAttributeInstance();
+
+	AddAttributeToContainer(NewAttribute);
+}
+
+void UFireflyAbilitySystemComponent::InitializeAttributeByType(EFireflyAttributeType AttributeType, float NewInitValue)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	/** 处于属性修改事务中时，在基础值被修改前记录事务开始前的值，由事务提交时统一广播 */
+	if (IsInModifierTransaction())
+	{
+		MarkAttributeDirty(AttributeType);
+	}
+
+	if (FFireflyStructAttribute* StructAttribute = GetStructAttributeByType(AttributeType))
+	{
+		InitializeStructAttributeValue(*StructAttribute, NewInitValue);
+	}
+	else
+	{
+		UFireflyAttribute* AttributeToInit = GetAttributeByType(AttributeType);
+		if (!IsValid(AttributeToInit))
 		{
-			break;
+			return;
 		}
-	case EFireflyAttributeModOperator::Plus:
+
+		AttributeToInit->InitializeAttributeValue(NewInitValue);
+	}
+
+	const EFireflyAttributeType Roots[] = { AttributeType };
+	UpdateAttributesInDependencyOrder(Roots, false);
+}
+
+void UFireflyAbilitySystemComponent::InitializeAttributeByName(FName AttributeName, float NewInitValue)
+{
+	InitializeAttributeByType(UFireflyAbilitySystemLibrary::GetAttributeTypeByName(AttributeName), NewInitValue);
+}
+
+bool UFireflyAbilitySystemComponent::CanConstructStructAttribute(TSubclassOf<UFireflyAttribute> AttributeClass) const
+{
+	if (!bUseStructAttributes || !IsValid(AttributeClass))
+	{
+		return false;
+	}
+
+	/** 原生子类可能重写了计算逻辑，只有属性基类及其仅修改了默认值的蓝图子类可以以结构体的形式存储 */
+	const UClass* NativeClass = AttributeClass;
+	while (NativeClass && !NativeClass->HasAnyClassFlags(CLASS_Native))
+	{
+		NativeClass = NativeClass->GetSuperClass();
+	}
+
+	if (NativeClass != UFireflyAttribute::StaticClass())
+	{
+		return false;
+	}
+
+	return !AttributeClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UFireflyAttribute, UpdateCurrentValue))
+		&& !AttributeClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UFireflyAttribute, UpdateBaseValue))
+		&& !AttributeClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UFireflyAttribute, ReceiveInitAttributeInstance));
+}
+
+void UFireflyAbilitySystemComponent::AddStructAttribute(const FFireflyStructAttribute& NewAttribute)
+{
+	const EFireflyAttributeType AttributeType = NewAttribute.AttributeType;
+	if (AttributeType >= AttributeType_Max || StructAttributeLookupTable[AttributeType] != INDEX_NONE
+		|| AttributeLookupTable[AttributeType] != INDEX_NONE)
+	{
+		UE_LOG(LogFireflyAttribute, Warning, TEXT("UFireflyAbilitySystemComponent::AddStructAttribute() Attribute %s already exists in %s!"),
+			*UFireflyAbilitySystemLibrary::GetAttributeTypeName(AttributeType), *GetNameSafe(GetOwner()));
+		return;
+	}
+
+	const int32 NewIndex = StructAttributes.Items.Add(NewAttribute);
+	StructAttributeLookupTable[AttributeType] = NewIndex;
+
+	FFireflyStructAttribute& AddedAttribute = StructAttributes.Items[NewIndex];
+	UpdateStructAttributeCurrentValue(AddedAttribute);
+	StructAttributes.MarkItemDirty(AddedAttribute);
+
+	TArray<EFireflyAttributeType, TInlineAllocator<4>> SourceTypes;
+	AddedAttribute.GetDependencySourceTypes(SourceTypes);
+	RegisterAttributeDependencies(AttributeType, SourceTypes);
+
+	/** 新属性的加入可能改变依赖它的属性的当前值 */
+	const EFireflyAttributeType Roots[] = { AttributeType };
+	UpdateAttributesInDependencyOrder(Roots, false);
+}
+
+FFireflyStructAttribute* UFireflyAbilitySystemComponent::GetStructAttributeByType(EFireflyAttributeType AttributeType)
+{
+	if (AttributeType >= AttributeType_Max)
+	{
+		return nullptr;
+	}
+
+	const int16 AttributeIndex = StructAttributeLookupTable[AttributeType];
+	if (!StructAttributes.Items.IsValidIndex(AttributeIndex))
+	{
+		return nullptr;
+	}
+
+	return &StructAttributes.Items[AttributeIndex];
+}
+
+const FFireflyStructAttribute* UFireflyAbilitySystemComponent::GetStructAttributeByType(EFireflyAttributeType AttributeType) const
+{
+	return const_cast<UFireflyAbilitySystemComponent*>(this)->GetStructAttributeByType(AttributeType);
+}
+
+void UFireflyAbilitySystemComponent::RebuildStructAttributeLookupTable()
+{
+	for (int16& AttributeIndex : StructAttributeLookupTable)
+	{
+		AttributeIndex = INDEX_NONE;
+	}
+
+	for (int32 i = 0; i < StructAttributes.Items.Num(); ++i)
+	{
+		const EFireflyAttributeType AttributeType = StructAttributes.Items[i].AttributeType;
+		if (AttributeType < AttributeType_Max && StructAttributeLookupTable[AttributeType] == INDEX_NONE)
 		{
-			FIREFLY_ATTRIBUTE_MODIFIER_REMOVE(Plus);
+			StructAttributeLookupTable[AttributeType] = i;
 		}
-	case EFireflyAttributeModOperator::Minus:
+	}
+}
+
+void UFireflyAbilitySystemComponent::InitializeStructAttributeValue(FFireflyStructAttribute& Attribute, float InitValue)
+{
+	const float OldBaseValue = Attribute.BaseValue;
+	Attribute.BaseValue = InitValue;
+	if (Attribute.BaseValue != OldBaseValue)
+	{
+		StructAttributes.MarkItemDirty(Attribute);
+
+		/** 处于属性修改事务中时，基础值的变化由事务提交时统一广播 */
+		if (!IsInModifierTransaction())
 		{
-			FIREFLY_ATTRIBUTE_MODIFIER_REMOVE(Minus);
+			BroadcastAttributeBaseValueChanged(Attribute.AttributeType, Attribute.BaseValue, OldBaseValue);
 		}
-	case EFireflyAttributeModOperator::Multiply:
+	}
+
+	UpdateStructAttributeCurrentValue(Attribute);
+}
+
+void UFireflyAbilitySystemComponent::UpdateStructAttributeCurrentValue(FFireflyStructAttribute& Attribute)
+{
+	const float OldValue = Attribute.CurrentValue;
+
+	float OuterOverrideValue = 0.f;
+	if (Attribute.Modifiers.GetOuterOverrideValue(OuterOverrideValue))
+	{
+		Attribute.CurrentValue = OuterOverrideValue;
+	}
+	else
+	{
+		Attribute.Modifiers.VerifyAggregates(Attribute.AttributeType);
+		Attribute.CurrentValue = Attribute.ClampValue(Attribute.Modifiers.EvaluateCurrentValue(Attribute.BaseValue), this);
+	}
+
+	if (Attribute.CurrentValue == OldValue)
+	{
+		return;
+	}
+
+	StructAttributes.MarkItemDirty(Attribute);
+	BroadcastAttributeValueChanged(Attribute.AttributeType, Attribute.CurrentValue, OldValue);
+}
+
+void UFireflyAbilitySystemComponent::UpdateStructAttributeBaseValue(FFireflyStructAttribute& Attribute,
+	EFireflyAttributeModOperator ModOperator, float ModValue)
+{
+	if (Attribute.Modifiers.GetModifierCount(EFireflyAttributeModOperator::InnerOverride) != 0)
+	{
+		return;
+	}
+
+	const float OldValue = Attribute.BaseValue;
+	Attribute.BaseValue = Attribute.ClampValue(
+		FFireflyAttributeModifierContainer::ApplyModOperatorToValue(Attribute.BaseValue, ModOperator, ModValue), this);
+
+	if (Attribute.BaseValue == OldValue)
+	{
+		return;
+	}
+
+	StructAttributes.MarkItemDirty(Attribute);
+
+	/** 处于属性修改事务中时，基础值的变化由事务提交时统一广播 */
+	if (IsInModifierTransaction())
+	{
+		return;
+	}
+
+	BroadcastAttributeBaseValueChanged(Attribute.AttributeType, Attribute.BaseValue, OldValue);
+}
+
+void UFireflyAbilitySystemComponent::OnStructAttributeReplicated(FFireflyStructAttribute& Attribute, bool bAdded)
+{
+	if (bAdded)
+	{
+		RebuildStructAttributeLookupTable();
+	}
+
+	const float OldBaseValue = Attribute.ReplicatedBaseValue;
+	const float OldCurrentValue = Attribute.ReplicatedCurrentValue;
+	Attribute.ReplicatedBaseValue = Attribute.BaseValue;
+	Attribute.ReplicatedCurrentValue = Attribute.CurrentValue;
+
+	/** 处于属性修改事务中时，记录同步前的值，由事务提交时统一广播 */
+	if (IsInModifierTransaction())
+	{
+		MarkAttributeDirty(Attribute.AttributeType, OldBaseValue, OldCurrentValue);
+		return;
+	}
+
+	if (Attribute.BaseValue != OldBaseValue)
+	{
+		BroadcastAttributeBaseValueChanged(Attribute.AttributeType, Attribute.BaseValue, OldBaseValue);
+	}
+
+	if (Attribute.CurrentValue != OldCurrentValue)
+	{
+		BroadcastAttributeValueChanged(Attribute.AttributeType, Attribute.CurrentValue, OldCurrentValue);
+	}
+}
+
+void UFireflyAbilitySystemComponent::RegisterAttributeToStore(UFireflyAttribute* Attribute)
+{
+	if (!HasAuthority() || !Attribute->CanUseAttributeStore())
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	UFireflyAttributeStoreSubsystem* AttributeStore = World ? World->GetSubsystem<UFireflyAttributeStoreSubsystem>() : nullptr;
+	if (!AttributeStore)
+	{
+		return;
+	}
+
+	const int32 Slot = AttributeStore->RegisterAttribute(Attribute);
+	if (Slot == INDEX_NONE)
+	{
+		return;
+	}
+
+	Attribute->AttributeStore = AttributeStore;
+	Attribute->AttributeStoreSlot = Slot;
+	Attribute->WriteToAttributeStore();
+}
+
+void UFireflyAbilitySystemComponent::UnregisterAttributesFromStore()
+{
+	for (UFireflyAttribute* Attribute : AttributeContainer)
+	{
+		if (!IsValid(Attribute) || !Attribute->AttributeStore || Attribute->AttributeStoreSlot == INDEX_NONE)
 		{
-			FIREFLY_ATTRIBUTE_MODIFIER_REMOVE(Multiply);
+			continue;
 		}
-	case EFireflyAttributeModOperator::Divide:
+
+		Attribute->AttributeStore->UnregisterAttribute(Attribute->AttributeStoreSlot);
+		Attribute->AttributeStore = nullptr;
+		Attribute->AttributeStoreSlot = INDEX_NONE;
+	}
+}
+
+void UFireflyAbilitySystemComponent::OnAttributeStoreValuePublished(UFireflyAttribute* Attribute, float OldValue)
+{
+	BroadcastAttributeValueChanged(Attribute->AttributeType, Attribute->CurrentValue, OldValue);
+
+	const EFireflyAttributeType Roots[] = { Attribute->AttributeType };
+	UpdateAttributesInDependencyOrder(Roots, false);
+}
+
+template<typename FuncType>
+bool UFireflyAbilitySystemComponent::ForEachAttributeHistoryFrameAfter(double ServerTime, FuncType&& Func) const
+{
+	if (AttributeHistoryHead == INDEX_NONE)
+	{
+		return false;
+	}
+
+	int32 FrameIndex = AttributeHistoryHead;
+	for (int32 Visited = 0; Visited < AttributeHistoryFrameNum; ++Visited)
+	{
+		const FFireflyAttributeHistoryFrame& Frame = AttributeHistoryFrames[FrameIndex];
+		if (Frame.ServerTime <= ServerTime)
+		{
+			return true;
+		}
+
+		if (Frame.bOverflowed)
+		{
+			return false;
+		}
+
+		Func(&AttributeHistorySamples[FrameIndex * AttributeHistoryMaxChangesPerFrame], Frame.NumSamples);
+		FrameIndex = (FrameIndex + AttributeHistoryFrames.Num() - 1) % AttributeHistoryFrames.Num();
+	}
+
+	/** 环形缓冲未被写满时，最早的帧之前的属性值就是其记录的变化前的值 */
+	return AttributeHistoryFrameNum < AttributeHistoryFrames.Num();
+}
+
+bool UFireflyAbilitySystemComponent::GetAttributeValueAtTime(EFireflyAttributeType AttributeType, double ServerTime,
+	float& OutValue) const
+{
+	OutValue = GetLiveAttributeValue(AttributeType);
+
+	return ForEachAttributeHistoryFrameAfter(ServerTime, [&OutValue, AttributeType](const FFireflyAttributeHistorySample* Samples, int32 NumSamples)
+	{
+		for (int32 i = 0; i < NumSamples; ++i)
+		{
+			if (Samples[i].AttributeType == AttributeType)
+			{
+				OutValue = Samples[i].OldValue;
+				break;
+			}
+		}
+	});
+}
+
+bool UFireflyAbilitySystemComponent::RewindAttributesToTime(double ServerTime)
+{
+	RestoreRewoundAttributes();
+
+	const bool bSucceeded = ForEachAttributeHistoryFrameAfter(ServerTime, [this](const FFireflyAttributeHistorySample* Samples, int32 NumSamples)
+	{
+		for (int32 i = 0; i < NumSamples; ++i)
+		{
+			if (Samples[i].AttributeType >= AttributeType_Max)
+			{
+				continue;
+			}
+
+			RewoundAttributeMask[Samples[i].AttributeType] = true;
+			RewoundAttributeValues[Samples[i].AttributeType] = Samples[i].OldValue;
+		}
+	});
+
+	if (!bSucceeded)
+	{
+		RewoundAttributeMask = TStaticBitArray<AttributeType_Max>();
+		return false;
+	}
+
+	bIsAttributeRewound = true;
+
+	return true;
+}
+
+void UFireflyAbilitySystemComponent::RestoreRewoundAttributes()
+{
+	if (!bIsAttributeRewound)
+	{
+		return;
+	}
+
+	RewoundAttributeMask = TStaticBitArray<AttributeType_Max>();
+	bIsAttributeRewound = false;
+}
+
+void UFireflyAbilitySystemComponent::InitializeAttributeHistory()
+{
+	const UFireflyAbilitySystemSettings* Settings = UFireflyAbilitySystemSettings::Get();
+	if (!Settings->bEnableAttributeHistory || !HasAuthority())
+	{
+		return;
+	}
+
+	AttributeHistoryMaxChangesPerFrame = FMath::Max(Settings->AttributeHistoryMaxChangesPerFrame, 1);
+	AttributeHistoryFrames.SetNum(FMath::Max(Settings->AttributeHistoryFrameCount, 1));
+	AttributeHistorySamples.SetNum(AttributeHistoryFrames.Num() * AttributeHistoryMaxChangesPerFrame);
+	AttributeHistoryHead = 0;
+	AttributeHistoryFrameNum = 0;
+}
+
+void UFireflyAbilitySystemComponent::RecordAttributeHistory(EFireflyAttributeType AttributeType, float OldValue)
+{
+	/** 回滚只覆盖查询到的值，回滚期间的属性变化仍是服务端的真实变化，照常记录 */
+	FFireflyAttributeHistoryFrame* Frame = &AttributeHistoryFrames[AttributeHistoryHead];
+	if (AttributeHistoryFrameNum == 0 || Frame->FrameNumber != GFrameCounter)
+	{
+		if (AttributeHistoryFrameNum > 0)
+		{
+			AttributeHistoryHead = (AttributeHistoryHead + 1) % AttributeHistoryFrames.Num();
+		}
+		AttributeHistoryFrameNum = FMath::Min(AttributeHistoryFrameNum + 1, AttributeHistoryFrames.Num());
+
+		Frame = &AttributeHistoryFrames[AttributeHistoryHead];
+		Frame->ServerTime = GetWorld()->GetTimeSeconds();
+		Frame->FrameNumber = GFrameCounter;
+		Frame->NumSamples = 0;
+		Frame->bOverflowed = false;
+	}
+
+	FFireflyAttributeHistorySample* Samples = &AttributeHistorySamples[AttributeHistoryHead * AttributeHistoryMaxChangesPerFrame];
+	for (int32 i = 0; i < Frame->NumSamples; ++i)
+	{
+		if (Samples[i].AttributeType == AttributeType)
+		{
+			return;
+		}
+	}
+
+	if (Frame->NumSamples >= AttributeHistoryMaxChangesPerFrame)
+	{
+		Frame->bOverflowed = true;
+		return;
+	}
+
+	Samples[Frame->NumSamples].AttributeType = AttributeType;
+	Samples[Frame->NumSamples].OldValue = OldValue;
+	++Frame->NumSamples;
+}
+
+void UFireflyAbilitySystemComponent::RegisterAttributeDependencies(EFireflyAttributeType DependentType,
+	TArrayView<const EFireflyAttributeType> SourceTypes)
+{
+	if (DependentType >= AttributeType_Max || SourceTypes.Num() == 0)
+	{
+		return;
+	}
+
+	for (const EFireflyAttributeType SourceType : SourceTypes)
+	{
+		if (SourceType == DependentType || IsAttributeDependentOn(SourceType, DependentType))
+		{
+			UE_LOG(LogFireflyAttribute, Error, TEXT("UFireflyAbilitySystemComponent::RegisterAttributeDependencies() Attribute %s depending on %s forms a cycle, the dependency is ignored!"),
+				*UFireflyAbilitySystemLibrary::GetAttributeTypeName(DependentType), *UFireflyAbilitySystemLibrary::GetAttributeTypeName(SourceType));
+			continue;
+		}
+
+		AttributeDependents.FindOrAdd(SourceType).AddUnique(DependentType);
+	}
+
+	RebuildAttributeTopologicalRanks();
+}
+
+bool UFireflyAbilitySystemComponent::IsAttributeDependentOn(EFireflyAttributeType DependentType,
+	EFireflyAttributeType SourceType) const
+{
+	bool bVisited[AttributeType_Max] = {};
+	TArray<EFireflyAttributeType, TInlineAllocator<16>> TypesToVisit;
+	TypesToVisit.Push(SourceType);
+
+	while (TypesToVisit.Num() > 0)
+	{
+		const EFireflyAttributeType CurrentType = TypesToVisit.Pop(false);
+		const TArray<EFireflyAttributeType>* Dependents = AttributeDependents.Find(CurrentType);
+		if (!Dependents)
+		{
+			continue;
+		}
+
+		for (const EFireflyAttributeType Dependent : *Dependents)
+		{
+			if (Dependent == DependentType)
+			{
+				return true;
+			}
+
+			if (!bVisited[Dependent])
+			{
+				bVisited[Dependent] = true;
+				TypesToVisit.Push(Dependent);
+			}
+		}
+	}
+
+	return false;
+}
+
+void UFireflyAbilitySystemComponent::RebuildAttributeTopologicalRanks()
+{
+	FMemory::Memzero(AttributeTopologicalRanks);
+
+	/** 依赖图无环，最多松弛AttributeType_Max轮即可收敛 */
+	bool bRankChanged = true;
+	for (int32 Pass = 0; bRankChanged && Pass < AttributeType_Max; ++Pass)
+	{
+		bRankChanged = false;
+		for (const TPair<EFireflyAttributeType, TArray<EFireflyAttributeType>>& Pair : AttributeDependents)
+		{
+			const uint8 MinDependentRank = AttributeTopologicalRanks[Pair.Key] + 1;
+			for (const EFireflyAttributeType Dependent : Pair.Value)
+			{
+				if (AttributeTopologicalRanks[Dependent] < MinDependentRank)
+				{
+					AttributeTopologicalRanks[Dependent] = MinDependentRank;
+					bRankChanged = true;
+				}
+			}
+		}
+	}
+}
+
+void UFireflyAbilitySystemComponent::UpdateAttributesInDependencyOrder(TArrayView<const EFireflyAttributeType> RootTypes,
+	bool bIncludeRoots)
+{
+	bool bVisited[AttributeType_Max] = {};
+	TArray<EFireflyAttributeType, TInlineAllocator<16>> TypesToUpdate;
+	TArray<EFireflyAttributeType, TInlineAllocator<16>> TypesToVisit;
+
+	for (const EFireflyAttributeType RootType : RootTypes)
+	{
+		if (RootType >= AttributeType_Max || bVisited[RootType])
+		{
+			continue;
+		}
+
+		bVisited[RootType] = true;
+		TypesToVisit.Push(RootType);
+		if (bIncludeRoots)
 		{
-			FIREFLY_ATTRIBUTE_MODIFIER_REMOVE(Divide);
+			TypesToUpdate.Add(RootType);
 		}
-	case EFireflyAttributeModOperator::InnerOverride:
-		{
-			FIREFLY_ATTRIBUTE_MODIFIER_REMOVE(InnerOverride);
 	}
-	case EFireflyAttributeModOperator::OuterOverride:
+
+	/** 收集所有直接或间接依赖于根属性的属性 */
+	if (AttributeDependents.Num() > 0)
+	{
+		while (TypesToVisit.Num() > 0)
 		{
-			FIREFLY_ATTRIBUTE_MODIFIER_REMOVE(OuterOverride);
+			const TArray<EFireflyAttributeType>* Dependents = AttributeDependents.Find(TypesToVisit.Pop(false));
+			if (!Dependents)
+			{
+				continue;
+			}
+
+			for (const EFireflyAttributeType Dependent : *Dependents)
+			{
+				if (bVisited[Dependent])
+				{
+					continue;
+				}
+
+				bVisited[Dependent] = true;
+				TypesToVisit.Push(Dependent);
+				TypesToUpdate.Add(Dependent);
+			}
 		}
 	}
 
-	AttributeToMod->UpdateCurrentValue();
+	if (TypesToUpdate.Num() > 1)
+	{
+		TypesToUpdate.StableSort([this](const EFireflyAttributeType A, const EFireflyAttributeType B)
+		{
+			return AttributeTopologicalRanks[A] < AttributeTopologicalRanks[B];
+		});
+	}
+
+	for (const EFireflyAttributeType AttributeType : TypesToUpdate)
+	{
+		UpdateAttributeCurrentValueByType(AttributeType);
+	}
+}
+
+void UFireflyAbilitySystemComponent::PreModiferApplied(EFireflyAttributeType AttributeType,
+	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply)
+{
+}
+
+void UFireflyAbilitySystemComponent::PostModiferApplied(EFireflyAttributeType AttributeType,
+	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply)
+{
+}
+
+void UFireflyAbilitySystemComponent::ApplyModifierToAttribute(EFireflyAttributeType AttributeType,
+	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply)
+{
+	if (!HasAuthority() || !IsValid(ModSource) || ModOperator == EFireflyAttributeModOperator::None)
+	{
+		return;
+	}
+
+	FFireflyAttributeModifierContainer* Modifiers = GetAttributeModifiers(AttributeType);
+	if (!Modifiers)
+	{
+		return;
+	}
+
+	// 来源和值都相同的修改器已存在时，仅重设其堆叠数
+	const int32 SlotIndex = Modifiers->FindModifier(ModOperator, ModSource, ModValue);
+	if (SlotIndex == INDEX_NONE)
+	{
+		Modifiers->AddModifier(ModOperator, ModSource, ModValue, StackToApply);
+	}
+	else
+	{
+		Modifiers->SetModifierStackAt(SlotIndex, StackToApply);
+	}
+
+	PreModiferApplied(AttributeType, ModOperator, ModSource, ModValue, StackToApply);
+
+	RefreshAttributeCurrentValue(AttributeType);
+
+	PostModiferApplied(AttributeType, ModOperator, ModSource, ModValue, StackToApply);
+}
+
+FFireflyModifierHandle UFireflyAbilitySystemComponent::ApplyModifierToAttributeWithHandle(EFireflyAttributeType AttributeType,
+	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply)
+{
+	if (!HasAuthority() || !IsValid(ModSource) || ModOperator == EFireflyAttributeModOperator::None)
+	{
+		return FFireflyModifierHandle();
+	}
+
+	FFireflyAttributeModifierContainer* Modifiers = GetAttributeModifiers(AttributeType);
+	if (!Modifiers)
+	{
+		return FFireflyModifierHandle();
+	}
+
+	// 每次应用都占用一个新的槽位，来源和值相同的修改器也各自拥有独立的句柄
+	const int32 SlotIndex = Modifiers->AddModifier(ModOperator, ModSource, ModValue, StackToApply);
+	const FFireflyModifierHandle ModifierHandle = Modifiers->MakeModifierHandle(AttributeType, SlotIndex);
+
+	PreModiferApplied(AttributeType, ModOperator, ModSource, ModValue, StackToApply);
+
+	RefreshAttributeCurrentValue(AttributeType);
+
+	PostModiferApplied(AttributeType, ModOperator, ModSource, ModValue, StackToApply);
+
+	return ModifierHandle;
 }
 
-#define FIREFLY_ATTRIBUTE_MODIFIER_ACTIVE_STATE_SHIFTER(ModOperatorName) \
-	{ \
-		for (auto& Modifier : AttributeToMod->##ModOperatorName##Mods) \
-		{ \
-			if (Modifier.ModSource == ModSource && Modifier.ModValue == ModValue) \
-			{ \
-				Modifier.bIsActive = bNewActiveState; \
-				break; \
-			} \
-		} \
-		break; \
+void UFireflyAbilitySystemComponent::RemoveModifierFromAttribute(EFireflyAttributeType AttributeType,
+	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue)
+{
+	if (!HasAuthority() || !IsValid(ModSource))
+	{
+		return;
+	}
+
+	FFireflyAttributeModifierContainer* Modifiers = GetAttributeModifiers(AttributeType);
+	if (!Modifiers)
+	{
+		return;
 	}
 
+	Modifiers->RemoveModifierAt(Modifiers->FindModifier(ModOperator, ModSource, ModValue));
+
+	RefreshAttributeCurrentValue(AttributeType);
+}
+
 void UFireflyAbilitySystemComponent::ShiftModifierActiveState(EFireflyAttributeType AttributeType,
 	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, bool bNewActiveState)
 {
@@ -1056,54 +1961,121 @@ void UFireflyAbilitySystemComponent::ShiftModifierActiveState(EFireflyAttributeT
 		return;
 	}
 
-	UFireflyAttribute* AttributeToMod = GetAttributeByType(AttributeType);
-	if (!IsValid(AttributeToMod))
+	FFireflyAttributeModifierContainer* Modifiers = GetAttributeModifiers(AttributeType);
+	if (!Modifiers)
 	{
 		return;
 	}
 
-	switch (ModOperator)
+	Modifiers->SetModifierActiveAt(Modifiers->FindModifier(ModOperator, ModSource, ModValue), bNewActiveState);
+
+	RefreshAttributeCurrentValue(AttributeType);
+}
+
+void UFireflyAbilitySystemComponent::RemoveModifierByHandle(const FFireflyModifierHandle& ModifierHandle)
+{
+	if (!HasAuthority() || !ModifierHandle.IsValid())
 	{
-	case EFireflyAttributeModOperator::None:
+		return;
+	}
+
+	FFireflyAttributeModifierContainer* Modifiers = GetAttributeModifiers(ModifierHandle.AttributeType);
+	if (!Modifiers || !Modifiers->IsModifierHandleValid(ModifierHandle))
 	{
-		break;
+		return;
 	}
-	case EFireflyAttributeModOperator::Plus:
+
+	Modifiers->RemoveModifierAt(ModifierHandle.SlotIndex);
+
+	RefreshAttributeCurrentValue(ModifierHandle.AttributeType);
+}
+
+void UFireflyAbilitySystemComponent::SetModifierStackByHandle(const FFireflyModifierHandle& ModifierHandle,
+	int32 NewStackCount)
+{
+	if (!HasAuthority() || !ModifierHandle.IsValid())
 	{
-		FIREFLY_ATTRIBUTE_MODIFIER_ACTIVE_STATE_SHIFTER(Plus);
+		return;
 	}
-	case EFireflyAttributeModOperator::Minus:
+
+	FFireflyAttributeModifierContainer* Modifiers = GetAttributeModifiers(ModifierHandle.AttributeType);
+	if (!Modifiers || !Modifiers->IsModifierHandleValid(ModifierHandle))
 	{
-		FIREFLY_ATTRIBUTE_MODIFIER_ACTIVE_STATE_SHIFTER(Minus);
+		return;
 	}
-	case EFireflyAttributeModOperator::Multiply:
+
+	Modifiers->SetModifierStackAt(ModifierHandle.SlotIndex, NewStackCount);
+
+	RefreshAttributeCurrentValue(ModifierHandle.AttributeType);
+}
+
+void UFireflyAbilitySystemComponent::ResetModifierByHandle(const FFireflyModifierHandle& ModifierHandle,
+	float NewModValue, int32 NewStackCount)
+{
+	if (!HasAuthority() || !ModifierHandle.IsValid())
 	{
-		FIREFLY_ATTRIBUTE_MODIFIER_ACTIVE_STATE_SHIFTER(Multiply);
+		return;
 	}
-	case EFireflyAttributeModOperator::Divide:
+
+	FFireflyAttributeModifierContainer* Modifiers = GetAttributeModifiers(ModifierHandle.AttributeType);
+	if (!Modifiers || !Modifiers->IsModifierHandleValid(ModifierHandle))
 	{
-		FIREFLY_ATTRIBUTE_MODIFIER_ACTIVE_STATE_SHIFTER(Divide);
+		return;
 	}
-	case EFireflyAttributeModOperator::InnerOverride:
+
+	Modifiers->SetModifierValueAt(ModifierHandle.SlotIndex, NewModValue, NewStackCount);
+
+	RefreshAttributeCurrentValue(ModifierHandle.AttributeType);
+}
+
+void UFireflyAbilitySystemComponent::ShiftModifierActiveStateByHandle(const FFireflyModifierHandle& ModifierHandle,
+	bool bNewActiveState)
+{
+	if (!HasAuthority() || !ModifierHandle.IsValid())
 	{
-		FIREFLY_ATTRIBUTE_MODIFIER_ACTIVE_STATE_SHIFTER(InnerOverride);
+		return;
 	}
-	case EFireflyAttributeModOperator::OuterOverride:
+
+	FFireflyAttributeModifierContainer* Modifiers = GetAttributeModifiers(ModifierHandle.AttributeType);
+	if (!Modifiers || !Modifiers->IsModifierHandleValid(ModifierHandle))
 	{
-		FIREFLY_ATTRIBUTE_MODIFIER_ACTIVE_STATE_SHIFTER(OuterOverride);
+		return;
 	}
+
+	Modifiers->SetModifierActiveAt(ModifierHandle.SlotIndex, bNewActiveState);
+
+	RefreshAttributeCurrentValue(ModifierHandle.AttributeType);
+}
+
+bool UFireflyAbilitySystemComponent::IsModifierHandleValid(const FFireflyModifierHandle& ModifierHandle) const
+{
+	if (!ModifierHandle.IsValid())
+	{
+		return false;
 	}
+
+	const FFireflyAttributeModifierContainer* Modifiers =
+		const_cast<UFireflyAbilitySystemComponent*>(this)->GetAttributeModifiers(ModifierHandle.AttributeType);
+
+	return Modifiers && Modifiers->IsModifierHandleValid(ModifierHandle);
 }
 
 bool UFireflyAbilitySystemComponent::CanApplyModifierInstant(EFireflyAttributeType AttributeType,
                                                              EFireflyAttributeModOperator ModOperator, float ModValue) const
 {
+	const FFireflyStructAttribute* StructAttribute = GetStructAttributeByType(AttributeType);
 	UFireflyAttribute* AttributeToMod = GetAttributeByType(AttributeType);
-	if (!IsValid(AttributeToMod))
+	if (!StructAttribute && !IsValid(AttributeToMod))
 	{
 		return false;
 	}
 
+	auto IsValueInAttributeRange = [this, StructAttribute, AttributeToMod](float InValue)
+	{
+		return StructAttribute ? StructAttribute->IsValueInAttributeRange(InValue, this) : AttributeToMod->IsValueInAttributeRange(InValue);
+	};
+	const float BaseValueToUse = GetAttributeBaseValue(AttributeType);
+
 	bool bResult = true;
 	switch (ModOperator)
 	{
@@ -1118,7 +2090,7 @@ bool UFireflyAbilitySystemComponent::CanApplyModifierInstant(EFireflyAttributeTy
 		}
 	case EFireflyAttributeModOperator::Minus:
 		{
-			bResult = AttributeToMod->IsValueInAttributeRange(AttributeToMod->GetBaseValueToUse() - ModValue);
+			bResult = IsValueInAttributeRange(BaseValueToUse - ModValue);
 			break;
 		}
 	case EFireflyAttributeModOperator::Divide:
@@ -1128,178 +2100,532 @@ bool UFireflyAbilitySystemComponent::CanApplyModifierInstant(EFireflyAttributeTy
 				break;
 			}
 
-			bResult = AttributeToMod->IsValueInAttributeRange(AttributeToMod->GetBaseValueToUse() / ModValue);
+			bResult = IsValueInAttributeRange(BaseValueToUse / ModValue);
 			break;
 		}
 	case EFireflyAttributeModOperator::InnerOverride:
 	case EFireflyAttributeModOperator::OuterOverride:
 		{
-			bResult = AttributeToMod->IsValueInAttributeRange(AttributeToMod->GetBaseValueToUse());
+			bResult = IsValueInAttributeRange(BaseValueToUse);
 			break;
 		}
 	}
 
-	return bResult;
+	return bResult;
+}
+
+void UFireflyAbilitySystemComponent::ApplyModifierToAttributeInstant(EFireflyAttributeType AttributeType,
+	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue)
+{
+	if (!HasAuthority() || !IsValid(ModSource))
+	{
+		return;
+	}
+
+	if (!GetAttributeModifiers(AttributeType))
+	{
+		return;
+	}
+
+	PreModiferApplied(AttributeType, ModOperator, ModSource, ModValue, 1);
+
+	if (IsInModifierTransaction())
+	{
+		MarkAttributeDirty(AttributeType);
+	}
+
+	UpdateAttributeBaseValueByType(AttributeType, ModOperator, ModValue);
+	RefreshAttributeCurrentValue(AttributeType);
+
+	PostModiferApplied(AttributeType, ModOperator, ModSource, ModValue, 1);
+}
+
+void UFireflyAbilitySystemComponent::ApplyOrResetModifierToAttribute(EFireflyAttributeType AttributeType,
+	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply)
+{
+	if (!HasAuthority() || !IsValid(ModSource) || ModOperator == EFireflyAttributeModOperator::None)
+	{
+		return;
+	}
+
+	FFireflyAttributeModifierContainer* Modifiers = GetAttributeModifiers(AttributeType);
+	if (!Modifiers)
+	{
+		return;
+	}
+
+	const int32 SlotIndex = Modifiers->FindModifierBySource(ModOperator, ModSource);
+	if (SlotIndex == INDEX_NONE)
+	{
+		Modifiers->AddModifier(ModOperator, ModSource, ModValue, StackToApply);
+	}
+	else
+	{
+		Modifiers->SetModifierValueAt(SlotIndex, ModValue, StackToApply);
+	}
+
+	PreModiferApplied(AttributeType, ModOperator, ModSource, ModValue, StackToApply);
+
+	RefreshAttributeCurrentValue(AttributeType);
+
+	PostModiferApplied(AttributeType, ModOperator, ModSource, ModValue, StackToApply);
+}
+
+bool UFireflyAbilitySystemComponent::CanApplyModifiersInstant(
+	TArrayView<const FFireflyEffectModifierData> ModifiersToApply) const
+{
+	TArray<FFireflyProjectedAttribute, TInlineAllocator<8>> Projections;
+	TArray<float, TInlineAllocator<8>> ModValues;
+	return ProjectModifiersInstant(ModifiersToApply, Projections, ModValues);
+}
+
+bool UFireflyAbilitySystemComponent::TryApplyModifiersInstant(
+	TArrayView<const FFireflyEffectModifierData> ModifiersToApply, UObject* ModSource)
+{
+	if (!HasAuthority() || !IsValid(ModSource))
+	{
+		return false;
+	}
+
+	TArray<FFireflyProjectedAttribute, TInlineAllocator<8>> Projections;
+	TArray<float, TInlineAllocator<8>> ModValues;
+	if (!ProjectModifiersInstant(ModifiersToApply, Projections, ModValues))
+	{
+		return false;
+	}
+
+	/** 所有修改器在同一个事务中应用，每个属性只广播一次，应用时使用检验时解析的修改值 */
+	BeginModifierTransaction();
+
+	for (int32 i = 0; i < ModifiersToApply.Num(); ++i)
+	{
+		const FFireflyEffectModifierData& Modifier = ModifiersToApply[i];
+		const float ModValue = ModValues[i];
+		const FFireflyProjectedAttribute* Projection = Projections.FindByPredicate([&Modifier](const FFireflyProjectedAttribute& Item)
+		{
+			return Item.AttributeType == Modifier.AttributeType;
+		});
+
+		PreModiferApplied(Modifier.AttributeType, Modifier.ModOperator, ModSource, ModValue, 1);
+
+		MarkAttributeDirty(Modifier.AttributeType);
+		if (Projection->StructAttribute)
+		{
+			UpdateStructAttributeBaseValue(*Projection->StructAttribute, Modifier.ModOperator, ModValue);
+		}
+		else
+		{
+			Projection->Attribute->UpdateBaseValue(Modifier.ModOperator, ModValue);
+		}
+		RefreshAttributeCurrentValue(Modifier.AttributeType);
+
+		PostModiferApplied(Modifier.AttributeType, Modifier.ModOperator, ModSource, ModValue, 1);
+	}
+
+	CommitModifierTransaction();
+
+	return true;
+}
+
+float UFireflyAbilitySystemComponent::ResolveModifierValueInstant(const FFireflyEffectModifierData& Modifier) const
+{
+	switch (Modifier.ModValueMethod)
+	{
+	case EFireflyEffectModifierValueMethod::UsingAttribute:
+		return GetLiveAttributeValue(Modifier.AttributeTypeUsing);
+	case EFireflyEffectModifierValueMethod::CustomCalculator:
+		{
+			/** 计算器使用共享实例，以正在执行的效果类型的默认对象作为计算的上下文，不创建效果实例 */
+			UFireflyEffectModifierCalculator* Calculator = Modifier.CalculatorInstance;
+			if (!IsValid(Calculator))
+			{
+				Calculator = const_cast<UFireflyAbilitySystemComponent*>(this)->GetModifierCalculator(Modifier.CalculatorClass);
+			}
+
+			if (!IsValid(Calculator))
+			{
+				return Modifier.ModValue;
+			}
+
+			UFireflyEffect* EffectContext = ExecutingEffectSpec ? ExecutingEffectSpec->EffectCDO : GetMutableDefault<UFireflyEffect>();
+			return Calculator->Calculate(EffectContext, Modifier.ModValue);
+		}
+	default:
+		return Modifier.ModValue;
+	}
+}
+
+bool UFireflyAbilitySystemComponent::ProjectModifiersInstant(
+	TArrayView<const FFireflyEffectModifierData> ModifiersToApply,
+	TArray<FFireflyProjectedAttribute, TInlineAllocator<8>>& OutProjections,
+	TArray<float, TInlineAllocator<8>>& OutModValues) const
+{
+	UFireflyAbilitySystemComponent* MutableThis = const_cast<UFireflyAbilitySystemComponent*>(this);
+
+	/** 所有修改值在任何修改器应用之前解析，检验与应用使用同一组修改值 */
+	OutModValues.Reset(ModifiersToApply.Num());
+	for (const FFireflyEffectModifierData& Modifier : ModifiersToApply)
+	{
+		OutModValues.Add(ResolveModifierValueInstant(Modifier));
+	}
+
+	for (int32 i = 0; i < ModifiersToApply.Num(); ++i)
+	{
+		const FFireflyEffectModifierData& Modifier = ModifiersToApply[i];
+		const float ModValue = OutModValues[i];
+		if (Modifier.ModOperator == EFireflyAttributeModOperator::None)
+		{
+			return false;
+		}
+
+		FFireflyProjectedAttribute* Projection = OutProjections.FindByPredicate([&Modifier](const FFireflyProjectedAttribute& Item)
+		{
+			return Item.AttributeType == Modifier.AttributeType;
+		});
+
+		if (!Projection)
+		{
+			FFireflyProjectedAttribute NewProjection;
+			NewProjection.AttributeType = Modifier.AttributeType;
+			NewProjection.StructAttribute = MutableThis->GetStructAttributeByType(Modifier.AttributeType);
+			NewProjection.Attribute = NewProjection.StructAttribute ? nullptr : GetAttributeByType(Modifier.AttributeType);
+			if (!NewProjection.StructAttribute && !IsValid(NewProjection.Attribute))
+			{
+				return false;
+			}
+
+			NewProjection.ProjectedBaseValue = NewProjection.StructAttribute ? NewProjection.StructAttribute->GetBaseValueToUse()
+				: NewProjection.Attribute->GetBaseValueToUse();
+			Projection = &OutProjections.Add_GetRef(NewProjection);
+		}
+
+		auto IsValueInAttributeRange = [this, Projection](float InValue)
+		{
+			return Projection->StructAttribute ? Projection->StructAttribute->IsValueInAttributeRange(InValue, this)
+				: Projection->Attribute->IsValueInAttributeRange(InValue);
+		};
+
+		/** 与CanApplyModifierInstant的检验规则一致，但以同一属性上之前的修改器累计后的基础值为准 */
+		switch (Modifier.ModOperator)
+		{
+		case EFireflyAttributeModOperator::Minus:
+			{
+				if (!IsValueInAttributeRange(Projection->ProjectedBaseValue - ModValue))
+				{
+					return false;
+				}
+				break;
+			}
+		case EFireflyAttributeModOperator::Divide:
+			{
+				if (ModValue != 0.f && !IsValueInAttributeRange(Projection->ProjectedBaseValue / ModValue))
+				{
+					return false;
+				}
+				break;
+			}
+		case EFireflyAttributeModOperator::InnerOverride:
+		case EFireflyAttributeModOperator::OuterOverride:
+			{
+				if (!IsValueInAttributeRange(Projection->ProjectedBaseValue))
+				{
+					return false;
+				}
+				break;
+			}
+		default:
+			{
+				break;
+			}
+		}
+
+		Projection->ProjectedBaseValue = FFireflyAttributeModifierContainer::ApplyModOperatorToValue(
+			Projection->ProjectedBaseValue, Modifier.ModOperator, ModValue);
+	}
+
+	return true;
 }
 
-void UFireflyAbilitySystemComponent::ApplyModifierToAttributeInstant(EFireflyAttributeType AttributeType,
-	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue)
+void UFireflyAbilitySystemComponent::BeginModifierTransaction()
 {
-	if (!HasAuthority() || !IsValid(ModSource))
+	++ModifierTransactionDepth;
+}
+
+void UFireflyAbilitySystemComponent::CommitModifierTransaction()
+{
+	if (ModifierTransactionDepth <= 0)
 	{
+		UE_LOG(LogFireflyAttribute, Error, TEXT("UFireflyAbilitySystemComponent::CommitModifierTransaction() Modifier transaction of %s is committed without being begun, BeginModifierTransaction and CommitModifierTransaction are unbalanced!"),
+			*GetNameSafe(GetOwner()));
 		return;
 	}
 
-	UFireflyAttribute* AttributeToMod = GetAttributeByType(AttributeType);
-	if (!IsValid(AttributeToMod))
+	if (ModifierTransactionDepth > 1)
 	{
+		--ModifierTransactionDepth;
 		return;
 	}
 
-	PreModiferApplied(AttributeType, ModOperator, ModSource, ModValue, 1);
+	CloseModifierTransaction();
+}
+
+void UFireflyAbilitySystemComponent::CloseModifierTransaction()
+{
+	/** 仍处于事务中时重新计算，计算引起的当前值变化被记录为脏属性，与其他变化一起广播 */
+	RecomputePendingAttributes();
 
-	AttributeToMod->UpdateBaseValue(ModOperator, ModValue);
-	AttributeToMod->UpdateCurrentValue();
+	ModifierTransactionDepth = 0;
+	FlushDirtyAttributes();
+}
 
-	PostModiferApplied(AttributeType, ModOperator, ModSource, ModValue, 1);
+void UFireflyAbilitySystemComponent::CloseUnbalancedModifierTransactions()
+{
+	UE_LOG(LogFireflyAttribute, Error, TEXT("UFireflyAbilitySystemComponent::CloseUnbalancedModifierTransactions() Modifier transaction of %s was not committed before end of frame, BeginModifierTransaction and CommitModifierTransaction are unbalanced! %d unclosed transactions are committed."),
+		*GetNameSafe(GetOwner()), ModifierTransactionDepth);
+
+	CloseModifierTransaction();
+}
+
+void UFireflyAbilitySystemComponent::MarkAttributeDirty(EFireflyAttributeType AttributeType)
+{
+	MarkAttributeDirty(AttributeType, GetAttributeRawBaseValue(AttributeType), GetAttributeRawCurrentValue(AttributeType));
 }
 
-#define FIREFLY_ATTRIBUTE_MODIFIER_APPLY_OVERRIDE(ModOperatorName) \
-	{ \
-		bool bContainsModifier = false; \
-		for (FFireflyAttributeModifier& Modifier : AttributeToMod->##ModOperatorName##Mods) \
-		{ \
-			if (Modifier.ModSource == ModSource) \
-			{ \
-				bContainsModifier = true; \
-				Modifier.ModValue = ModValue; \
-				Modifier.StackCount = StackToApply; \
-				break; \
-			} \
-		} \
-		if (!bContainsModifier) \
-		{ \
-			AttributeToMod->##ModOperatorName##Mods.AddUnique(FFireflyAttributeModifier(ModSource, ModValue, StackToApply)); \
-		} \
-		break; \
+void UFireflyAbilitySystemComponent::MarkAttributeDirty(EFireflyAttributeType AttributeType, float OldBaseValue,
+	float OldCurrentValue)
+{
+	for (const FFireflyDirtyAttribute& DirtyAttribute : DirtyAttributes)
+	{
+		if (DirtyAttribute.AttributeType == AttributeType)
+		{
+			return;
+		}
 	}
 
-void UFireflyAbilitySystemComponent::ApplyOrResetModifierToAttribute(EFireflyAttributeType AttributeType,
-	EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply)
+	DirtyAttributes.Emplace(FFireflyDirtyAttribute(AttributeType, OldBaseValue, OldCurrentValue));
+}
+
+void UFireflyAbilitySystemComponent::RefreshAttributeCurrentValue(EFireflyAttributeType AttributeType)
 {
-	if (!HasAuthority() || !IsValid(ModSource))
+	/** 事务中只标记属性，同一属性被多个修改器修改时只在提交时重新计算一次 */
+	if (IsInModifierTransaction() && AttributeType < AttributeType_Max)
 	{
+		MarkAttributeDirty(AttributeType);
+		PendingRecomputeAttributes.AddUnique(AttributeType);
+		MarkAttributeStale(AttributeType);
 		return;
 	}
 
-	UFireflyAttribute* AttributeToMod = GetAttributeByType(AttributeType);
-	if (!IsValid(AttributeToMod))
+	const EFireflyAttributeType Roots[] = { AttributeType };
+	UpdateAttributesInDependencyOrder(Roots);
+}
+
+void UFireflyAbilitySystemComponent::MarkAttributeStale(EFireflyAttributeType AttributeType)
+{
+	/** 已过期的属性的依赖者也都已过期 */
+	if (StaleAttributeMask[AttributeType])
 	{
 		return;
 	}
 
-	switch (ModOperator)
+	StaleAttributeMask[AttributeType] = true;
+	if (const TArray<EFireflyAttributeType>* Dependents = AttributeDependents.Find(AttributeType))
 	{
-	case EFireflyAttributeModOperator::None:
-		{
-			break;
-		}
-	case EFireflyAttributeModOperator::Plus:
+		for (const EFireflyAttributeType DependentType : *Dependents)
 		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY_OVERRIDE(Plus);
+			MarkAttributeStale(DependentType);
 		}
-	case EFireflyAttributeModOperator::Minus:
-		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY_OVERRIDE(Minus);
-		}
-	case EFireflyAttributeModOperator::Multiply:
-		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY_OVERRIDE(Multiply);
-		}
-	case EFireflyAttributeModOperator::Divide:
+	}
+}
+
+void UFireflyAbilitySystemComponent::RecomputePendingAttributes()
+{
+	if (PendingRecomputeAttributes.Num() == 0)
+	{
+		return;
+	}
+
+	/** 先清除过期标记，按拓扑顺序计算时读取的源属性总是已被先行计算 */
+	const TArray<EFireflyAttributeType, TInlineAllocator<8>> RootTypes = MoveTemp(PendingRecomputeAttributes);
+	PendingRecomputeAttributes.Reset();
+	StaleAttributeMask = TStaticBitArray<AttributeType_Max>();
+
+	UpdateAttributesInDependencyOrder(RootTypes);
+}
+
+void UFireflyAbilitySystemComponent::FlushDirtyAttributes()
+{
+	/** 属性值变化的回调中可能再次修改属性，先转移脏属性列表 */
+	TArray<FFireflyDirtyAttribute> AttributesToBroadcast = MoveTemp(DirtyAttributes);
+	DirtyAttributes.Reset();
+
+	for (const FFireflyDirtyAttribute& DirtyAttribute : AttributesToBroadcast)
+	{
+		const float NewBaseValue = GetAttributeRawBaseValue(DirtyAttribute.AttributeType);
+		if (NewBaseValue != DirtyAttribute.OldBaseValue)
 		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY_OVERRIDE(Divide);
+			BroadcastAttributeBaseValueChanged(DirtyAttribute.AttributeType, NewBaseValue, DirtyAttribute.OldBaseValue);
 		}
-	case EFireflyAttributeModOperator::InnerOverride:
+
+		/** 托管到世界属性存储的属性，当前值的变化由存储发布时广播 */
+		const UFireflyAttribute* Attribute = GetAttributeByType(DirtyAttribute.AttributeType);
+		if (IsValid(Attribute) && Attribute->AttributeStoreSlot != INDEX_NONE)
 		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY_OVERRIDE(InnerOverride);
+			continue;
 		}
-	case EFireflyAttributeModOperator::OuterOverride:
+
+		const float NewCurrentValue = GetAttributeRawCurrentValue(DirtyAttribute.AttributeType);
+		if (NewCurrentValue != DirtyAttribute.OldCurrentValue)
 		{
-			FIREFLY_ATTRIBUTE_MODIFIER_APPLY_OVERRIDE(OuterOverride);
+			BroadcastAttributeValueChanged(DirtyAttribute.AttributeType, NewCurrentValue, DirtyAttribute.OldCurrentValue);
 		}
 	}
+}
 
-	PreModiferApplied(AttributeType, ModOperator, ModSource, ModValue, StackToApply);
+TArray<UFireflyEffect*> UFireflyAbilitySystemComponent::GetActiveEffectsByID(FName EffectID) const
+{
+	return TArray<UFireflyEffect*>(GetActiveEffectsViewByID(EffectID));
+}
 
-	AttributeToMod->UpdateCurrentValue();
+TArray<UFireflyEffect*> UFireflyAbilitySystemComponent::GetActiveEffectsByClass(
+	TSubclassOf<UFireflyEffect> EffectType) const
+{
+	return TArray<UFireflyEffect*>(GetActiveEffectsViewByClass(EffectType));
+}
 
-	PostModiferApplied(AttributeType, ModOperator, ModSource, ModValue, StackToApply);
+TArray<UFireflyEffect*> UFireflyAbilitySystemComponent::GetActiveEffectsByTag(
+	FGameplayTagContainer EffectAssetTags) const
+{
+	TArray<UFireflyEffect*> OutEffects = TArray<UFireflyEffect*>{};
+	ForEachActiveEffectWithTags(EffectAssetTags, [&OutEffects](UFireflyEffect* Effect)
+	{
+		OutEffects.Emplace(Effect);
+	});
+
+	return OutEffects;
 }
 
-TArray<UFireflyEffect*> UFireflyAbilitySystemComponent::GetActiveEffectsByID(FName EffectID) const
+TArrayView<UFireflyEffect* const> UFireflyAbilitySystemComponent::GetActiveEffectsViewByID(FName EffectID) const
 {
 	if (EffectID == NAME_None)
 	{
-		return TArray<UFireflyEffect*>{};
+		return TArrayView<UFireflyEffect* const>();
 	}
 
-	TArray<UFireflyEffect*>  Effects;
-	for (UFireflyEffect* Effect : ActiveEffects)
-	{
-		if (Effect->EffectID == EffectID)
-		{
-			Effects.Emplace(Effect);
-		}
-	}
+	const TArray<UFireflyEffect*>* Effects = ActiveEffectsByID.Find(EffectID);
 
-	return Effects;
+	return Effects ? TArrayView<UFireflyEffect* const>(*Effects) : TArrayView<UFireflyEffect* const>();
 }
 
-TArray<UFireflyEffect*> UFireflyAbilitySystemComponent::GetActiveEffectsByClass(
+TArrayView<UFireflyEffect* const> UFireflyAbilitySystemComponent::GetActiveEffectsViewByClass(
 	TSubclassOf<UFireflyEffect> EffectType) const
 {
-	TArray<UFireflyEffect*> OutEffects = TArray<UFireflyEffect*>{};
-	for (auto Effect : ActiveEffects)
+	const TArray<UFireflyEffect*>* Effects = ActiveEffectsByClass.Find(EffectType);
+
+	return Effects ? TArrayView<UFireflyEffect* const>(*Effects) : TArrayView<UFireflyEffect* const>();
+}
+
+bool UFireflyAbilitySystemComponent::HasActiveEffectWithTags(const FGameplayTagContainer& EffectAssetTags) const
+{
+	bool bFound = false;
+	ForEachActiveEffectWithTags(EffectAssetTags, [&bFound](UFireflyEffect* Effect)
 	{
-		if (Effect->GetClass() == EffectType)
-		{
-			OutEffects.Emplace(Effect);
-		}
+		bFound = true;
+	});
+
+	return bFound;
+}
+
+void UFireflyAbilitySystemComponent::AddActiveEffectToIndices(UFireflyEffect* InEffect)
+{
+	if (!IsValid(InEffect))
+	{
+		return;
 	}
 
-	return OutEffects;
+	ActiveEffectsByClass.FindOrAdd(InEffect->GetClass()).Emplace(InEffect);
+
+	if (InEffect->EffectID != NAME_None)
+	{
+		ActiveEffectsByID.FindOrAdd(InEffect->EffectID).Emplace(InEffect);
+	}
+
+	for (const FGameplayTag& Tag : InEffect->GetDefinition().TagsForEffectAsset)
+	{
+		ActiveEffectsByAssetTag.FindOrAdd(Tag).Emplace(InEffect);
+	}
 }
 
-TArray<UFireflyEffect*> UFireflyAbilitySystemComponent::GetActiveEffectsByTag(
-	FGameplayTagContainer EffectAssetTags) const
+void UFireflyAbilitySystemComponent::RemoveActiveEffectFromIndices(UFireflyEffect* InEffect)
 {
-	if (!EffectAssetTags.IsValid())
+	if (!InEffect)
 	{
-		return TArray<UFireflyEffect*>{};
+		return;
 	}
 
-	TArray<UFireflyEffect*> OutEffects = TArray<UFireflyEffect*>{};
-	for (auto Effect : ActiveEffects)
+	auto RemoveFromBucket = [InEffect](auto& Index, const auto& Key)
 	{
-		if (Effect->TagsForEffectAsset.HasAllExact(EffectAssetTags))
+		if (TArray<UFireflyEffect*>* Bucket = Index.Find(Key))
 		{
-			OutEffects.Emplace(Effect);
+			Bucket->RemoveSingle(InEffect);
+			if (Bucket->Num() == 0)
+			{
+				Index.Remove(Key);
+			}
 		}
+	};
+
+	RemoveFromBucket(ActiveEffectsByClass, TSubclassOf<UFireflyEffect>(InEffect->GetClass()));
+	RemoveFromBucket(ActiveEffectsByID, InEffect->EffectID);
+	for (const FGameplayTag& Tag : InEffect->GetDefinition().TagsForEffectAsset)
+	{
+		RemoveFromBucket(ActiveEffectsByAssetTag, Tag);
 	}
+}
 
-	return OutEffects;
+void UFireflyAbilitySystemComponent::RebuildActiveEffectIndices()
+{
+	ActiveEffectsByClass.Reset();
+	ActiveEffectsByID.Reset();
+	ActiveEffectsByAssetTag.Reset();
+
+	for (UFireflyEffect* Effect : ActiveEffects)
+	{
+		AddActiveEffectToIndices(Effect);
+	}
+}
+
+void UFireflyAbilitySystemComponent::OnRep_ActiveEffects()
+{
+	RebuildActiveEffectIndices();
 }
 
-FGameplayTagContainer UFireflyAbilitySystemComponent::GetBlockEffectTags() const
+bool UFireflyAbilitySystemComponent::IsEffectApplicationBlocked(const FGameplayTagContainer& EffectAssetTags,
+	const FGameplayTagContainer& RequireTags, const FGameplayTagContainer& BlockTags) const
 {
-	FGameplayTagContainer OutTags;
-	for (auto TagCount : BlockEffectTags)
+	return IsEffectApplicationBlocked(FFireflyEffectApplicationTagBits(EffectAssetTags, RequireTags, BlockTags));
+}
+
+bool UFireflyAbilitySystemComponent::IsEffectApplicationBlocked(const FFireflyEffectApplicationTagBits& TagBits) const
+{
+	if (TagBits.AssetTags.HasAny(BlockEffectTagBits))
+	{
+		return true;
+	}
+
+	/** 与RequireTags.HasAll(OwnerTags)和BlockTags.HasAnyExact(OwnerTags)的判定结果一致 */
+	return !TagBits.RequireTagsWithParents.HasAll(OwnedTagBits) || TagBits.BlockTags.HasAny(OwnedTagBits);
+}
+
+bool UFireflyAbilitySystemComponent::IsEffectSpecApplicationBlocked(const FFireflyEffectSpec& EffectSpec) const
+{
+	if (EffectSpec.ApplicationTagBits)
 	{
-		OutTags.AddTag(TagCount.Key);
+		return IsEffectApplicationBlocked(*EffectSpec.ApplicationTagBits);
 	}
 
-	return OutTags;
+	return IsEffectApplicationBlocked(*EffectSpec.TagsForEffectAsset, *EffectSpec.TagsRequireOwnerHasForApplication,
+		*EffectSpec.TagsBlockApplicationOnOwnerHas);
 }
 
 void UFireflyAbilitySystemComponent::ApplyEffectToOwner(AActor* Instigator, UFireflyEffect* EffectInstance,
@@ -1311,33 +2637,41 @@ void UFireflyAbilitySystemComponent::ApplyEffectToOwner(AActor* Instigator, UFir
 	}
 
 	/** 若效果会被阻挡，则应用无效 */
-	if (EffectInstance->TagsForEffectAsset.HasAnyExact(GetBlockEffectTags())
-		|| !EffectInstance->TagsRequireOwnerHasForApplication.HasAll(GetContainedTags())
-		|| EffectInstance->TagsBlockApplicationOnOwnerHas.HasAnyExact(GetContainedTags()))
+	const FFireflyEffectDefinition& EffectDefinition = EffectInstance->GetDefinition();
+	if (IsEffectApplicationBlocked(EffectDefinition.ApplicationTagBits))
 	{
-		if (ActiveEffects.Contains(EffectInstance))
+		if (!ActiveEffects.Contains(EffectInstance))
 		{
-			EffectInstance->MarkAsGarbage();
+			ReleaseEffectInstance(EffectInstance);
 		}
 		return;
 	}
 
+	ApplyEffectInstanceToOwner(Instigator, EffectInstance, StackToApply);
+}
+
+EFireflyEffectApplicationResult UFireflyAbilitySystemComponent::ApplyEffectInstanceToOwner(AActor* Instigator, UFireflyEffect* EffectInstance,
+	int32 StackToApply)
+{
 	if (!IsValid(Instigator))
 	{
 		Instigator = GetOwner();
 	}
 
-	const TArray<UFireflyEffect*> ActiveSpecEffects = GetActiveEffectsByClass(EffectInstance->GetClass());
+	/** 应用过程中效果可能被移除，因此复制一份索引中的效果 */
+	const TArray<UFireflyEffect*, TInlineAllocator<8>> ActiveSpecEffects(GetActiveEffectsViewByClass(EffectInstance->GetClass()));
 	/** 管理器中目前如果不存在被应用的指定效果，则直接应用该效果实例 */
 	if (ActiveSpecEffects.Num() == 0)
 	{
 		EffectInstance->ApplyEffect(Instigator, GetOwner(), StackToApply);
 
-		return;
+		return EFireflyEffectApplicationResult::Applied;
 	}
 
+	EFireflyEffectApplicationResult Result = EFireflyEffectApplicationResult::Applied;
+
 	/** 如果指定效果的默认发起者应用策略为InstigatorsApplyTheirOwnOnly，不同的发起者仅生成各自的单个该效果实例 */
-	if (EffectInstance->InstigatorApplicationPolicy == EFireflyEffectInstigatorApplicationPolicy::InstigatorsApplyTheirOwnOnly)
+	if (EffectInstance->GetDefinition().InstigatorApplicationPolicy == EFireflyEffectInstigatorApplicationPolicy::InstigatorsApplyTheirOwnOnly)
 	{
 		bool bContainsInstigator = false;
 		for (auto Effect : ActiveSpecEffects)
@@ -1345,6 +2679,10 @@ void UFireflyAbilitySystemComponent::ApplyEffectToOwner(AActor* Instigator, UFir
 			if (Effect->Instigators.Contains(Instigator))
 			{
 				/** 已经存在的效果尝试应用堆叠或刷新操作 */
+				if (Effect->IsNewStackingDenied())
+				{
+					Result = EFireflyEffectApplicationResult::NotApplied;
+				}
 				Effect->ApplyEffect(Instigator, GetOwner(), StackToApply);
 
 				bContainsInstigator = true;
@@ -1354,16 +2692,30 @@ void UFireflyAbilitySystemComponent::ApplyEffectToOwner(AActor* Instigator, UFir
 		}
 
 		/** 如果指定效果在该管理器中目前生效的实例的发起者都不包含InInstigator，则应用新的效果实例 */
-		if (!bContainsInstigator && !ActiveSpecEffects.Contains(EffectInstance))
+		if (!bContainsInstigator)
 		{
-			EffectInstance->ApplyEffect(Instigator, GetOwner(), StackToApply);
-		}		
+			if (ActiveSpecEffects.Contains(EffectInstance))
+			{
+				Result = EFireflyEffectApplicationResult::NotApplied;
+			}
+			else
+			{
+				EffectInstance->ApplyEffect(Instigator, GetOwner(), StackToApply);
+			}
+		}
 	}
 	/** 如果指定效果的默认发起者应用策略为InstigatorsShareOne，不同的发起者共享同一个该效果实例 */
-	else if (EffectInstance->InstigatorApplicationPolicy == EFireflyEffectInstigatorApplicationPolicy::InstigatorsShareOne)
+	else if (EffectInstance->GetDefinition().InstigatorApplicationPolicy == EFireflyEffectInstigatorApplicationPolicy::InstigatorsShareOne)
 	{
+		/** 所有已经存在的效果都拒绝新的堆叠时，本次应用无效 */
+		Result = EFireflyEffectApplicationResult::NotApplied;
 		for (auto Effect : ActiveSpecEffects)
 		{
+			if (!Effect->IsNewStackingDenied())
+			{
+				Result = EFireflyEffectApplicationResult::Applied;
+			}
+
 			/** 若本次发起者为新的发起者，将该发起者加入效果实例中 */
 			if (!Effect->Instigators.Contains(Instigator))
 			{
@@ -1380,10 +2732,13 @@ void UFireflyAbilitySystemComponent::ApplyEffectToOwner(AActor* Instigator, UFir
 		EffectInstance->ApplyEffect(Instigator, GetOwner(), StackToApply);
 	}
 
-	if (ActiveEffects.Contains(EffectInstance))
+	/** 未被使用的效果实例直接回收 */
+	if (IsValid(EffectInstance) && !EffectInstance->bIsInInstancePool && !ActiveEffects.Contains(EffectInstance))
 	{
-		EffectInstance->MarkAsGarbage();
+		ReleaseEffectInstance(EffectInstance);
 	}
+
+	return Result;
 }
 
 void UFireflyAbilitySystemComponent::ApplyEffectToTarget(AActor* Target, UFireflyEffect* EffectInstance,
@@ -1394,17 +2749,73 @@ void UFireflyAbilitySystemComponent::ApplyEffectToTarget(AActor* Target, UFirefl
 		return;
 	}
 
-	UFireflyAbilitySystemComponent* TargetEffectMgr = nullptr;
-	if (!IsValid(Target->GetComponentByClass(UFireflyAbilitySystemComponent::StaticClass())))
+	UFireflyAbilitySystemComponent* TargetEffectMgr = UFireflyAbilitySystemLibrary::GetFireflyAbilitySystem(Target);
+	if (!IsValid(TargetEffectMgr))
 	{
-		EffectInstance->MarkAsGarbage();
+		ReleaseEffectInstance(EffectInstance);
 		return;
 	}
 
-	TargetEffectMgr = Cast<UFireflyAbilitySystemComponent>(Target->GetComponentByClass(UFireflyAbilitySystemComponent::StaticClass()));
 	TargetEffectMgr->ApplyEffectToOwner(GetOwner(), EffectInstance, StackToApply);
 }
 
+TArray<EFireflyEffectApplicationResult> UFireflyAbilitySystemComponent::ApplyEffectToTargetsByClass(
+	const TArray<AActor*>& Targets, TSubclassOf<UFireflyEffect> EffectType, FName EffectID, int32 StackToApply)
+{
+	TArray<EFireflyEffectApplicationResult> Results;
+	ApplyEffectToTargets(Targets, EffectType, EffectID, StackToApply, Results);
+
+	return Results;
+}
+
+void UFireflyAbilitySystemComponent::ApplyEffectToTargets(TArrayView<AActor* const> Targets,
+	TSubclassOf<UFireflyEffect> EffectType, FName EffectID, int32 StackToApply, TArray<EFireflyEffectApplicationResult>& OutResults)
+{
+	OutResults.Reset(Targets.Num());
+	OutResults.Init(EFireflyEffectApplicationResult::InvalidTarget, Targets.Num());
+	if (!IsValid(EffectType) || StackToApply <= 0 || !HasAuthority())
+	{
+		return;
+	}
+
+	/** 效果的定义和是否可以不创建实例只解析一次，所有目标共享 */
+	AActor* Instigator = GetOwner();
+	UFireflyEffect* EffectCDO = EffectType->GetDefaultObject<UFireflyEffect>();
+	FFireflyEffectSpec EffectSpec(EffectCDO);
+	EffectSpec.EffectID = EffectID;
+	EffectSpec.Instigator = Instigator;
+	const bool bExecuteWithoutInstance = EffectCDO->GetDefinition().DurationPolicy == EFireflyEffectDurationPolicy::Instant
+		&& EffectSpec.CanExecuteWithoutInstance();
+
+	for (int32 i = 0; i < Targets.Num(); ++i)
+	{
+		UFireflyAbilitySystemComponent* TargetEffectMgr = UFireflyAbilitySystemLibrary::GetFireflyAbilitySystem(Targets[i]);
+		if (!IsValid(TargetEffectMgr))
+		{
+			continue;
+		}
+
+		/** 被阻挡的目标不获取效果实例 */
+		if (TargetEffectMgr->IsEffectSpecApplicationBlocked(EffectSpec))
+		{
+			OutResults[i] = EFireflyEffectApplicationResult::Blocked;
+			continue;
+		}
+
+		if (bExecuteWithoutInstance)
+		{
+			TargetEffectMgr->ExecuteEffectSpecOnOwner(EffectSpec, StackToApply);
+			OutResults[i] = EFireflyEffectApplicationResult::Applied;
+		}
+		else
+		{
+			UFireflyEffect* NewEffect = TargetEffectMgr->AcquireEffectInstance(EffectType);
+			NewEffect->EffectID = EffectID;
+			OutResults[i] = TargetEffectMgr->ApplyEffectInstanceToOwner(Instigator, NewEffect, StackToApply);
+		}
+	}
+}
+
 void UFireflyAbilitySystemComponent::ApplyEffectToOwnerByID(AActor* Instigator, FName EffectID, int32 StackToApply)
 {
 	if (EffectID == NAME_None)
@@ -1423,7 +2834,21 @@ void UFireflyAbilitySystemComponent::ApplyEffectToOwnerByID(AActor* Instigator,
 		Instigator = GetOwner();
 	}
 
-	UFireflyEffect* NewEffect = NewObject<UFireflyEffect>(this, EffectClass);
+	UFireflyEffect* EffectCDO = EffectClass->GetDefaultObject<UFireflyEffect>();
+	if (EffectCDO->GetDefinition().DurationPolicy == EFireflyEffectDurationPolicy::Instant)
+	{
+		FFireflyEffectSpec EffectSpec(EffectCDO);
+		if (EffectSpec.CanExecuteWithoutInstance())
+		{
+			EffectSpec.EffectID = EffectID;
+			EffectSpec.Instigator = Instigator;
+			ApplyEffectSpecToOwner(EffectSpec, StackToApply);
+			return;
+		}
+	}
+
+	UFireflyEffect* NewEffect = AcquireEffectInstance(EffectClass);
+	NewEffect->EffectID = EffectID;
 	ApplyEffectToOwner(Instigator, NewEffect, StackToApply);
 }
 
@@ -1440,81 +2865,177 @@ void UFireflyAbilitySystemComponent::ApplyEffectToTargetByID(AActor* Target, FNa
 		return;
 	}
 
-	UFireflyAbilitySystemComponent* TargetEffectMgr = nullptr;
-	if (!IsValid(Target->GetComponentByClass(UFireflyAbilitySystemComponent::StaticClass())))
+	UFireflyAbilitySystemComponent* TargetEffectMgr = UFireflyAbilitySystemLibrary::GetFireflyAbilitySystem(Target);
+	if (!IsValid(TargetEffectMgr))
+	{
+		return;
+	}
+
+	TargetEffectMgr->ApplyEffectToOwnerByClass(GetOwner(), EffectClass, EffectID, StackToApply);
+}
+
+void UFireflyAbilitySystemComponent::ApplyEffectToOwnerByClass(AActor* Instigator, TSubclassOf<UFireflyEffect> EffectType,
+	FName EffectID, int32 StackToApply)
+{
+	if (!IsValid(EffectType) || StackToApply <= 0 || !HasAuthority())
+	{
+		return;
+	}
+
+	if (!IsValid(Instigator))
+	{
+		Instigator = GetOwner();
+	}
+
+	UFireflyEffect* EffectCDO = EffectType->GetDefaultObject<UFireflyEffect>();
+	if (EffectCDO->GetDefinition().DurationPolicy == EFireflyEffectDurationPolicy::Instant)
+	{
+		FFireflyEffectSpec EffectSpec(EffectCDO);
+		if (EffectSpec.CanExecuteWithoutInstance())
+		{
+			EffectSpec.EffectID = EffectID;
+			EffectSpec.Instigator = Instigator;
+			ApplyEffectSpecToOwner(EffectSpec, StackToApply);
+			return;
+		}
+	}
+
+	UFireflyEffect* NewEffect = AcquireEffectInstance(EffectType);
+	NewEffect->EffectID = EffectID;
+	ApplyEffectToOwner(Instigator, NewEffect, StackToApply);
+}
+
+void UFireflyAbilitySystemComponent::ApplyEffectToTargetByClass(AActor* Target, TSubclassOf<UFireflyEffect> EffectType,
+	FName EffectID, int32 StackToApply)
+{
+	if (!IsValid(Target) || !IsValid(EffectType) || StackToApply <= 0 || !HasAuthority())
+	{
+		return;
+	}
+
+	UFireflyAbilitySystemComponent* TargetEffectMgr = UFireflyAbilitySystemLibrary::GetFireflyAbilitySystem(Target);
+	if (!IsValid(TargetEffectMgr))
+	{
+		return;
+	}
+
+	TargetEffectMgr->ApplyEffectToOwnerByClass(GetOwner(), EffectType, EffectID, StackToApply);
+}
+
+void UFireflyAbilitySystemComponent::ApplyEffectDynamicConstructorToOwner(AActor* Instigator,
+	FFireflyEffectDynamicConstructor EffectSetup, int32 StackToApply)
+{
+	if (StackToApply <= 0 || !HasAuthority())
+	{
+		return;
+	}
+
+	const TSubclassOf<UFireflyEffect> EffectType = IsValid(EffectSetup.EffectType) ? EffectSetup.EffectType : UFireflyEffect::StaticClass();
+	if (EffectSetup.DurationPolicy == EFireflyEffectDurationPolicy::Instant)
+	{
+		FFireflyEffectSpec EffectSpec(EffectType->GetDefaultObject<UFireflyEffect>(), EffectSetup);
+		if (EffectSpec.CanExecuteWithoutInstance())
+		{
+			EffectSpec.Instigator = IsValid(Instigator) ? Instigator : GetOwner();
+			ApplyEffectSpecToOwner(EffectSpec, StackToApply);
+			return;
+		}
+	}
+
+	UFireflyEffect* Effect = AcquireEffectInstance(EffectType);
+	Effect->SetupEffectByDynamicConstructor(EffectSetup);
+	ApplyEffectToOwner(Instigator, Effect, StackToApply);
+}
+
+void UFireflyAbilitySystemComponent::ApplyEffectDynamicConstructorToTarget(AActor* Target,
+	FFireflyEffectDynamicConstructor EffectSetup, int32 StackToApply)
+{
+	if (!IsValid(Target) || StackToApply <= 0 || !HasAuthority())
+	{
+		return;
+	}
+
+	UFireflyAbilitySystemComponent* TargetEffectMgr = UFireflyAbilitySystemLibrary::GetFireflyAbilitySystem(Target);
+	if (!IsValid(TargetEffectMgr))
 	{
 		return;
 	}
 
-	TargetEffectMgr = Cast<UFireflyAbilitySystemComponent>(Target->GetComponentByClass(UFireflyAbilitySystemComponent::StaticClass()));
-	TargetEffectMgr->ApplyEffectToOwnerByClass(GetOwner(), EffectClass, EffectID, StackToApply);
+	TargetEffectMgr->ApplyEffectDynamicConstructorToOwner(GetOwner(), EffectSetup, StackToApply);
 }
 
-void UFireflyAbilitySystemComponent::ApplyEffectToOwnerByClass(AActor* Instigator, TSubclassOf<UFireflyEffect> EffectType,
-	FName EffectID, int32 StackToApply)
+UFireflyEffect* UFireflyAbilitySystemComponent::AcquireEffectInstance(TSubclassOf<UFireflyEffect> EffectType)
 {
-	if (!IsValid(EffectType) || StackToApply <= 0 || !HasAuthority())
+	if (FFireflyEffectInstancePool* Pool = EffectInstancePools.Find(EffectType))
 	{
-		return;
-	}
-
-	if (!IsValid(Instigator))
-	{
-		Instigator = GetOwner();
+		while (Pool->Instances.Num() > 0)
+		{
+			UFireflyEffect* Effect = Pool->Instances.Pop(false);
+			if (IsValid(Effect))
+			{
+				Effect->bIsInInstancePool = false;
+				return Effect;
+			}
+		}
 	}
 
-	UFireflyEffect* NewEffect = NewObject<UFireflyEffect>(this, EffectType);
-	NewEffect->EffectID = EffectID;
-	ApplyEffectToOwner(Instigator, NewEffect, StackToApply);
+	return NewObject<UFireflyEffect>(this, EffectType);
 }
 
-void UFireflyAbilitySystemComponent::ApplyEffectToTargetByClass(AActor* Target, TSubclassOf<UFireflyEffect> EffectType,
-	FName EffectID, int32 StackToApply)
+void UFireflyAbilitySystemComponent::ReleaseEffectInstance(UFireflyEffect* EffectInstance)
 {
-	if (!IsValid(Target) || !IsValid(EffectType) || StackToApply <= 0 || !HasAuthority())
+	if (!IsValid(EffectInstance) || EffectInstance->bIsInInstancePool)
 	{
 		return;
 	}
 
-	UFireflyAbilitySystemComponent* TargetEffectMgr = nullptr;
-	if (!IsValid(Target->GetComponentByClass(UFireflyAbilitySystemComponent::StaticClass())))
+	if (!EffectInstance->bAllowInstancePooling || EffectInstance->GetOuter() != this)
 	{
+		EffectInstance->MarkAsGarbage();
 		return;
 	}
 
-	TargetEffectMgr = Cast<UFireflyAbilitySystemComponent>(Target->GetComponentByClass(UFireflyAbilitySystemComponent::StaticClass()));
-	TargetEffectMgr->ApplyEffectToOwnerByClass(GetOwner(), EffectType, EffectID,StackToApply);
-}
-
-void UFireflyAbilitySystemComponent::ApplyEffectDynamicConstructorToOwner(AActor* Instigator,
-	FFireflyEffectDynamicConstructor EffectSetup, int32 StackToApply)
-{
-	if (StackToApply <= 0 || !HasAuthority())
+	FFireflyEffectInstancePool& Pool = EffectInstancePools.FindOrAdd(EffectInstance->GetClass());
+	if (Pool.Instances.Num() >= UFireflyAbilitySystemSettings::Get()->EffectInstancePoolSizePerClass)
 	{
+		EffectInstance->MarkAsGarbage();
 		return;
 	}
 
-	UFireflyEffect* Effect = NewObject<UFireflyEffect>(this, IsValid(EffectSetup.EffectType) ? EffectSetup.EffectType : UFireflyEffect::StaticClass());
-	Effect->SetupEffectByDynamicConstructor(EffectSetup);
-	ApplyEffectToOwner(Instigator, Effect, StackToApply);
+	EffectInstance->ResetEffectInstance();
+	EffectInstance->bIsInInstancePool = true;
+	Pool.Instances.Emplace(EffectInstance);
 }
 
-void UFireflyAbilitySystemComponent::ApplyEffectDynamicConstructorToTarget(AActor* Target,
-	FFireflyEffectDynamicConstructor EffectSetup, int32 StackToApply)
+void UFireflyAbilitySystemComponent::ApplyEffectSpecToOwner(const FFireflyEffectSpec& EffectSpec, int32 StackToApply)
 {
-	if (!IsValid(Target) || StackToApply <= 0 || !HasAuthority())
+	if (!IsValid(EffectSpec.EffectCDO) || !HasAuthority() || StackToApply <= 0)
 	{
 		return;
 	}
 
-	UFireflyAbilitySystemComponent* TargetEffectMgr = nullptr;
-	if (!IsValid(Target->GetComponentByClass(UFireflyAbilitySystemComponent::StaticClass())))
+	/** 若效果会被阻挡，则应用无效 */
+	if (IsEffectSpecApplicationBlocked(EffectSpec))
 	{
 		return;
 	}
 
-	TargetEffectMgr = Cast<UFireflyAbilitySystemComponent>(Target->GetComponentByClass(UFireflyAbilitySystemComponent::StaticClass()));
-	TargetEffectMgr->ApplyEffectDynamicConstructorToOwner(GetOwner(), EffectSetup, StackToApply);
+	ExecuteEffectSpecOnOwner(EffectSpec, StackToApply);
+}
+
+void UFireflyAbilitySystemComponent::ExecuteEffectSpecOnOwner(const FFireflyEffectSpec& EffectSpec, int32 StackToApply)
+{
+	/** 修改器的来源是效果类型的默认对象，执行期间通过GetExecutingEffectSpec向修改器回调提供效果的ID和发起者 */
+	TGuardValue<const FFireflyEffectSpec*> ExecutingSpecGuard(ExecutingEffectSpec, &EffectSpec);
+	FFireflyScopedModifierTransaction Transaction(this);
+	for (int32 i = 0; i < StackToApply; ++i)
+	{
+		for (const FFireflyEffectModifierData& Modifier : EffectSpec.Modifiers)
+		{
+			ApplyModifierToAttributeInstant(Modifier.AttributeType, Modifier.ModOperator, EffectSpec.EffectCDO,
+				ResolveModifierValueInstant(Modifier));
+		}
+	}
 }
 
 void UFireflyAbilitySystemComponent::RemoveActiveEffectsByID(FName EffectID, int32 StackToRemove)
@@ -1524,20 +3045,14 @@ void UFireflyAbilitySystemComponent::RemoveActiveEffectsByID(FName EffectID, int
 		return;
 	}
 
-	TArray<UFireflyEffect*> EffectsToRemove = TArray<UFireflyEffect*>{};
-	for (auto Effect : ActiveEffects)
-	{
-		if (Effect->EffectID == EffectID)
-		{
-			EffectsToRemove.Add(Effect);
-		}
-	}
+	const TArray<UFireflyEffect*, TInlineAllocator<8>> EffectsToRemove(GetActiveEffectsViewByID(EffectID));
+
+	FFireflyScopedModifierTransaction Transaction(this);
 
 	if (StackToRemove == -1)
 	{
 		for (auto Effect : EffectsToRemove)
 		{
-			ActiveEffects.RemoveSingle(Effect);
 			Effect->RemoveEffect();
 		}
 
@@ -1561,20 +3076,14 @@ void UFireflyAbilitySystemComponent::RemoveActiveEffectsByClass(TSubclassOf<UFir
 		return;
 	}
 
-	TArray<UFireflyEffect*> EffectsToRemove = TArray<UFireflyEffect*>{};
-	for (auto Effect : ActiveEffects)
-	{
-		if (Effect->GetClass() == EffectType)
-		{
-			EffectsToRemove.Add(Effect);
-		}
-	}
+	const TArray<UFireflyEffect*, TInlineAllocator<8>> EffectsToRemove(GetActiveEffectsViewByClass(EffectType));
+
+	FFireflyScopedModifierTransaction Transaction(this);
 
 	if (StackToRemove == -1)
 	{
 		for (auto Effect : EffectsToRemove)
 		{
-			ActiveEffects.RemoveSingle(Effect);
 			Effect->RemoveEffect();
 		}
 
@@ -1597,15 +3106,20 @@ void UFireflyAbilitySystemComponent::RemoveActiveEffectsWithTags(FGameplayTagCon
 		return;
 	}
 
-	TArray<UFireflyEffect*> EffectsToRemove = TArray<UFireflyEffect*>{};
-	for (auto Effect : ActiveEffects)
+	TArray<UFireflyEffect*, TInlineAllocator<8>> EffectsToRemove;
+	for (const FGameplayTag& Tag : RemoveTags)
 	{
-		if (Effect->TagsForEffectAsset.HasAnyExact(RemoveTags))
+		if (const TArray<UFireflyEffect*>* Bucket = ActiveEffectsByAssetTag.Find(Tag))
 		{
-			EffectsToRemove.Add(Effect);
+			for (UFireflyEffect* Effect : *Bucket)
+			{
+				EffectsToRemove.AddUnique(Effect);
+			}
 		}
 	}
 
+	FFireflyScopedModifierTransaction Transaction(this);
+
 	for (auto Effect : EffectsToRemove)
 	{
 		Effect->RemoveEffect();
@@ -1619,15 +3133,8 @@ void UFireflyAbilitySystemComponent::RemoveSingleActiveEffectByID(FName EffectID
 		return;
 	}
 
-	UFireflyEffect* EffectToRemove = nullptr;
-	for (auto Effect : ActiveEffects)
-	{
-		if (Effect->EffectID == EffectID)
-		{
-			EffectToRemove = Effect;
-			break;
-		}
-	}
+	const TArrayView<UFireflyEffect* const> Effects = GetActiveEffectsViewByID(EffectID);
+	UFireflyEffect* EffectToRemove = Effects.Num() > 0 ? Effects[0] : nullptr;
 
 	if (StackToRemove == -1)
 	{
@@ -1650,15 +3157,8 @@ void UFireflyAbilitySystemComponent::RemoveSingleActiveEffectByClass(TSubclassOf
 		return;
 	}
 
-	UFireflyEffect* EffectToRemove = nullptr;
-	for (auto Effect : ActiveEffects)
-	{
-		if (Effect->GetClass() == EffectType)
-		{
-			EffectToRemove = Effect;
-			break;
-		}
-	}
+	const TArrayView<UFireflyEffect* const> Effects = GetActiveEffectsViewByClass(EffectType);
+	UFireflyEffect* EffectToRemove = Effects.Num() > 0 ? Effects[0] : nullptr;
 
 	if (StackToRemove == -1)
 	{
@@ -1683,17 +3183,21 @@ void UFireflyAbilitySystemComponent::HandleActiveEffectApplication(UFireflyEffec
 	if (bIsApplied)
 	{
 		ActiveEffects.Emplace(InEffect);
-		AppendEffectSpecificProperties(InEffect->SpecificProperties);
+		AddActiveEffectToIndices(InEffect);
+		AppendEffectSpecificProperties(InEffect->GetDefinition().SpecificProperties);
 	}
 	else
 	{
-		ActiveEffects.RemoveSingle(InEffect);
-		RemoveEffectSpecificProperties(InEffect->SpecificProperties);
+		if (ActiveEffects.RemoveSingle(InEffect) > 0)
+		{
+			RemoveActiveEffectFromIndices(InEffect);
+		}
+		RemoveEffectSpecificProperties(InEffect->GetDefinition().SpecificProperties);
 	}
 }
 
-void UFireflyAbilitySystemComponent::UpdateBlockAndRemoveEffectTags(FGameplayTagContainer BlockTags,
-	FGameplayTagContainer RemoveTags, bool bIsApplied)
+void UFireflyAbilitySystemComponent::UpdateBlockAndRemoveEffectTags(const FGameplayTagContainer& BlockTags,
+	const FGameplayTagContainer& RemoveTags, bool bIsApplied)
 {
 	if (!HasAuthority())
 	{
@@ -1704,19 +3208,19 @@ void UFireflyAbilitySystemComponent::UpdateBlockAndRemoveEffectTags(FGameplayTag
 	{
 		RemoveActiveEffectsWithTags(RemoveTags);
 
-		TArray<FGameplayTag> Tags;
-		BlockTags.GetGameplayTagArray(Tags);
-		for (auto TagToAdd : Tags)
+		for (const FGameplayTag& TagToAdd : BlockTags)
 		{
 			int32& Count = BlockEffectTags.FindOrAdd(TagToAdd);
-			++Count;
+			if (++Count == 1)
+			{
+				BlockEffectTagContainer.AddTag(TagToAdd);
+				BlockEffectTagBits.SetBit(FFireflyGameplayTagBitRegistry::Get().FindOrAddBitIndex(TagToAdd));
+			}
 		}
 	}
 	else
 	{
-		TArray<FGameplayTag> Tags;
-		BlockTags.GetGameplayTagArray(Tags);
-		for (auto TagToRemove : Tags)
+		for (const FGameplayTag& TagToRemove : BlockTags)
 		{
 			if (!BlockEffectTags.Contains(TagToRemove))
 			{
@@ -1729,6 +3233,8 @@ void UFireflyAbilitySystemComponent::UpdateBlockAndRemoveEffectTags(FGameplayTag
 			if (*CountToMinus == 0)
 			{
 				BlockEffectTags.Remove(TagToRemove);
+				BlockEffectTagContainer.RemoveTag(TagToRemove);
+				BlockEffectTagBits.ClearBit(FFireflyGameplayTagBitRegistry::Get().FindOrAddBitIndex(TagToRemove));
 			}
 		}
 	}
@@ -1742,14 +3248,14 @@ bool UFireflyAbilitySystemComponent::GetSingleActiveEffectTimeDurationByID(FName
 		return false;
 	}
 
-	const TArray<UFireflyEffect*> Effects = GetActiveEffectsByID(EffectID);
+	const TArrayView<UFireflyEffect* const> Effects = GetActiveEffectsViewByID(EffectID);
 	if (!Effects.IsValidIndex(0))
 	{
 		return false;
 	}
 
 	TimeRemaining = Effects[0]->GetTimeRemainingOfDuration();
-	TotalDuration = Effects[0]->Duration;
+	TotalDuration = Effects[0]->GetDefinition().Duration;
 
 	return true;
 }
@@ -1762,14 +3268,14 @@ bool UFireflyAbilitySystemComponent::GetSingleActiveEffectTimeDurationByClass(TS
 		return false;
 	}
 
-	const TArray<UFireflyEffect*> Effects = GetActiveEffectsByClass(EffectType);
+	const TArrayView<UFireflyEffect* const> Effects = GetActiveEffectsViewByClass(EffectType);
 	if (!Effects.IsValidIndex(0))
 	{
 		return false;
 	}
 
 	TimeRemaining = Effects[0]->GetTimeRemainingOfDuration();
-	TotalDuration = Effects[0]->Duration;
+	TotalDuration = Effects[0]->GetDefinition().Duration;
 
 	return true;
 }
@@ -1782,14 +3288,14 @@ void UFireflyAbilitySystemComponent::SetActiveEffectsTimeRemaining(TSubclassOf<U
 		return;
 	}
 
-	const TArray<UFireflyEffect*> Effects = GetActiveEffectsByClass(EffectType);
+	const TArrayView<UFireflyEffect* const> Effects = GetActiveEffectsViewByClass(EffectType);
 
 	for (auto Effect : Effects)
 	{
 		Effect->SetTimeRemainingOfDuration(NewTimeRemaining);
 	}	
 
-	OnEffectTimeRemainingChanged.Broadcast(Effects[0]->EffectID, EffectType, NewTimeRemaining, Effects[0]->Duration);
+	OnEffectTimeRemainingChanged.Broadcast(Effects[0]->EffectID, EffectType, NewTimeRemaining, Effects[0]->GetDefinition().Duration);
 }
 
 bool UFireflyAbilitySystemComponent::GetSingleActiveEffectStackingCountByID(FName EffectID, int32& StackingCount) const
@@ -1799,7 +3305,7 @@ bool UFireflyAbilitySystemComponent::GetSingleActiveEffectStackingCountByID(FNam
 		return false;
 	}
 
-	const TArray<UFireflyEffect*> Effects = GetActiveEffectsByID(EffectID);
+	const TArrayView<UFireflyEffect* const> Effects = GetActiveEffectsViewByID(EffectID);
 	if (!Effects.IsValidIndex(0))
 	{
 		return false;
@@ -1818,7 +3324,7 @@ bool UFireflyAbilitySystemComponent::GetSingleActiveEffectStackingCountByClass(T
 		return false;
 	}
 
-	const TArray<UFireflyEffect*> Effects = GetActiveEffectsByClass(EffectType);
+	const TArrayView<UFireflyEffect* const> Effects = GetActiveEffectsViewByClass(EffectType);
 	if (!Effects.IsValidIndex(0))
 	{
 		return false;
@@ -1842,7 +3348,7 @@ UFireflyEffect* UFireflyAbilitySystemComponent::MakeDynamicEffectByID(FName Effe
 		return nullptr;
 	}
 
-	UFireflyEffect* Effect = NewObject<UFireflyEffect>(this, EffectClass);
+	UFireflyEffect* Effect = AcquireEffectInstance(EffectClass);
 	Effect->EffectID = EffectID;
 
 	return Effect;
@@ -1855,7 +3361,7 @@ UFireflyEffect* UFireflyAbilitySystemComponent::MakeDynamicEffectByClass(TSubcla
 		return nullptr;
 	}
 
-	UFireflyEffect* Effect = NewObject<UFireflyEffect>(this, EffectType);
+	UFireflyEffect* Effect = AcquireEffectInstance(EffectType);
 	Effect->EffectID = EffectID;
 
 	return Effect;
@@ -1864,7 +3370,9 @@ UFireflyEffect* UFireflyAbilitySystemComponent::MakeDynamicEffectByClass(TSubcla
 UFireflyEffect* UFireflyAbilitySystemComponent::AssignDynamicEffectAssetTags(UFireflyEffect* EffectInstance,
 	FGameplayTagContainer NewEffectAssetTags)
 {
-	EffectInstance->TagsForEffectAsset.AppendTags(NewEffectAssetTags);
+	FFireflyEffectDefinition& EffectDefinition = EffectInstance->GetMutableDefinition();
+	EffectDefinition.TagsForEffectAsset.AppendTags(NewEffectAssetTags);
+	EffectDefinition.BuildTagBits();
 
 	return EffectInstance;
 }
@@ -1872,14 +3380,14 @@ UFireflyEffect* UFireflyAbilitySystemComponent::AssignDynamicEffectAssetTags(UFi
 UFireflyEffect* UFireflyAbilitySystemComponent::AssignDynamicEffectGrantTags(UFireflyEffect* EffectInstance,
 	FGameplayTagContainer NewEffectGrantTags)
 {
-	EffectInstance->TagsApplyToOwnerOnApplied.AppendTags(NewEffectGrantTags);
+	EffectInstance->GetMutableDefinition().TagsApplyToOwnerOnApplied.AppendTags(NewEffectGrantTags);
 
 	return EffectInstance;
 }
 
 UFireflyEffect* UFireflyAbilitySystemComponent::SetDynamicEffectDuration(UFireflyEffect* EffectInstance, float Duration)
 {
-	EffectInstance->Duration = Duration;
+	EffectInstance->GetMutableDefinition().Duration = Duration;
 
 	return EffectInstance;
 }
@@ -1887,7 +3395,7 @@ UFireflyEffect* UFireflyAbilitySystemComponent::SetDynamicEffectDuration(UFirefl
 UFireflyEffect* UFireflyAbilitySystemComponent::SetDynamicEffectPeriodicInterval(UFireflyEffect* EffectInstance,
 	float PeriodicInterval)
 {
-	EffectInstance->PeriodicInterval = PeriodicInterval;
+	EffectInstance->GetMutableDefinition().PeriodicInterval = PeriodicInterval;
 
 	return EffectInstance;
 }
@@ -1895,7 +3403,7 @@ UFireflyEffect* UFireflyAbilitySystemComponent::SetDynamicEffectPeriodicInterval
 UFireflyEffect* UFireflyAbilitySystemComponent::SetDynamicEffectModifierValue(UFireflyEffect* EffectInstance,
 	EFireflyAttributeType AttributeType, EFireflyAttributeModOperator ModOperator, float ModValue)
 {
-	for (auto& EffectModifier : EffectInstance->Modifiers)
+	for (auto& EffectModifier : EffectInstance->GetMutableDefinition().Modifiers)
 	{
 		if (EffectModifier.AttributeType == AttributeType && EffectModifier.ModOperator == ModOperator)
 		{
@@ -1911,7 +3419,7 @@ UFireflyEffect* UFireflyAbilitySystemComponent::AssignDynamicEffectModifier(UFir
 	FFireflyEffectModifierData Modifier)
 {
 	bool bHasModifierType = false;
-	for (auto& EffectModifier : EffectInstance->Modifiers)
+	for (auto& EffectModifier : EffectInstance->GetMutableDefinition().Modifiers)
 	{
 		if (EffectModifier.TypeEqual(Modifier))
 		{
@@ -1923,7 +3431,7 @@ UFireflyEffect* UFireflyAbilitySystemComponent::AssignDynamicEffectModifier(UFir
 
 	if (!bHasModifierType)
 	{
-		EffectInstance->Modifiers.Emplace(Modifier);
+		EffectInstance->GetMutableDefinition().Modifiers.Emplace(Modifier);
 	}
 
 	return EffectInstance;
@@ -1932,7 +3440,7 @@ UFireflyEffect* UFireflyAbilitySystemComponent::AssignDynamicEffectModifier(UFir
 UFireflyEffect* UFireflyAbilitySystemComponent::AssignDynamicEffectSpecificProperty(UFireflyEffect* EffectInstance,
 	FFireflySpecificProperty NewSpecificProperty)
 {
-	EffectInstance->SpecificProperties.Emplace(NewSpecificProperty);
+	EffectInstance->GetMutableDefinition().SpecificProperties.Emplace(NewSpecificProperty);
 
 	return EffectInstance;
 }
@@ -1955,24 +3463,35 @@ void UFireflyAbilitySystemComponent::RemoveEffectSpecificProperties(
 	}
 }
 
-FGameplayTagContainer UFireflyAbilitySystemComponent::GetContainedTags() const
+UFireflyEffectModifierCalculator* UFireflyAbilitySystemComponent::GetModifierCalculator(
+	TSubclassOf<UFireflyEffectModifierCalculator> CalculatorClass)
 {
-	TArray<FGameplayTag> Tags;
-	TagCountContainer.GetKeys(Tags);
-	FGameplayTagContainer TagContainer = FGameplayTagContainer::CreateFromArray(Tags);
+	if (!IsValid(CalculatorClass))
+	{
+		return nullptr;
+	}
+
+	UFireflyEffectModifierCalculator*& Calculator = ModifierCalculators.FindOrAdd(CalculatorClass);
+	if (!IsValid(Calculator))
+	{
+		Calculator = NewObject<UFireflyEffectModifierCalculator>(this, CalculatorClass);
+		INC_DWORD_STAT(STAT_FireflyModifierCalculatorsCreated);
+	}
 
-	return TagContainer;
+	return Calculator;
 }
 
 void UFireflyAbilitySystemComponent::AddTagToManager(FGameplayTag TagToAdd, int32 CountToAdd)
 {
-	bool bContainedBefore = TagCountContainer.Contains(TagToAdd);
+	bool bContainedBefore = HasTagExact(TagToAdd);
 	int32& Count = TagCountContainer.FindOrAdd(TagToAdd);
 	Count += CountToAdd;
+	UpdateReplicatedTagCount(TagToAdd);
 
 	if (!bContainedBefore)
 	{
-		OnTagContainerUpdated.Broadcast(GetContainedTags());
+		AddOwnedTag(TagToAdd);
+		BroadcastTagsChanged(MakeArrayView(&TagToAdd, 1), TArrayView<const FGameplayTag>());
 	}
 }
 
@@ -1989,39 +3508,52 @@ void UFireflyAbilitySystemComponent::RemoveTagFromManager(FGameplayTag TagToRemo
 	if (*CountToMinus == 0)
 	{
 		TagCountContainer.Remove(TagToRemove);
-		OnTagContainerUpdated.Broadcast(GetContainedTags());
+	}
+	UpdateReplicatedTagCount(TagToRemove);
+
+	if (!HasTagExact(TagToRemove))
+	{
+		RemoveOwnedTags(MakeArrayView(&TagToRemove, 1));
+		BroadcastTagsChanged(TArrayView<const FGameplayTag>(), MakeArrayView(&TagToRemove, 1));
 	}
 }
 
-void UFireflyAbilitySystemComponent::AddTagsToManager(FGameplayTagContainer TagsToAdd, int32 CountToAdd)
+void UFireflyAbilitySystemComponent::AddTagsToManager(const FGameplayTagContainer& TagsToAdd, int32 CountToAdd)
 {
-	bool bContainedBefore = GetContainedTags().HasAll(TagsToAdd);
-
-	TArray<FGameplayTag> TagsToUpdate;
-	TagsToAdd.GetGameplayTagArray(TagsToUpdate);
-	for (auto Tag : TagsToUpdate)
+	TArray<FGameplayTag> TagsAdded;
+	for (const FGameplayTag& Tag : TagsToAdd)
 	{
+		if (!HasTagExact(Tag))
+		{
+			TagsAdded.Add(Tag);
+			AddOwnedTag(Tag);
+		}
+
 		int32& Count = TagCountContainer.FindOrAdd(Tag);
 		Count += CountToAdd;
+		UpdateReplicatedTagCount(Tag);
 	}
 
-	if (!bContainedBefore)
+	if (TagsAdded.Num())
 	{
-		OnTagContainerUpdated.Broadcast(GetContainedTags());
+		BroadcastTagsChanged(TagsAdded, TArrayView<const FGameplayTag>());
 	}
 }
 
-void UFireflyAbilitySystemComponent::RemoveTagsFromManager(FGameplayTagContainer TagsToRemove, int32 CountToRemove)
+void UFireflyAbilitySystemComponent::RemoveTagsFromManager(const FGameplayTagContainer& TagsToRemove, int32 CountToRemove)
 {
-	TArray<FGameplayTag> TagsToUpdate;
-	TagsToRemove.GetGameplayTagArray(TagsToUpdate);
-
 	TArray<FGameplayTag> TagsToClear;
-	for (auto Tag : TagsToUpdate)
+	for (const FGameplayTag& Tag : TagsToRemove)
 	{
 		int32* CountToMinus = TagCountContainer.Find(Tag);
 		*CountToMinus = FMath::Clamp<int32>(*CountToMinus - CountToRemove, 0, *CountToMinus);
 		if (*CountToMinus == 0)
+		{
+			TagCountContainer.Remove(Tag);
+		}
+		UpdateReplicatedTagCount(Tag);
+
+		if (!HasTagExact(Tag))
 		{
 			TagsToClear.AddUnique(Tag);
 		}
@@ -2029,14 +3561,291 @@ void UFireflyAbilitySystemComponent::RemoveTagsFromManager(FGameplayTagContainer
 
 	if (TagsToClear.Num())
 	{
-		for (auto Tag : TagsToClear)
+		RemoveOwnedTags(TagsToClear);
+		BroadcastTagsChanged(TArrayView<const FGameplayTag>(), TagsToClear);
+	}
+}
+
+void UFireflyAbilitySystemComponent::AddOwnedTag(const FGameplayTag& Tag)
+{
+	FFireflyGameplayTagBitRegistry& Registry = FFireflyGameplayTagBitRegistry::Get();
+
+	OwnedTags.AddTag(Tag);
+	OwnedTagBits.SetBit(Registry.FindOrAddBitIndex(Tag));
+
+	/** 某个位第一次被拥有的Tag作为自身或父级Tag引用时才设置 */
+	Registry.GetTagAndParentBits(Tag).ForEachSetBit([this](const int32 BitIndex)
+	{
+		if (OwnedTagParentBitCounts.Num() <= BitIndex)
 		{
-			TagCountContainer.Remove(Tag);
+			OwnedTagParentBitCounts.SetNumZeroed(BitIndex + 1);
+		}
+		if (++OwnedTagParentBitCounts[BitIndex] == 1)
+		{
+			OwnedTagBitsWithParents.SetBit(BitIndex);
+		}
+	});
+}
+
+void UFireflyAbilitySystemComponent::RemoveOwnedTags(TArrayView<const FGameplayTag> Tags)
+{
+	FFireflyGameplayTagBitRegistry& Registry = FFireflyGameplayTagBitRegistry::Get();
+
+	/** 只更新被移除的Tag及其父级Tag的计数，不再引用某个位时清除该位，不重建整个位集合 */
+	for (const FGameplayTag& Tag : Tags)
+	{
+		OwnedTagBits.ClearBit(Registry.FindOrAddBitIndex(Tag));
+
+		Registry.GetTagAndParentBits(Tag).ForEachSetBit([this](const int32 BitIndex)
+		{
+			if (OwnedTagParentBitCounts.IsValidIndex(BitIndex) && OwnedTagParentBitCounts[BitIndex] > 0
+				&& --OwnedTagParentBitCounts[BitIndex] == 0)
+			{
+				OwnedTagBitsWithParents.ClearBit(BitIndex);
+			}
+		});
+	}
+
+	/** 批量移除，父级Tag只重建一次 */
+	if (Tags.Num() == 1)
+	{
+		OwnedTags.RemoveTag(Tags[0]);
+	}
+	else
+	{
+		OwnedTags.RemoveTags(FGameplayTagContainer::CreateFromArray(TArray<FGameplayTag>(Tags)));
+	}
+}
+
+void UFireflyAbilitySystemComponent::SetReplicatedTagCount(const FGameplayTag& Tag, int32 NewCount)
+{
+	if (!Tag.IsValid() || HasAuthority())
+	{
+		return;
+	}
+
+	/** 同步的堆叠数与本地的堆叠数分开记录，任意一方大于0时管理器拥有该Tag，不会把本地预测的Tag重复计数 */
+	const bool bContainedBefore = HasTagExact(Tag);
+	if (NewCount > 0)
+	{
+		ReplicatedTagCountContainer.Add(Tag, NewCount);
+	}
+	else
+	{
+		ReplicatedTagCountContainer.Remove(Tag);
+	}
+
+	const bool bContainedAfter = HasTagExact(Tag);
+	if (bContainedBefore == bContainedAfter)
+	{
+		return;
+	}
+
+	if (bContainedAfter)
+	{
+		AddOwnedTag(Tag);
+		BroadcastTagsChanged(MakeArrayView(&Tag, 1), TArrayView<const FGameplayTag>());
+	}
+	else
+	{
+		RemoveOwnedTags(MakeArrayView(&Tag, 1));
+		BroadcastTagsChanged(TArrayView<const FGameplayTag>(), MakeArrayView(&Tag, 1));
+	}
+}
+
+void UFireflyAbilitySystemComponent::UpdateReplicatedTagCount(const FGameplayTag& Tag)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	const int32 NewCount = TagCountContainer.FindRef(Tag);
+	if (const int32* EntryIndex = ReplicatedTagCountIndices.Find(Tag))
+	{
+		FFireflyReplicatedTagCountEntry& Entry = ReplicatedTagCounts.Items[*EntryIndex];
+		if (Entry.Count != NewCount)
+		{
+			Entry.Count = NewCount;
+			ReplicatedTagCounts.MarkItemDirty(Entry);
+		}
+		return;
+	}
+
+	if (NewCount == 0)
+	{
+		return;
+	}
+
+	const int32 NewIndex = ReplicatedTagCounts.Items.AddDefaulted();
+	FFireflyReplicatedTagCountEntry& NewEntry = ReplicatedTagCounts.Items[NewIndex];
+	NewEntry.Tag = Tag;
+	NewEntry.Count = NewCount;
+	ReplicatedTagCounts.MarkItemDirty(NewEntry);
+	ReplicatedTagCountIndices.Add(Tag, NewIndex);
+}
+
+FFireflyGameplayTagChangeNativeDelegate& UFireflyAbilitySystemComponent::GetTagChangeDelegate(FGameplayTag Tag)
+{
+	TUniquePtr<FFireflyGameplayTagChangeNativeDelegate>& NativeDelegate = TagChangeDelegates.FindOrAdd(Tag);
+	if (!NativeDelegate.IsValid())
+	{
+		NativeDelegate = MakeUnique<FFireflyGameplayTagChangeNativeDelegate>();
+	}
+
+	return *NativeDelegate;
+}
+
+void UFireflyAbilitySystemComponent::BroadcastTagsChanged(TArrayView<const FGameplayTag> AddedTags,
+	TArrayView<const FGameplayTag> RemovedTags)
+{
+	ReevaluateEffectOngoingRequirements(AddedTags);
+	ReevaluateEffectOngoingRequirements(RemovedTags);
+
+	if (TagChangeDelegates.Num())
+	{
+		for (const FGameplayTag& Tag : AddedTags)
+		{
+			if (const TUniquePtr<FFireflyGameplayTagChangeNativeDelegate>* NativeDelegate = TagChangeDelegates.Find(Tag))
+			{
+				(*NativeDelegate)->Broadcast(Tag, true);
+			}
+		}
+		for (const FGameplayTag& Tag : RemovedTags)
+		{
+			if (const TUniquePtr<FFireflyGameplayTagChangeNativeDelegate>* NativeDelegate = TagChangeDelegates.Find(Tag))
+			{
+				(*NativeDelegate)->Broadcast(Tag, false);
+			}
 		}
+	}
+
+	OnTagsChangedNative.Broadcast(AddedTags, RemovedTags);
+
+	if (OnTagsChanged.IsBound())
+	{
+		OnTagsChanged.Broadcast(FGameplayTagContainer::CreateFromArray(TArray<FGameplayTag>(AddedTags)),
+			FGameplayTagContainer::CreateFromArray(TArray<FGameplayTag>(RemovedTags)));
+	}
+
+	if (OnTagContainerUpdated.IsBound())
+	{
 		OnTagContainerUpdated.Broadcast(GetContainedTags());
 	}
 }
 
+bool UFireflyAbilitySystemComponent::HasAnyTagsExact(const FGameplayTagContainer& Tags) const
+{
+	for (const FGameplayTag& Tag : Tags)
+	{
+		if (HasTagExact(Tag))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool UFireflyAbilitySystemComponent::HasAllTagsExact(const FGameplayTagContainer& Tags) const
+{
+	for (const FGameplayTag& Tag : Tags)
+	{
+		if (!HasTagExact(Tag))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void UFireflyAbilitySystemComponent::RegisterEffectOngoingRequirement(UFireflyEffect* Effect)
+{
+	if (!IsValid(Effect) || Effect->bOngoingRequirementRegistered || !Effect->HasOngoingRequirement())
+	{
+		return;
+	}
+
+	const FFireflyEffectDefinition& EffectDefinition = Effect->GetDefinition();
+	for (const FGameplayTag& Tag : EffectDefinition.TagsRequiredOngoing)
+	{
+		OngoingRequirementEffectsByTag.FindOrAdd(Tag).AddUnique(Effect);
+	}
+	for (const FGameplayTag& Tag : EffectDefinition.TagsBlockedOngoing)
+	{
+		OngoingRequirementEffectsByTag.FindOrAdd(Tag).AddUnique(Effect);
+	}
+
+	Effect->bOngoingRequirementRegistered = true;
+}
+
+void UFireflyAbilitySystemComponent::UnregisterEffectOngoingRequirement(UFireflyEffect* Effect)
+{
+	if (!IsValid(Effect) || !Effect->bOngoingRequirementRegistered)
+	{
+		return;
+	}
+
+	auto RemoveFromTag = [this, Effect](const FGameplayTag& Tag)
+	{
+		TArray<UFireflyEffect*>* Effects = OngoingRequirementEffectsByTag.Find(Tag);
+		if (!Effects)
+		{
+			return;
+		}
+
+		Effects->RemoveSingleSwap(Effect, false);
+		if (!Effects->Num())
+		{
+			OngoingRequirementEffectsByTag.Remove(Tag);
+		}
+	};
+
+	const FFireflyEffectDefinition& EffectDefinition = Effect->GetDefinition();
+	for (const FGameplayTag& Tag : EffectDefinition.TagsRequiredOngoing)
+	{
+		RemoveFromTag(Tag);
+	}
+	for (const FGameplayTag& Tag : EffectDefinition.TagsBlockedOngoing)
+	{
+		RemoveFromTag(Tag);
+	}
+
+	Effect->bOngoingRequirementRegistered = false;
+}
+
+void UFireflyAbilitySystemComponent::ReevaluateEffectOngoingRequirements(TArrayView<const FGameplayTag> ChangedTags)
+{
+	if (!OngoingRequirementEffectsByTag.Num())
+	{
+		return;
+	}
+
+	/** 先收集受影响的效果再检验，检验过程中效果可能改变管理器的Tag或被移除 */
+	TArray<UFireflyEffect*, TInlineAllocator<8>> AffectedEffects;
+	for (const FGameplayTag& Tag : ChangedTags)
+	{
+		if (const TArray<UFireflyEffect*>* Effects = OngoingRequirementEffectsByTag.Find(Tag))
+		{
+			for (UFireflyEffect* Effect : *Effects)
+			{
+				AffectedEffects.AddUnique(Effect);
+			}
+		}
+	}
+
+	for (UFireflyEffect* Effect : AffectedEffects)
+	{
+		if (!IsValid(Effect) || !Effect->bOngoingRequirementRegistered || Effect->GetOwnerManager() != this)
+		{
+			continue;
+		}
+
+		Effect->EvaluateOngoingRequirement();
+	}
+}
+
 void UFireflyAbilitySystemComponent::TryTriggerAbilityByMessage(UFireflyAbility* Ability,
 	const FFireflyMessageEventData EventData)
 {
@@ -2079,7 +3888,7 @@ void UFireflyAbilitySystemComponent::Server_TryTriggerAbilityByMessage_Implement
 		return;
 	}
 
-	if (Ability->TagsForAbilityAsset.HasAnyExact(GetBlockAbilityTags()))
+	if (Ability->GetTagsForAbilityAssetBits().HasAny(BlockAbilityTagBits))
 	{
 		return;
 	}
@@ -7,15 +7,50 @@
 #include "FireflyAbility.h"
 #include "FireflyAbilitySystemComponent.h"
 
+/** Actor及其技能系统管理器的缓存，仅在游戏线程访问 */
+static TMap<TObjectKey<AActor>, TWeakObjectPtr<UFireflyAbilitySystemComponent>> GFireflyAbilitySystemRegistry;
+
 UFireflyAbilitySystemComponent* UFireflyAbilitySystemLibrary::GetFireflyAbilitySystem(const AActor* Actor)
 {
-	if (!IsValid(Actor->GetComponentByClass(UFireflyAbilitySystemComponent::StaticClass())))
+	if (!IsValid(Actor))
 	{
 		return nullptr;
 	}
 
-	return CastChecked<UFireflyAbilitySystemComponent>(Actor->GetComponentByClass(
-		UFireflyAbilitySystemComponent::StaticClass()));
+	if (const TWeakObjectPtr<UFireflyAbilitySystemComponent>* CachedAbilitySystem = GFireflyAbilitySystemRegistry.Find(Actor))
+	{
+		if (UFireflyAbilitySystemComponent* AbilitySystem = CachedAbilitySystem->Get())
+		{
+			return AbilitySystem;
+		}
+	}
+
+	return Actor->FindComponentByClass<UFireflyAbilitySystemComponent>();
+}
+
+void UFireflyAbilitySystemLibrary::RegisterFireflyAbilitySystem(UFireflyAbilitySystemComponent* AbilitySystem)
+{
+	if (!IsValid(AbilitySystem) || !IsValid(AbilitySystem->GetOwner()))
+	{
+		return;
+	}
+
+	GFireflyAbilitySystemRegistry.Add(AbilitySystem->GetOwner(), AbilitySystem);
+}
+
+void UFireflyAbilitySystemLibrary::UnregisterFireflyAbilitySystem(UFireflyAbilitySystemComponent* AbilitySystem)
+{
+	if (!AbilitySystem)
+	{
+		return;
+	}
+
+	const TObjectKey<AActor> OwnerKey(AbilitySystem->GetOwner());
+	const TWeakObjectPtr<UFireflyAbilitySystemComponent>* CachedAbilitySystem = GFireflyAbilitySystemRegistry.Find(OwnerKey);
+	if (CachedAbilitySystem && (!CachedAbilitySystem->IsValid() || CachedAbilitySystem->Get() == AbilitySystem))
+	{
+		GFireflyAbilitySystemRegistry.Remove(OwnerKey);
+	}
 }
 
 TSubclassOf<UFireflyAbility> UFireflyAbilitySystemLibrary::GetAbilityClassFromCache(FName AbilityID)
@@ -65,6 +100,37 @@ FString UFireflyAbilitySystemLibrary::GetAttributeTypeName(EFireflyAttributeType
 	return EnumPtr->GetDisplayNameTextByValue(AttributeType).ToString();
 }
 
+EFireflyAttributeType UFireflyAbilitySystemLibrary::GetAttributeTypeByName(FName AttributeName)
+{
+	static TMap<FName, EFireflyAttributeType> AttributeTypesByName;
+	if (AttributeTypesByName.Num() == 0)
+	{
+		const UEnum* EnumPtr = FindObject<UEnum>(ANY_PACKAGE, TEXT("EFireflyAttributeType"), true);
+		if (!EnumPtr)
+		{
+			return AttributeType_Max;
+		}
+
+		for (int32 i = 0; i < EnumPtr->NumEnums() - 1; ++i)
+		{
+			const int64 EnumValue = EnumPtr->GetValueByIndex(i);
+			if (EnumValue >= AttributeType_Max)
+			{
+				continue;
+			}
+
+			const FName DisplayName = FName(EnumPtr->GetDisplayNameTextByIndex(i).ToString());
+			if (!AttributeTypesByName.Contains(DisplayName))
+			{
+				AttributeTypesByName.Emplace(DisplayName, static_cast<EFireflyAttributeType>(EnumValue));
+			}
+		}
+	}
+
+	const EFireflyAttributeType* AttributeType = AttributeTypesByName.Find(AttributeName);
+	return AttributeType ? *AttributeType : AttributeType_Max;
+}
+
 float UFireflyAbilitySystemLibrary::GetAttributeValue(const AActor* Actor, EFireflyAttributeType AttributeType)
 {
 	const UFireflyAbilitySystemComponent* FireflyAbilitySystem = GetFireflyAbilitySystem(Actor);
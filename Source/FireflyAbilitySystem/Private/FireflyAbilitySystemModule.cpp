@@ -22,6 +22,13 @@ DEFINE_LOG_CATEGORY(LogFireflyAttribute);
 DEFINE_LOG_CATEGORY(LogFireflyAbility);
 DEFINE_LOG_CATEGORY(LogFireflyEffect);
 
+DEFINE_STAT(STAT_FireflyModifierCalculatorsCreated);
+DEFINE_STAT(STAT_FireflyEffectSchedulerFireDueEvents);
+DEFINE_STAT(STAT_FireflyEffectSchedulerHeapPop);
+DEFINE_STAT(STAT_FireflyEffectSchedulerHeapPush);
+DEFINE_STAT(STAT_FireflyEffectSchedulerEventsFired);
+DEFINE_STAT(STAT_FireflyEffectSchedulerQueuedEvents);
+
 FString GetContextNetRoleStringFireflyAS(UObject* ContextObject)
 {
 	ENetRole Role = ROLE_None;
@@ -5,6 +5,45 @@
 
 #include "FireflyAbilitySystemTypes.h"
 #include "FireflyAbilitySystemComponent.h"
+#include "FireflyAbilitySystemLibrary.h"
+#include "FireflyAbilitySystemModule.h"
+#include "FireflyAttributeStoreSubsystem.h"
+#include "UObject/UObjectIterator.h"
+
+#if !UE_BUILD_SHIPPING
+static bool GFireflyVerifyModifierAggregates = false;
+static FAutoConsoleVariableRef CVarFireflyVerifyModifierAggregates(
+	TEXT("Firefly.Attribute.VerifyModifierAggregates"),
+	GFireflyVerifyModifierAggregates,
+	TEXT("每次更新属性当前值时，校验增量维护的修改器合值与完整重新计算的结果是否一致"));
+
+static FAutoConsoleCommand CmdFireflyReportAttributeMemory(
+	TEXT("Firefly.Attribute.ReportMemory"),
+	TEXT("输出所有属性实例的平均内存占用，以及修改器存储产生的堆分配"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		int32 NumAttributes = 0;
+		int32 NumHeapAllocations = 0;
+		SIZE_T ObjectBytes = 0;
+		SIZE_T HeapBytes = 0;
+
+		for (TObjectIterator<UFireflyAttribute> It(RF_ClassDefaultObject); It; ++It)
+		{
+			const SIZE_T ModifierHeapSize = It->GetModifierHeapSize();
+
+			++NumAttributes;
+			ObjectBytes += It->GetClass()->GetStructureSize();
+			HeapBytes += ModifierHeapSize;
+			NumHeapAllocations += ModifierHeapSize > 0 ? 1 : 0;
+		}
+
+		UE_LOG(LogFireflyAttribute, Display, TEXT("Firefly.Attribute.ReportMemory: %d attributes, %.1f object bytes and %.1f modifier heap bytes per attribute, %d attributes with modifier heap allocation"),
+			NumAttributes,
+			NumAttributes > 0 ? static_cast<double>(ObjectBytes) / NumAttributes : 0.0,
+			NumAttributes > 0 ? static_cast<double>(HeapBytes) / NumAttributes : 0.0,
+			NumHeapAllocations);
+	}));
+#endif
 
 UFireflyAttribute::UFireflyAttribute(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -45,6 +84,14 @@ int32 UFireflyAttribute::GetFunctionCallspace(UFunction* Function, FFrame* Stack
 	return (GetOuter() ? GetOuter()->GetFunctionCallspace(Function, Stack) : FunctionCallspace::Local);
 }
 
+void UFireflyAttribute::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	UFireflyAttribute* This = CastChecked<UFireflyAttribute>(InThis);
+	This->Modifiers.AddReferencedObjects(Collector, This);
+
+	Super::AddReferencedObjects(InThis, Collector);
+}
+
 void UFireflyAttribute::InitAttributeInstance()
 {
 	 ReceiveInitAttributeInstance();
@@ -56,9 +103,11 @@ void UFireflyAttribute::InitializeAttributeValue(float InitValue)
 
 	OldValue = BaseValue;
 	BaseValue = InitValue;
-	if (BaseValue != OldValue)
+
+	/** 处于属性修改事务中时，基础值的变化由事务提交时统一广播 */
+	if (BaseValue != OldValue && !GetOwnerManager()->IsInModifierTransaction())
 	{
-		GetOwnerManager()->OnAttributeBaseValueChanged.Broadcast(AttributeType, BaseValue, OldValue);
+		GetOwnerManager()->BroadcastAttributeBaseValueChanged(AttributeType, BaseValue, OldValue);
 	}
 
 	OldValue = CurrentValue;
@@ -67,7 +116,7 @@ void UFireflyAttribute::InitializeAttributeValue(float InitValue)
 	{
 		return;
 	}
-	GetOwnerManager()->OnAttributeValueChanged.Broadcast(AttributeType, CurrentValue, OldValue);
+	GetOwnerManager()->BroadcastAttributeValueChanged(AttributeType, CurrentValue, OldValue);
 }
 
 AActor* UFireflyAttribute::GetOwnerActor() const
@@ -102,24 +151,36 @@ TEnumAsByte<EFireflyAttributeType> UFireflyAttribute::GetAttributeType() const
 
 float UFireflyAttribute::GetCurrentValue() const
 {
+	/** 托管到世界属性存储时，缓存的当前值要到存储的Tick才会更新，直接读取存储中的最新值 */
+	if (AttributeStore && AttributeStoreSlot != INDEX_NONE)
+	{
+		return AttributeStore->ReadAttributeValue(AttributeStoreSlot);
+	}
+
 	return CurrentValue;
 }
 
 float UFireflyAttribute::GetBaseValueToUse() const
 {
-	bool bInnerOverriderValid = false;
-	float BaseValueToUse = 0.f;
-	for (int i = 0; i < InnerOverrideMods.Num(); ++i)
+	return Modifiers.GetBaseValueToUse(BaseValue);
+}
+
+void UFireflyAttribute::GetDependencySourceTypes(TArray<EFireflyAttributeType, TInlineAllocator<4>>& OutSourceTypes) const
+{
+	OutSourceTypes.Reset();
+
+	if (bAttributeHasRange && RangeMaxValueType != AttributeType_Default)
 	{
-		if (InnerOverrideMods[i].bIsActive)
-		{
-			bInnerOverriderValid = true;
-			BaseValueToUse = InnerOverrideMods[i].ModValue * InnerOverrideMods[i].StackCount;
+		OutSourceTypes.AddUnique(RangeMaxValueType);
+	}
 
-			break;
+	for (const TEnumAsByte<EFireflyAttributeType> SourceType : DerivedSourceTypes)
+	{
+		if (SourceType != AttributeType_Default && SourceType < AttributeType_Max)
+		{
+			OutSourceTypes.AddUnique(SourceType);
 		}
 	}
-	return bInnerOverriderValid ? BaseValueToUse : BaseValue;
 }
 
 void UFireflyAttribute::UpdateCurrentValue_Implementation()
@@ -129,31 +190,34 @@ void UFireflyAttribute::UpdateCurrentValue_Implementation()
 		return;
 	}
 
+	/** 托管到世界属性存储的属性，只写入计算数据，当前值由世界属性存储批量计算并同步 */
+	if (AttributeStoreSlot != INDEX_NONE)
+	{
+		WriteToAttributeStore();
+		return;
+	}
+
 	const float OldValue = CurrentValue;
 
-	if (OuterOverrideMods.IsValidIndex(0))
+	float OuterOverrideValue = 0.f;
+	if (Modifiers.GetOuterOverrideValue(OuterOverrideValue))
 	{
-		CurrentValue = OuterOverrideMods[0].ModValue;
+		CurrentValue = OuterOverrideValue;
 		if (CurrentValue != OldValue)
 		{
-			GetOwnerManager()->OnAttributeValueChanged.Broadcast(AttributeType, CurrentValue, OldValue);
+			GetOwnerManager()->BroadcastAttributeValueChanged(AttributeType, CurrentValue, OldValue);
 		}
 		return;
 	}
 
-	float TotalPlusMod = GetTotalPlusModifier();
-	float TotalMinusMod = GetTotalMinusModifier();
-	float TotalMultiplyMod = GetTotalMultiplyModifier();
-	float TotalDivideMod = GetTotalDivideModifier();
+	Modifiers.VerifyAggregates(AttributeType);
 
-	float BaseValueToUse = GetBaseValueToUse();
-
-	CurrentValue = (BaseValueToUse + TotalPlusMod - TotalMinusMod) * (1.f + TotalMultiplyMod) / TotalDivideMod;
+	CurrentValue = Modifiers.EvaluateCurrentValue(BaseValue);
 
 	if (bAttributeHasRange)
 	{
 		float FinalRangeMax = RangeMaxValueType != AttributeType_Default ?
-			GetOwnerManager()->GetAttributeValue(RangeMaxValueType) : RangeMaxValue;
+			GetOwnerManager()->GetLiveAttributeValue(RangeMaxValueType) : RangeMaxValue;
 		CurrentValue = FMath::Clamp<float>(CurrentValue, RangeMinValue, FinalRangeMax);
 	}
 	else if (bAttributeMustNotLessThanSelection)
@@ -166,7 +230,7 @@ void UFireflyAttribute::UpdateCurrentValue_Implementation()
 		return;
 	}
 
-	GetOwnerManager()->OnAttributeValueChanged.Broadcast(AttributeType, CurrentValue, OldValue);
+	GetOwnerManager()->BroadcastAttributeValueChanged(AttributeType, CurrentValue, OldValue);
 }
 
 void UFireflyAttribute::UpdateBaseValue_Implementation(EFireflyAttributeModOperator ModOperator, float ModValue)
@@ -176,152 +240,488 @@ void UFireflyAttribute::UpdateBaseValue_Implementation(EFireflyAttributeModOpera
 		return;
 	}
 
-	if (InnerOverrideMods.Num() != 0)
+	if (Modifiers.GetModifierCount(EFireflyAttributeModOperator::InnerOverride) != 0)
 	{
 		return;
 	}
 
 	const float OldValue = BaseValue;
 
-	switch (ModOperator)
+	BaseValue = FFireflyAttributeModifierContainer::ApplyModOperatorToValue(BaseValue, ModOperator, ModValue);
+
+	if (bAttributeHasRange)
 	{
-	case EFireflyAttributeModOperator::None:
+		float FinalRangeMax = RangeMaxValueType != EFireflyAttributeType::AttributeType_Default ?
+			GetOwnerManager()->GetLiveAttributeValue(RangeMaxValueType) : RangeMaxValue;
+		BaseValue = FMath::Clamp<float>(BaseValue, RangeMinValue, FinalRangeMax);
+	}
+	else if (bAttributeMustNotLessThanSelection)
 	{
-		break;
+		BaseValue = BaseValue < LessBaseValue ? LessBaseValue : BaseValue;
 	}
-	case EFireflyAttributeModOperator::Plus:
+
+	/** 处于属性修改事务中时，基础值的变化由事务提交时统一广播 */
+	if (BaseValue == OldValue || GetOwnerManager()->IsInModifierTransaction())
 	{
-		BaseValue += ModValue;
-		break;
+		return;
 	}
-	case EFireflyAttributeModOperator::Minus:
+
+	GetOwnerManager()->BroadcastAttributeBaseValueChanged(AttributeType, BaseValue, OldValue);
+}
+
+bool UFireflyAttribute::IsValueInAttributeRange(float InValue) const
+{
+	if (!bAttributeHasRange)
 	{
-		BaseValue -= ModValue;
-		break;
+		return true;
 	}
-	case EFireflyAttributeModOperator::Multiply:
+
+	const float FinalRangeMax = RangeMaxValue == 0.f ?
+		GetOwnerManager()->GetLiveAttributeValue(RangeMaxValueType) : RangeMaxValue;
+
+	return InValue >= RangeMinValue && InValue <= FinalRangeMax;
+}
+
+float UFireflyAttribute::GetTotalPlusModifier() const
+{
+	return Modifiers.GetTotalPlus();
+}
+
+float UFireflyAttribute::GetTotalMinusModifier() const
+{
+	return Modifiers.GetTotalMinus();
+}
+
+float UFireflyAttribute::GetTotalMultiplyModifier() const
+{
+	return Modifiers.GetTotalMultiply();
+}
+
+float UFireflyAttribute::GetTotalDivideModifier() const
+{
+	return Modifiers.GetTotalDivide();
+}
+
+bool UFireflyAttribute::GetNewestOuterOverrideModifier(float& NewestValue) const
+{
+	const int32 SlotIndex = Modifiers.FindFirstAppliedModifier(EFireflyAttributeModOperator::OuterOverride, true);
+	if (SlotIndex == INDEX_NONE)
 	{
-		BaseValue *= ModValue;
-		break;
+		return false;
 	}
-	case EFireflyAttributeModOperator::Divide:
+
+	const FFireflyAttributeModifier& Modifier = Modifiers.GetModifierAt(SlotIndex);
+	NewestValue = Modifier.ModValue * Modifier.StackCount;
+
+	return true;
+}
+
+bool UFireflyAttribute::CanUseAttributeStore() const
+{
+	/** 原生子类可能重写了当前值的计算逻辑，世界属性存储只按默认逻辑计算 */
+	const UClass* NativeClass = GetClass();
+	while (NativeClass && !NativeClass->HasAnyClassFlags(CLASS_Native))
 	{
-		BaseValue /= (ModValue == 0.f ? 1.f : ModValue);
-		break;
+		NativeClass = NativeClass->GetSuperClass();
 	}
-	case EFireflyAttributeModOperator::InnerOverride:
-	case EFireflyAttributeModOperator::OuterOverride:
+	if (NativeClass != UFireflyAttribute::StaticClass())
 	{
-		BaseValue = ModValue;
-		break;
+		return false;
 	}
+
+	return !GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UFireflyAttribute, UpdateCurrentValue));
+}
+
+void UFireflyAttribute::WriteToAttributeStore()
+{
+	if (!AttributeStore || AttributeStoreSlot == INDEX_NONE)
+	{
+		return;
 	}
 
+	float OuterOverrideValue = 0.f;
+	if (Modifiers.GetOuterOverrideValue(OuterOverrideValue))
+	{
+		AttributeStore->WriteAttributeOperands(AttributeStoreSlot, OuterOverrideValue,
+			0.f, 0.f, 0.f, 1.f, -MAX_flt, MAX_flt);
+		return;
+	}
+
+	Modifiers.VerifyAggregates(AttributeType);
+
+	float FinalRangeMin = -MAX_flt;
+	float FinalRangeMax = MAX_flt;
 	if (bAttributeHasRange)
 	{
-		float FinalRangeMax = RangeMaxValueType != EFireflyAttributeType::AttributeType_Default ?
-			GetOwnerManager()->GetAttributeValue(RangeMaxValueType) : RangeMaxValue;
-		BaseValue = FMath::Clamp<float>(BaseValue, RangeMinValue, FinalRangeMax);
+		FinalRangeMin = RangeMinValue;
+		FinalRangeMax = RangeMaxValueType != AttributeType_Default ?
+			GetOwnerManager()->GetLiveAttributeValue(RangeMaxValueType) : RangeMaxValue;
 	}
 	else if (bAttributeMustNotLessThanSelection)
 	{
-		BaseValue = BaseValue < LessBaseValue ? LessBaseValue : BaseValue;
+		FinalRangeMin = LessBaseValue;
+	}
+
+	AttributeStore->WriteAttributeOperands(AttributeStoreSlot, GetBaseValueToUse(), GetTotalPlusModifier(),
+		GetTotalMinusModifier(), GetTotalMultiplyModifier(), GetTotalDivideModifier(), FinalRangeMin, FinalRangeMax);
+}
+
+int32 FFireflyAttributeModifierContainer::AddModifier(EFireflyAttributeModOperator ModOperator, UObject* ModSource,
+	float ModValue, int32 StackCount)
+{
+	if (ModOperator == EFireflyAttributeModOperator::None)
+	{
+		return INDEX_NONE;
+	}
+
+	int32 SlotIndex = FirstFreeModifierSlot;
+	if (SlotIndex != INDEX_NONE)
+	{
+		FirstFreeModifierSlot = ModifierSlots[SlotIndex].StackCount;
+	}
+	else
+	{
+		SlotIndex = ModifierSlots.AddDefaulted();
 	}
 
-	if (BaseValue == OldValue)
+	FFireflyAttributeModifier& Modifier = ModifierSlots[SlotIndex];
+	Modifier.ModSource = ModSource;
+	Modifier.ModValue = ModValue;
+	Modifier.StackCount = StackCount;
+	Modifier.ApplyOrder = NextModifierApplyOrder++;
+	Modifier.bIsActive = true;
+	Modifier.ModOperator = ModOperator;
+
+	++ModifierCounts[static_cast<uint8>(ModOperator)];
+	UpdateAggregate(ModOperator, 0.f, Modifier.GetAggregateContribution());
+
+	return SlotIndex;
+}
+
+void FFireflyAttributeModifierContainer::RemoveModifierAt(int32 SlotIndex)
+{
+	if (!ModifierSlots.IsValidIndex(SlotIndex) || ModifierSlots[SlotIndex].ModOperator == EFireflyAttributeModOperator::None)
 	{
 		return;
 	}
 
-	GetOwnerManager()->OnAttributeBaseValueChanged.Broadcast(AttributeType, BaseValue, OldValue);
+	FFireflyAttributeModifier& Modifier = ModifierSlots[SlotIndex];
+	const EFireflyAttributeModOperator ModOperator = Modifier.ModOperator;
+	const float OldContribution = Modifier.GetAggregateContribution();
+
+	Modifier.ModSource = nullptr;
+	Modifier.ModValue = 0.f;
+	Modifier.StackCount = FirstFreeModifierSlot;
+	Modifier.bIsActive = true;
+	Modifier.ModOperator = EFireflyAttributeModOperator::None;
+	++Modifier.Generation;
+	FirstFreeModifierSlot = SlotIndex;
+
+	--ModifierCounts[static_cast<uint8>(ModOperator)];
+	UpdateAggregate(ModOperator, OldContribution, 0.f);
 }
 
-bool UFireflyAttribute::IsValueInAttributeRange(float InValue) const
+void FFireflyAttributeModifierContainer::SetModifierStackAt(int32 SlotIndex, int32 NewStackCount)
 {
-	if (!bAttributeHasRange)
+	if (!ModifierSlots.IsValidIndex(SlotIndex) || ModifierSlots[SlotIndex].ModOperator == EFireflyAttributeModOperator::None)
 	{
-		return true;
+		return;
 	}
 
-	const float FinalRangeMax = RangeMaxValue == 0.f ?
-		GetOwnerManager()->GetAttributeValue(RangeMaxValueType) : RangeMaxValue;
+	FFireflyAttributeModifier& Modifier = ModifierSlots[SlotIndex];
+	const float OldContribution = Modifier.GetAggregateContribution();
+	Modifier.StackCount = NewStackCount;
+	UpdateAggregate(Modifier.ModOperator, OldContribution, Modifier.GetAggregateContribution());
+}
 
-	return InValue >= RangeMinValue && InValue <= FinalRangeMax;
+void FFireflyAttributeModifierContainer::SetModifierValueAt(int32 SlotIndex, float NewModValue, int32 NewStackCount)
+{
+	if (!ModifierSlots.IsValidIndex(SlotIndex) || ModifierSlots[SlotIndex].ModOperator == EFireflyAttributeModOperator::None)
+	{
+		return;
+	}
+
+	FFireflyAttributeModifier& Modifier = ModifierSlots[SlotIndex];
+	const float OldContribution = Modifier.GetAggregateContribution();
+	Modifier.ModValue = NewModValue;
+	Modifier.StackCount = NewStackCount;
+	UpdateAggregate(Modifier.ModOperator, OldContribution, Modifier.GetAggregateContribution());
 }
 
-float UFireflyAttribute::GetTotalPlusModifier() const
+void FFireflyAttributeModifierContainer::SetModifierActiveAt(int32 SlotIndex, bool bNewActiveState)
 {
-	float TotalPlusMod = 0.f;
-	for (const auto PlusMod : PlusMods)
+	if (!ModifierSlots.IsValidIndex(SlotIndex) || ModifierSlots[SlotIndex].ModOperator == EFireflyAttributeModOperator::None)
 	{
-		if (!PlusMod.bIsActive)
+		return;
+	}
+
+	FFireflyAttributeModifier& Modifier = ModifierSlots[SlotIndex];
+	const float OldContribution = Modifier.GetAggregateContribution();
+	Modifier.bIsActive = bNewActiveState;
+	UpdateAggregate(Modifier.ModOperator, OldContribution, Modifier.GetAggregateContribution());
+}
+
+int32 FFireflyAttributeModifierContainer::FindModifier(EFireflyAttributeModOperator ModOperator, const UObject* ModSource,
+	float ModValue) const
+{
+	for (int32 SlotIndex = 0; SlotIndex < ModifierSlots.Num(); ++SlotIndex)
+	{
+		const FFireflyAttributeModifier& Modifier = ModifierSlots[SlotIndex];
+		if (Modifier.ModOperator == ModOperator && Modifier.ModSource == ModSource && Modifier.ModValue == ModValue)
 		{
-			continue;
+			return SlotIndex;
 		}
-		TotalPlusMod += PlusMod.ModValue * PlusMod.StackCount;
 	}
 
-	return TotalPlusMod;
+	return INDEX_NONE;
 }
 
-float UFireflyAttribute::GetTotalMinusModifier() const
+int32 FFireflyAttributeModifierContainer::FindModifierBySource(EFireflyAttributeModOperator ModOperator,
+	const UObject* ModSource) const
 {
-	float TotalMinusMod = 0.f;
-	for (const auto MinusMod : MinusMods)
+	for (int32 SlotIndex = 0; SlotIndex < ModifierSlots.Num(); ++SlotIndex)
 	{
-		if (!MinusMod.bIsActive)
+		const FFireflyAttributeModifier& Modifier = ModifierSlots[SlotIndex];
+		if (Modifier.ModOperator == ModOperator && Modifier.ModSource == ModSource)
 		{
-			continue;
+			return SlotIndex;
 		}
-		TotalMinusMod += MinusMod.ModValue * MinusMod.StackCount;
 	}
 
-	return TotalMinusMod;
+	return INDEX_NONE;
 }
 
-float UFireflyAttribute::GetTotalMultiplyModifier() const
+int32 FFireflyAttributeModifierContainer::FindFirstAppliedModifier(EFireflyAttributeModOperator ModOperator,
+	bool bActiveOnly) const
 {
-	float TotalMultiplyMod = 0.f;
-	for (const auto MultiplyMod : MultiplyMods)
+	if (ModifierCounts[static_cast<uint8>(ModOperator)] == 0)
 	{
-		if (!MultiplyMod.bIsActive)
+		return INDEX_NONE;
+	}
+
+	int32 FirstSlot = INDEX_NONE;
+	for (int32 SlotIndex = 0; SlotIndex < ModifierSlots.Num(); ++SlotIndex)
+	{
+		const FFireflyAttributeModifier& Modifier = ModifierSlots[SlotIndex];
+		if (Modifier.ModOperator != ModOperator || (bActiveOnly && !Modifier.bIsActive))
 		{
 			continue;
 		}
-		TotalMultiplyMod += MultiplyMod.ModValue * MultiplyMod.StackCount;
+
+		if (FirstSlot == INDEX_NONE || Modifier.ApplyOrder < ModifierSlots[FirstSlot].ApplyOrder)
+		{
+			FirstSlot = SlotIndex;
+		}
 	}
 
-	return TotalMultiplyMod;
+	return FirstSlot;
 }
 
-float UFireflyAttribute::GetTotalDivideModifier() const
+FFireflyModifierHandle FFireflyAttributeModifierContainer::MakeModifierHandle(EFireflyAttributeType AttributeType,
+	int32 SlotIndex) const
+{
+	if (!ModifierSlots.IsValidIndex(SlotIndex) || ModifierSlots[SlotIndex].ModOperator == EFireflyAttributeModOperator::None)
+	{
+		return FFireflyModifierHandle();
+	}
+
+	return FFireflyModifierHandle(AttributeType, SlotIndex, ModifierSlots[SlotIndex].Generation);
+}
+
+bool FFireflyAttributeModifierContainer::IsModifierHandleValid(const FFireflyModifierHandle& ModifierHandle) const
+{
+	if (!ModifierSlots.IsValidIndex(ModifierHandle.SlotIndex))
+	{
+		return false;
+	}
+
+	const FFireflyAttributeModifier& Modifier = ModifierSlots[ModifierHandle.SlotIndex];
+
+	return Modifier.ModOperator != EFireflyAttributeModOperator::None && Modifier.Generation == ModifierHandle.Generation;
+}
+
+float FFireflyAttributeModifierContainer::GetBaseValueToUse(float BaseValue) const
+{
+	const int32 SlotIndex = FindFirstAppliedModifier(EFireflyAttributeModOperator::InnerOverride, true);
+	if (SlotIndex == INDEX_NONE)
+	{
+		return BaseValue;
+	}
+
+	return ModifierSlots[SlotIndex].ModValue * ModifierSlots[SlotIndex].StackCount;
+}
+
+bool FFireflyAttributeModifierContainer::GetOuterOverrideValue(float& OutValue) const
+{
+	const int32 SlotIndex = FindFirstAppliedModifier(EFireflyAttributeModOperator::OuterOverride, false);
+	if (SlotIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutValue = ModifierSlots[SlotIndex].ModValue;
+
+	return true;
+}
+
+float FFireflyAttributeModifierContainer::EvaluateCurrentValue(float BaseValue) const
+{
+	float OuterOverrideValue = 0.f;
+	if (GetOuterOverrideValue(OuterOverrideValue))
+	{
+		return OuterOverrideValue;
+	}
+
+	return (GetBaseValueToUse(BaseValue) + GetTotalPlus() - GetTotalMinus()) * (1.f + GetTotalMultiply()) / GetTotalDivide();
+}
+
+float FFireflyAttributeModifierContainer::ApplyModOperatorToValue(float Value, EFireflyAttributeModOperator ModOperator,
+	float ModValue)
+{
+	switch (ModOperator)
+	{
+	case EFireflyAttributeModOperator::None:
+	{
+		break;
+	}
+	case EFireflyAttributeModOperator::Plus:
+	{
+		Value += ModValue;
+		break;
+	}
+	case EFireflyAttributeModOperator::Minus:
+	{
+		Value -= ModValue;
+		break;
+	}
+	case EFireflyAttributeModOperator::Multiply:
+	{
+		Value *= ModValue;
+		break;
+	}
+	case EFireflyAttributeModOperator::Divide:
+	{
+		Value /= (ModValue == 0.f ? 1.f : ModValue);
+		break;
+	}
+	case EFireflyAttributeModOperator::InnerOverride:
+	case EFireflyAttributeModOperator::OuterOverride:
+	{
+		Value = ModValue;
+		break;
+	}
+	}
+
+	return Value;
+}
+
+void FFireflyAttributeModifierContainer::UpdateAggregate(EFireflyAttributeModOperator ModOperator, float OldContribution,
+	float NewContribution)
 {
-	float TotalDivideMod = 0.f;
-	for (const auto DivideMod : DivideMods)
+	// 某个运算符的修改器被清空时直接归零，避免增量计算累积浮点误差
+	const bool bOperatorEmpty = ModifierCounts[static_cast<uint8>(ModOperator)] == 0;
+	switch (ModOperator)
 	{
-		if (!DivideMod.bIsActive)
+	case EFireflyAttributeModOperator::Plus:
 		{
-			continue;
+			PlusAggregate = bOperatorEmpty ? 0.f : PlusAggregate - OldContribution + NewContribution;
+			break;
+		}
+	case EFireflyAttributeModOperator::Minus:
+		{
+			MinusAggregate = bOperatorEmpty ? 0.f : MinusAggregate - OldContribution + NewContribution;
+			break;
+		}
+	case EFireflyAttributeModOperator::Multiply:
+		{
+			MultiplyAggregate = bOperatorEmpty ? 0.f : MultiplyAggregate - OldContribution + NewContribution;
+			break;
+		}
+	case EFireflyAttributeModOperator::Divide:
+		{
+			DivideAggregate = bOperatorEmpty ? 0.f : DivideAggregate - OldContribution + NewContribution;
+			break;
+		}
+	default:
+		{
+			break;
 		}
-		TotalDivideMod += DivideMod.ModValue * DivideMod.StackCount;
 	}
-	TotalDivideMod = TotalDivideMod == 0.f ? 1.f : TotalDivideMod;
-
-	return TotalDivideMod;
 }
 
-bool UFireflyAttribute::GetNewestOuterOverrideModifier(float& NewestValue) const
+void FFireflyAttributeModifierContainer::RecalculateAggregates()
 {
-	bool bInnerOverriderValid = false;
-	for (int i = 0; i < OuterOverrideMods.Num(); ++i)
+	PlusAggregate = 0.f;
+	MinusAggregate = 0.f;
+	MultiplyAggregate = 0.f;
+	DivideAggregate = 0.f;
+
+	for (const FFireflyAttributeModifier& Modifier : ModifierSlots)
 	{
-		if (OuterOverrideMods[i].bIsActive)
+		switch (Modifier.ModOperator)
 		{
-			bInnerOverriderValid = true;
-			NewestValue = OuterOverrideMods[i].ModValue * OuterOverrideMods[i].StackCount;
+		case EFireflyAttributeModOperator::Plus:
+			{
+				PlusAggregate += Modifier.GetAggregateContribution();
+				break;
+			}
+		case EFireflyAttributeModOperator::Minus:
+			{
+				MinusAggregate += Modifier.GetAggregateContribution();
+				break;
+			}
+		case EFireflyAttributeModOperator::Multiply:
+			{
+				MultiplyAggregate += Modifier.GetAggregateContribution();
+				break;
+			}
+		case EFireflyAttributeModOperator::Divide:
+			{
+				DivideAggregate += Modifier.GetAggregateContribution();
+				break;
+			}
+		default:
+			{
+				break;
+			}
+		}
+	}
+}
 
-			break;
+void FFireflyAttributeModifierContainer::VerifyAggregates(EFireflyAttributeType AttributeType)
+{
+#if !UE_BUILD_SHIPPING
+	if (!GFireflyVerifyModifierAggregates)
+	{
+		return;
+	}
+
+	const float CachedPlus = PlusAggregate;
+	const float CachedMinus = MinusAggregate;
+	const float CachedMultiply = MultiplyAggregate;
+	const float CachedDivide = DivideAggregate;
+
+	RecalculateAggregates();
+
+	if (!FMath::IsNearlyEqual(CachedPlus, PlusAggregate, KINDA_SMALL_NUMBER)
+		|| !FMath::IsNearlyEqual(CachedMinus, MinusAggregate, KINDA_SMALL_NUMBER)
+		|| !FMath::IsNearlyEqual(CachedMultiply, MultiplyAggregate, KINDA_SMALL_NUMBER)
+		|| !FMath::IsNearlyEqual(CachedDivide, DivideAggregate, KINDA_SMALL_NUMBER))
+	{
+		UE_LOG(LogFireflyAttribute, Warning, TEXT("FFireflyAttributeModifierContainer::VerifyAggregates() Attribute %s aggregates drifted: Plus %f/%f, Minus %f/%f, Multiply %f/%f, Divide %f/%f"),
+			*UFireflyAbilitySystemLibrary::GetAttributeTypeName(AttributeType), CachedPlus, PlusAggregate, CachedMinus, MinusAggregate,
+			CachedMultiply, MultiplyAggregate, CachedDivide, DivideAggregate);
+	}
+#endif
+}
+
+void FFireflyAttributeModifierContainer::AddReferencedObjects(FReferenceCollector& Collector, const UObject* Referencer)
+{
+	for (FFireflyAttributeModifier& Modifier : ModifierSlots)
+	{
+		if (Modifier.ModOperator != EFireflyAttributeModOperator::None)
+		{
+			Collector.AddReferencedObject(Modifier.ModSource, Referencer);
 		}
 	}
-	return bInnerOverriderValid;
-}
\ No newline at end of file
+}
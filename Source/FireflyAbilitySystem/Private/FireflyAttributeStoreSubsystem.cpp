@@ -0,0 +1,283 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyAttributeStoreSubsystem.h"
+
+#include "FireflyAbilitySystemComponent.h"
+#include "FireflyAbilitySystemModule.h"
+#include "FireflyAbilitySystemSettings.h"
+#include "FireflyAttribute.h"
+#include "Math/VectorRegister.h"
+
+bool UFireflyAttributeStoreSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer) || !UFireflyAbilitySystemSettings::Get()->bUseWorldAttributeStore)
+	{
+		return false;
+	}
+
+	const UWorld* World = Cast<UWorld>(Outer);
+
+	return IsValid(World) && World->IsGameWorld();
+}
+
+void UFireflyAttributeStoreSubsystem::Deinitialize()
+{
+	for (const TWeakObjectPtr<UFireflyAttribute>& Attribute : SlotAttributes)
+	{
+		if (Attribute.IsValid())
+		{
+			Attribute->AttributeStore = nullptr;
+			Attribute->AttributeStoreSlot = INDEX_NONE;
+		}
+	}
+
+	SlotAttributes.Empty();
+	FreeSlots.Empty();
+	BaseValues.Empty();
+	PlusValues.Empty();
+	MinusValues.Empty();
+	MultiplyValues.Empty();
+	DivideValues.Empty();
+	RangeMinValues.Empty();
+	RangeMaxValues.Empty();
+	CurrentValues.Empty();
+	DirtyBlocks.Empty();
+	NumDirtyBlocks = 0;
+	PendingPublishSlots.Empty();
+	PendingPublishMask.Empty();
+
+	Super::Deinitialize();
+}
+
+void UFireflyAttributeStoreSubsystem::Tick(float DeltaTime)
+{
+	FlushAttributeStore();
+}
+
+bool UFireflyAttributeStoreSubsystem::IsTickable() const
+{
+	return NumDirtyBlocks > 0 || PendingPublishSlots.Num() > 0;
+}
+
+TStatId UFireflyAttributeStoreSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFireflyAttributeStoreSubsystem, STATGROUP_Tickables);
+}
+
+int32 UFireflyAttributeStoreSubsystem::RegisterAttribute(UFireflyAttribute* Attribute)
+{
+	if (!IsValid(Attribute))
+	{
+		return INDEX_NONE;
+	}
+
+	if (FreeSlots.Num() == 0)
+	{
+		AddSlotBlock();
+	}
+
+	const int32 Slot = FreeSlots.Pop(false);
+	SlotAttributes[Slot] = Attribute;
+
+	return Slot;
+}
+
+void UFireflyAttributeStoreSubsystem::UnregisterAttribute(int32 Slot)
+{
+	if (!SlotAttributes.IsValidIndex(Slot))
+	{
+		return;
+	}
+
+	SlotAttributes[Slot].Reset();
+	ResetSlot(Slot);
+	FreeSlots.Push(Slot);
+}
+
+void UFireflyAttributeStoreSubsystem::WriteAttributeOperands(int32 Slot, float BaseValue, float PlusValue,
+	float MinusValue, float MultiplyValue, float DivideValue, float RangeMinValue, float RangeMaxValue)
+{
+	if (!SlotAttributes.IsValidIndex(Slot))
+	{
+		return;
+	}
+
+	BaseValues[Slot] = BaseValue;
+	PlusValues[Slot] = PlusValue;
+	MinusValues[Slot] = MinusValue;
+	MultiplyValues[Slot] = MultiplyValue;
+	DivideValues[Slot] = DivideValue;
+	RangeMinValues[Slot] = RangeMinValue;
+	RangeMaxValues[Slot] = RangeMaxValue;
+
+	const int32 BlockIndex = Slot / SlotsPerBlock;
+	if (!DirtyBlocks[BlockIndex])
+	{
+		DirtyBlocks[BlockIndex] = true;
+		++NumDirtyBlocks;
+	}
+}
+
+float UFireflyAttributeStoreSubsystem::ReadAttributeValue(int32 Slot)
+{
+	if (!SlotAttributes.IsValidIndex(Slot))
+	{
+		return 0.f;
+	}
+
+	const int32 BlockIndex = Slot / SlotsPerBlock;
+	if (DirtyBlocks[BlockIndex])
+	{
+		EvaluateBlock(BlockIndex);
+	}
+
+	return CurrentValues[Slot];
+}
+
+void UFireflyAttributeStoreSubsystem::AddSlotBlock()
+{
+	const int32 FirstSlot = SlotAttributes.Num();
+	const int32 NewNum = FirstSlot + SlotsPerBlock;
+
+	SlotAttributes.SetNum(NewNum);
+	BaseValues.SetNumUninitialized(NewNum);
+	PlusValues.SetNumUninitialized(NewNum);
+	MinusValues.SetNumUninitialized(NewNum);
+	MultiplyValues.SetNumUninitialized(NewNum);
+	DivideValues.SetNumUninitialized(NewNum);
+	RangeMinValues.SetNumUninitialized(NewNum);
+	RangeMaxValues.SetNumUninitialized(NewNum);
+	CurrentValues.SetNumUninitialized(NewNum);
+	DirtyBlocks.Add(false);
+	PendingPublishMask.Add(false, SlotsPerBlock);
+
+	/** 倒序压入，使得低位的槽位优先被分配 */
+	for (int32 Slot = NewNum - 1; Slot >= FirstSlot; --Slot)
+	{
+		ResetSlot(Slot);
+		FreeSlots.Push(Slot);
+	}
+}
+
+void UFireflyAttributeStoreSubsystem::ResetSlot(int32 Slot)
+{
+	BaseValues[Slot] = 0.f;
+	PlusValues[Slot] = 0.f;
+	MinusValues[Slot] = 0.f;
+	MultiplyValues[Slot] = 0.f;
+	DivideValues[Slot] = 1.f;
+	RangeMinValues[Slot] = -MAX_flt;
+	RangeMaxValues[Slot] = MAX_flt;
+	CurrentValues[Slot] = 0.f;
+}
+
+void UFireflyAttributeStoreSubsystem::FlushAttributeStore()
+{
+	/** 同步当前值时，依赖该属性的属性会写入新的数据，因此循环直到不再有脏块，每一轮使依赖链至少推进一层，依赖链的长度不会超过属性类型的数量，超出时只可能是属性之间存在循环依赖 */
+	for (int32 Pass = 0; NumDirtyBlocks > 0 || PendingPublishSlots.Num() > 0; ++Pass)
+	{
+		if (Pass > AttributeType_Max)
+		{
+			UE_LOG(LogFireflyAttribute, Warning, TEXT("UFireflyAttributeStoreSubsystem::FlushAttributeStore() Attribute values still changing after %d passes, the attribute dependencies contain a cycle. Remaining attributes will be flushed next tick."),
+				Pass);
+			break;
+		}
+
+		EvaluateDirtyBlocks();
+		PublishEvaluatedValues();
+	}
+}
+
+void UFireflyAttributeStoreSubsystem::EvaluateBlock(int32 BlockIndex)
+{
+	const int32 FirstSlot = BlockIndex * SlotsPerBlock;
+
+	// CurrentValue = Clamp((Base + Plus - Minus) * (1 + Multiply) / Divide, RangeMin, RangeMax)
+	const VectorRegister4Float Base = VectorLoad(&BaseValues[FirstSlot]);
+	const VectorRegister4Float Plus = VectorLoad(&PlusValues[FirstSlot]);
+	const VectorRegister4Float Minus = VectorLoad(&MinusValues[FirstSlot]);
+	const VectorRegister4Float Multiply = VectorLoad(&MultiplyValues[FirstSlot]);
+	const VectorRegister4Float Divide = VectorLoad(&DivideValues[FirstSlot]);
+	const VectorRegister4Float RangeMin = VectorLoad(&RangeMinValues[FirstSlot]);
+	const VectorRegister4Float RangeMax = VectorLoad(&RangeMaxValues[FirstSlot]);
+
+	VectorRegister4Float Result = VectorSubtract(VectorAdd(Base, Plus), Minus);
+	Result = VectorMultiply(Result, VectorAdd(GlobalVectorConstants::FloatOne, Multiply));
+	Result = VectorDivide(Result, Divide);
+
+	/** 与FMath::Clamp保持一致：小于最小值时取最小值，否则取与最大值中较小的一个 */
+	Result = VectorSelect(VectorCompareLT(Result, RangeMin), RangeMin, VectorMin(Result, RangeMax));
+
+	VectorStore(Result, &CurrentValues[FirstSlot]);
+
+	if (DirtyBlocks[BlockIndex])
+	{
+		DirtyBlocks[BlockIndex] = false;
+		--NumDirtyBlocks;
+	}
+
+	for (int32 Slot = FirstSlot; Slot < FirstSlot + SlotsPerBlock; ++Slot)
+	{
+		const UFireflyAttribute* Attribute = SlotAttributes[Slot].Get();
+		if (!Attribute || PendingPublishMask[Slot] || Attribute->CurrentValue == CurrentValues[Slot])
+		{
+			continue;
+		}
+
+		PendingPublishMask[Slot] = true;
+		PendingPublishSlots.Add(Slot);
+	}
+}
+
+void UFireflyAttributeStoreSubsystem::EvaluateDirtyBlocks()
+{
+	if (NumDirtyBlocks == 0)
+	{
+		return;
+	}
+
+	for (int32 BlockIndex = 0; BlockIndex < DirtyBlocks.Num() && NumDirtyBlocks > 0; ++BlockIndex)
+	{
+		if (DirtyBlocks[BlockIndex])
+		{
+			EvaluateBlock(BlockIndex);
+		}
+	}
+}
+
+void UFireflyAttributeStoreSubsystem::PublishEvaluatedValues()
+{
+	if (PendingPublishSlots.Num() == 0)
+	{
+		return;
+	}
+
+	/** 同步时可能产生新的待同步槽位，先转移列表 */
+	TArray<int32> SlotsToPublish = MoveTemp(PendingPublishSlots);
+	PendingPublishSlots.Reset();
+
+	for (const int32 Slot : SlotsToPublish)
+	{
+		PendingPublishMask[Slot] = false;
+
+		UFireflyAttribute* Attribute = SlotAttributes[Slot].Get();
+		if (!IsValid(Attribute))
+		{
+			continue;
+		}
+
+		const float OldValue = Attribute->CurrentValue;
+		const float NewValue = CurrentValues[Slot];
+		if (OldValue == NewValue)
+		{
+			continue;
+		}
+
+		Attribute->CurrentValue = NewValue;
+		if (UFireflyAbilitySystemComponent* Manager = Attribute->GetOwnerManager())
+		{
+			Manager->OnAttributeStoreValuePublished(Attribute, OldValue);
+		}
+	}
+}
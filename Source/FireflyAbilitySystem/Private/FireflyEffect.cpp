@@ -6,11 +6,342 @@
 #include "FireflyAbilitySystemComponent.h"
 #include "FireflyAbilitySystemLibrary.h"
 #include "FireflyEffectModifierCalculator.h"
+#include "FireflyEffectSchedulerSubsystem.h"
+#include "Engine/BlueprintGeneratedClass.h"
+
+/** 内容相同的动态构造器共享的效果定义，按内容的哈希值分组，定义不再被引用时自动失效 */
+static TMap<uint32, TArray<TWeakPtr<const FFireflyEffectDefinition>>> GDynamicEffectDefinitions;
+
+/** 将单个周期的操作值缩放为多个周期合并后的操作值，覆盖操作重复执行的结果与执行一次相同 */
+static float ScaleModValueForPeriods(EFireflyAttributeModOperator ModOperator, float ModValue, int32 PeriodCount)
+{
+	switch (ModOperator)
+	{
+	case EFireflyAttributeModOperator::Plus:
+	case EFireflyAttributeModOperator::Minus:
+		return ModValue * PeriodCount;
+	case EFireflyAttributeModOperator::Multiply:
+	case EFireflyAttributeModOperator::Divide:
+		return FMath::Pow(ModValue, static_cast<float>(PeriodCount));
+	default:
+		return ModValue;
+	}
+}
+
+/** 运算符的类别，同一属性上不同类别的运算交替执行时，结果依赖执行顺序 */
+static int32 GetModOperatorCategory(EFireflyAttributeModOperator ModOperator)
+{
+	switch (ModOperator)
+	{
+	case EFireflyAttributeModOperator::Plus:
+	case EFireflyAttributeModOperator::Minus:
+		return 0;
+	case EFireflyAttributeModOperator::Multiply:
+	case EFireflyAttributeModOperator::Divide:
+		return 1;
+	default:
+		return 2;
+	}
+}
+
+FFireflyEffectDefinition::FFireflyEffectDefinition(const UFireflyEffect* EffectCDO)
+	: FFireflyEffectDefinition(*static_cast<const FFireflyEffectSparseClassData*>(
+		EffectCDO->GetClass()->GetSparseClassData(EGetSparseClassDataMethod::ArchetypeIfNull)))
+{
+}
+
+FFireflyEffectDefinition::FFireflyEffectDefinition(const FFireflyEffectSparseClassData& ClassData)
+	: DurationPolicy(ClassData.DurationPolicy)
+	, Duration(ClassData.Duration)
+	, bIsEffectExecutionPeriodic(ClassData.bIsEffectExecutionPeriodic)
+	, PeriodicInterval(ClassData.PeriodicInterval)
+	, StackingPolicy(ClassData.StackingPolicy)
+	, StackingLimitation(ClassData.StackingLimitation)
+	, bShouldRefreshDurationOnStacking(ClassData.bShouldRefreshDurationOnStacking)
+	, bShouldResetPeriodicityOnStacking(ClassData.bShouldResetPeriodicityOnStacking)
+	, OverflowEffects(ClassData.OverflowEffects)
+	, bDenyNewStackingOnOverflow(ClassData.bDenyNewStackingOnOverflow)
+	, bClearStackingOnOverflow(ClassData.bClearStackingOnOverflow)
+	, StackingExpirationPolicy(ClassData.StackingExpirationPolicy)
+	, Modifiers(ClassData.Modifiers)
+	, SpecificProperties(ClassData.SpecificProperties)
+	, InstigatorApplicationPolicy(ClassData.InstigatorApplicationPolicy)
+	, TagsForEffectAsset(ClassData.TagsForEffectAsset)
+	, TagsApplyToOwnerOnApplied(ClassData.TagsApplyToOwnerOnApplied)
+	, TagsRequiredOngoing(ClassData.TagsRequiredOngoing)
+	, TagsBlockedOngoing(ClassData.TagsBlockedOngoing)
+	, TagsOfEffectsWillBeRemoved(ClassData.TagsOfEffectsWillBeRemoved)
+	, TagsOfEffectsWillBeBlocked(ClassData.TagsOfEffectsWillBeBlocked)
+	, TagsRequireOwnerHasForApplication(ClassData.TagsRequireOwnerHasForApplication)
+	, TagsBlockApplicationOnOwnerHas(ClassData.TagsBlockApplicationOnOwnerHas)
+{
+	BuildTagBits();
+}
+
+FFireflyEffectDefinition::FFireflyEffectDefinition(const FFireflyEffectDynamicConstructor& EffectSetup)
+	: DurationPolicy(EffectSetup.DurationPolicy)
+	, Duration(EffectSetup.Duration)
+	, bIsEffectExecutionPeriodic(EffectSetup.bIsEffectExecutionPeriodic)
+	, PeriodicInterval(EffectSetup.PeriodicInterval)
+	, StackingPolicy(EffectSetup.StackingPolicy)
+	, StackingLimitation(EffectSetup.StackingLimitation)
+	, bShouldRefreshDurationOnStacking(EffectSetup.bShouldRefreshDurationOnStacking)
+	, bShouldResetPeriodicityOnStacking(EffectSetup.bShouldResetPeriodicityOnStacking)
+	, OverflowEffects(EffectSetup.OverflowEffects)
+	, bDenyNewStackingOnOverflow(EffectSetup.bDenyNewStackingOnOverflow)
+	, bClearStackingOnOverflow(EffectSetup.bClearStackingOnOverflow)
+	, StackingExpirationPolicy(EffectSetup.StackingExpirationPolicy)
+	, Modifiers(EffectSetup.Modifiers)
+	, SpecificProperties(EffectSetup.SpecificProperties)
+	, InstigatorApplicationPolicy(EffectSetup.InstigatorApplicationPolicy)
+	, TagsForEffectAsset(EffectSetup.TagsForEffectAsset)
+	, TagsApplyToOwnerOnApplied(EffectSetup.TagsApplyToOwnerOnApplied)
+	, TagsRequiredOngoing(EffectSetup.TagsRequiredOngoing)
+	, TagsBlockedOngoing(EffectSetup.TagsBlockedOngoing)
+	, TagsOfEffectsWillBeRemoved(EffectSetup.TagsOfEffectsWillBeRemoved)
+	, TagsOfEffectsWillBeBlocked(EffectSetup.TagsOfEffectsWillBeBlocked)
+	, TagsRequireOwnerHasForApplication(EffectSetup.TagsRequireOwnerHasForApplication)
+	, TagsBlockApplicationOnOwnerHas(EffectSetup.TagsBlockApplicationOnOwnerHas)
+{
+	BuildTagBits();
+}
+
+FFireflyEffectApplicationTagBits::FFireflyEffectApplicationTagBits(const FGameplayTagContainer& InAssetTags,
+	const FGameplayTagContainer& InRequireTags, const FGameplayTagContainer& InBlockTags)
+	: AssetTags(FFireflyGameplayTagBits::MakeExact(InAssetTags))
+	, RequireTagsWithParents(FFireflyGameplayTagBits::MakeWithParents(InRequireTags))
+	, BlockTags(FFireflyGameplayTagBits::MakeExact(InBlockTags))
+{
+}
+
+void FFireflyEffectDefinition::BuildTagBits()
+{
+	ApplicationTagBits = FFireflyEffectApplicationTagBits(TagsForEffectAsset, TagsRequireOwnerHasForApplication,
+		TagsBlockApplicationOnOwnerHas);
+	TagsRequiredOngoingBits = FFireflyGameplayTagBits::MakeExact(TagsRequiredOngoing);
+	TagsBlockedOngoingBits = FFireflyGameplayTagBits::MakeExact(TagsBlockedOngoing);
+}
+
+bool FFireflyEffectDefinition::operator==(const FFireflyEffectDefinition& Other) const
+{
+	if (Modifiers.Num() != Other.Modifiers.Num())
+	{
+		return false;
+	}
+
+	/** 修改器的相等运算符只比较操作值，这里需要比较所有的取值配置 */
+	for (int32 i = 0; i < Modifiers.Num(); ++i)
+	{
+		const FFireflyEffectModifierData& Modifier = Modifiers[i];
+		const FFireflyEffectModifierData& OtherModifier = Other.Modifiers[i];
+		if (Modifier.AttributeType != OtherModifier.AttributeType
+			|| Modifier.ModOperator != OtherModifier.ModOperator
+			|| Modifier.ModValueMethod != OtherModifier.ModValueMethod
+			|| Modifier.ModValue != OtherModifier.ModValue
+			|| Modifier.AttributeTypeUsing != OtherModifier.AttributeTypeUsing
+			|| Modifier.CalculatorClass != OtherModifier.CalculatorClass
+			|| Modifier.CalculatorInstance != OtherModifier.CalculatorInstance)
+		{
+			return false;
+		}
+	}
+
+	return DurationPolicy == Other.DurationPolicy
+		&& Duration == Other.Duration
+		&& bIsEffectExecutionPeriodic == Other.bIsEffectExecutionPeriodic
+		&& PeriodicInterval == Other.PeriodicInterval
+		&& StackingPolicy == Other.StackingPolicy
+		&& StackingLimitation == Other.StackingLimitation
+		&& bShouldRefreshDurationOnStacking == Other.bShouldRefreshDurationOnStacking
+		&& bShouldResetPeriodicityOnStacking == Other.bShouldResetPeriodicityOnStacking
+		&& OverflowEffects == Other.OverflowEffects
+		&& bDenyNewStackingOnOverflow == Other.bDenyNewStackingOnOverflow
+		&& bClearStackingOnOverflow == Other.bClearStackingOnOverflow
+		&& StackingExpirationPolicy == Other.StackingExpirationPolicy
+		&& SpecificProperties == Other.SpecificProperties
+		&& InstigatorApplicationPolicy == Other.InstigatorApplicationPolicy
+		&& TagsForEffectAsset == Other.TagsForEffectAsset
+		&& TagsApplyToOwnerOnApplied == Other.TagsApplyToOwnerOnApplied
+		&& TagsRequiredOngoing == Other.TagsRequiredOngoing
+		&& TagsBlockedOngoing == Other.TagsBlockedOngoing
+		&& TagsOfEffectsWillBeRemoved == Other.TagsOfEffectsWillBeRemoved
+		&& TagsOfEffectsWillBeBlocked == Other.TagsOfEffectsWillBeBlocked
+		&& TagsRequireOwnerHasForApplication == Other.TagsRequireOwnerHasForApplication
+		&& TagsBlockApplicationOnOwnerHas == Other.TagsBlockApplicationOnOwnerHas;
+}
+
+uint32 GetTypeHash(const FFireflyEffectDefinition& Definition)
+{
+	/** Tag容器的相等比较与顺序无关，其哈希值也按与顺序无关的方式累加 */
+	auto HashTags = [](const FGameplayTagContainer& Tags)
+	{
+		uint32 TagsHash = Tags.Num();
+		for (const FGameplayTag& Tag : Tags)
+		{
+			TagsHash += GetTypeHash(Tag);
+		}
+		return TagsHash;
+	};
+
+	uint32 Hash = GetTypeHash(static_cast<uint8>(Definition.DurationPolicy));
+	Hash = HashCombine(Hash, GetTypeHash(Definition.Duration));
+	Hash = HashCombine(Hash, GetTypeHash(Definition.bIsEffectExecutionPeriodic));
+	Hash = HashCombine(Hash, GetTypeHash(Definition.PeriodicInterval));
+	Hash = HashCombine(Hash, GetTypeHash(static_cast<uint8>(Definition.StackingPolicy)));
+	Hash = HashCombine(Hash, GetTypeHash(Definition.StackingLimitation));
+	Hash = HashCombine(Hash, GetTypeHash(static_cast<uint8>(Definition.StackingExpirationPolicy)));
+	Hash = HashCombine(Hash, GetTypeHash(static_cast<uint8>(Definition.InstigatorApplicationPolicy)));
+	Hash = HashCombine(Hash, GetTypeHash(Definition.OverflowEffects.Num()));
+	Hash = HashCombine(Hash, GetTypeHash(Definition.SpecificProperties.Num()));
+	for (const FFireflyEffectModifierData& Modifier : Definition.Modifiers)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(static_cast<uint8>(Modifier.AttributeType)));
+		Hash = HashCombine(Hash, GetTypeHash(static_cast<uint8>(Modifier.ModOperator)));
+		Hash = HashCombine(Hash, GetTypeHash(Modifier.ModValue));
+	}
+	Hash = HashCombine(Hash, HashTags(Definition.TagsForEffectAsset));
+	Hash = HashCombine(Hash, HashTags(Definition.TagsApplyToOwnerOnApplied));
+	Hash = HashCombine(Hash, HashTags(Definition.TagsRequiredOngoing));
+	Hash = HashCombine(Hash, HashTags(Definition.TagsBlockedOngoing));
+	Hash = HashCombine(Hash, HashTags(Definition.TagsOfEffectsWillBeRemoved));
+	Hash = HashCombine(Hash, HashTags(Definition.TagsOfEffectsWillBeBlocked));
+	Hash = HashCombine(Hash, HashTags(Definition.TagsRequireOwnerHasForApplication));
+	Hash = HashCombine(Hash, HashTags(Definition.TagsBlockApplicationOnOwnerHas));
+
+	return Hash;
+}
+
+TSharedRef<const FFireflyEffectDefinition> FFireflyEffectDefinition::FindOrCreateForClass(TSubclassOf<UFireflyEffect> EffectType)
+{
+	const UClass* EffectClass = IsValid(EffectType) ? EffectType.Get() : UFireflyEffect::StaticClass();
+	const UFireflyEffect* EffectCDO = EffectClass->GetDefaultObject<UFireflyEffect>();
+	if (!EffectCDO->Definition.IsValid())
+	{
+		EffectCDO->Definition = MakeShared<const FFireflyEffectDefinition>(EffectCDO);
+	}
+
+	return EffectCDO->Definition.ToSharedRef();
+}
+
+TSharedRef<const FFireflyEffectDefinition> FFireflyEffectDefinition::FindOrCreateForDynamicConstructor(
+	const FFireflyEffectDynamicConstructor& EffectSetup)
+{
+	FFireflyEffectDefinition NewDefinition(EffectSetup);
+	TArray<TWeakPtr<const FFireflyEffectDefinition>>& Definitions = GDynamicEffectDefinitions.FindOrAdd(GetTypeHash(NewDefinition));
+	for (int32 i = Definitions.Num() - 1; i >= 0; --i)
+	{
+		const TSharedPtr<const FFireflyEffectDefinition> ExistingDefinition = Definitions[i].Pin();
+		if (!ExistingDefinition.IsValid())
+		{
+			Definitions.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+
+		if (*ExistingDefinition == NewDefinition)
+		{
+			return ExistingDefinition.ToSharedRef();
+		}
+	}
+
+	/** 最后一个引用者释放定义时，将其从共享表中移除，分组为空时移除整个分组 */
+	const uint32 DefinitionHash = GetTypeHash(NewDefinition);
+	TSharedRef<const FFireflyEffectDefinition> SharedDefinition = MakeShareable(new FFireflyEffectDefinition(MoveTemp(NewDefinition)),
+		[DefinitionHash](const FFireflyEffectDefinition* ExpiredDefinition)
+		{
+			if (TArray<TWeakPtr<const FFireflyEffectDefinition>>* Bucket = GDynamicEffectDefinitions.Find(DefinitionHash))
+			{
+				Bucket->RemoveAllSwap([](const TWeakPtr<const FFireflyEffectDefinition>& Entry)
+				{
+					return !Entry.IsValid();
+				}, false);
+				if (!Bucket->Num())
+				{
+					GDynamicEffectDefinitions.Remove(DefinitionHash);
+				}
+			}
+
+			delete ExpiredDefinition;
+		});
+	Definitions.Emplace(SharedDefinition);
+
+	return SharedDefinition;
+}
+
+void FFireflyEffectDefinition::AddReferencedObjects(FReferenceCollector& Collector) const
+{
+	for (const FFireflyEffectModifierData& Modifier : Modifiers)
+	{
+		const UFireflyEffectModifierCalculator* CalculatorInstance = Modifier.CalculatorInstance;
+		Collector.AddReferencedObject(CalculatorInstance);
+
+		const UClass* CalculatorClass = Modifier.CalculatorClass.Get();
+		Collector.AddReferencedObject(CalculatorClass);
+	}
+
+	for (const TSubclassOf<UFireflyEffect>& OverflowEffect : OverflowEffects)
+	{
+		const UClass* OverflowEffectClass = OverflowEffect.Get();
+		Collector.AddReferencedObject(OverflowEffectClass);
+	}
+}
+
+FFireflyEffectSpec::FFireflyEffectSpec(UFireflyEffect* InEffectCDO)
+	: EffectCDO(InEffectCDO)
+	, Modifiers(InEffectCDO->GetDefinition().Modifiers)
+	, TagsForEffectAsset(&InEffectCDO->GetDefinition().TagsForEffectAsset)
+	, TagsRequireOwnerHasForApplication(&InEffectCDO->GetDefinition().TagsRequireOwnerHasForApplication)
+	, TagsBlockApplicationOnOwnerHas(&InEffectCDO->GetDefinition().TagsBlockApplicationOnOwnerHas)
+	, ApplicationTagBits(&InEffectCDO->GetDefinition().ApplicationTagBits)
+{
+}
+
+FFireflyEffectSpec::FFireflyEffectSpec(UFireflyEffect* InEffectCDO, TArrayView<const FFireflyEffectModifierData> InModifiers)
+	: EffectCDO(InEffectCDO)
+	, Modifiers(InModifiers)
+	, TagsForEffectAsset(&InEffectCDO->GetDefinition().TagsForEffectAsset)
+	, TagsRequireOwnerHasForApplication(&InEffectCDO->GetDefinition().TagsRequireOwnerHasForApplication)
+	, TagsBlockApplicationOnOwnerHas(&InEffectCDO->GetDefinition().TagsBlockApplicationOnOwnerHas)
+	, ApplicationTagBits(&InEffectCDO->GetDefinition().ApplicationTagBits)
+{
+}
+
+FFireflyEffectSpec::FFireflyEffectSpec(UFireflyEffect* InEffectCDO, const FFireflyEffectDynamicConstructor& EffectSetup)
+	: EffectCDO(InEffectCDO)
+	, EffectID(EffectSetup.EffectID)
+	, Modifiers(EffectSetup.Modifiers)
+	, TagsForEffectAsset(&EffectSetup.TagsForEffectAsset)
+	, TagsRequireOwnerHasForApplication(&EffectSetup.TagsRequireOwnerHasForApplication)
+	, TagsBlockApplicationOnOwnerHas(&EffectSetup.TagsBlockApplicationOnOwnerHas)
+{
+}
+
+bool FFireflyEffectSpec::CanExecuteWithoutInstance() const
+{
+	if (!IsValid(EffectCDO))
+	{
+		return false;
+	}
+
+	if (UFireflyEffect::HasCustomExecuteLogic(EffectCDO->GetClass()))
+	{
+		return false;
+	}
+
+	/** 计算器需要效果实例作为计算的上下文 */
+	for (const FFireflyEffectModifierData& Modifier : Modifiers)
+	{
+		if (Modifier.ModValueMethod == EFireflyEffectModifierValueMethod::CustomCalculator)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
 
 UFireflyEffect::UFireflyEffect(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
-	InstigatorApplicationPolicy = EFireflyEffectInstigatorApplicationPolicy::InstigatorsApplyTheirOwnOnly;
 }
 
 UWorld* UFireflyEffect::GetWorld() const
@@ -46,6 +377,106 @@ int32 UFireflyEffect::GetFunctionCallspace(UFunction* Function, FFrame* Stack)
 	return (GetOuter() ? GetOuter()->GetFunctionCallspace(Function, Stack) : FunctionCallspace::Local);
 }
 
+void UFireflyEffect::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+	{
+		return;
+	}
+
+	BindSharedDefinition(FFireflyEffectDefinition::FindOrCreateForClass(GetClass()));
+}
+
+void UFireflyEffect::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	/** 配置属性不在实例上，共享定义或动态修改后的私有定义中的对象只能由此报告 */
+	const UFireflyEffect* This = CastChecked<UFireflyEffect>(InThis);
+	if (This->Definition.IsValid())
+	{
+		This->Definition->AddReferencedObjects(Collector);
+	}
+
+	Super::AddReferencedObjects(InThis, Collector);
+}
+
+#if WITH_EDITOR
+void UFireflyEffect::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	/** 默认对象的配置被编辑后，下次获取时重新构建该类型的共享定义 */
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		Definition.Reset();
+	}
+}
+
+void UFireflyEffect::MoveDataToSparseClassDataStruct() const
+{
+	/** 只有配置仍保存在蓝图类上的旧资产需要迁移 */
+	const UBlueprintGeneratedClass* BlueprintClass = Cast<UBlueprintGeneratedClass>(GetClass());
+	if (!BlueprintClass || BlueprintClass->bIsSparseClassDataSerializable)
+	{
+		return;
+	}
+
+	Super::MoveDataToSparseClassDataStruct();
+
+#if WITH_EDITORONLY_DATA
+	FFireflyEffectSparseClassData* ClassData = static_cast<FFireflyEffectSparseClassData*>(GetClass()->GetOrCreateSparseClassData());
+	ClassData->DurationPolicy = DurationPolicy_DEPRECATED;
+	ClassData->Duration = Duration_DEPRECATED;
+	ClassData->bIsEffectExecutionPeriodic = bIsEffectExecutionPeriodic_DEPRECATED;
+	ClassData->PeriodicInterval = PeriodicInterval_DEPRECATED;
+	ClassData->StackingPolicy = StackingPolicy_DEPRECATED;
+	ClassData->StackingLimitation = StackingLimitation_DEPRECATED;
+	ClassData->bShouldRefreshDurationOnStacking = bShouldRefreshDurationOnStacking_DEPRECATED;
+	ClassData->bShouldResetPeriodicityOnStacking = bShouldResetPeriodicityOnStacking_DEPRECATED;
+	ClassData->OverflowEffects = OverflowEffects_DEPRECATED;
+	ClassData->bDenyNewStackingOnOverflow = bDenyNewStackingOnOverflow_DEPRECATED;
+	ClassData->bClearStackingOnOverflow = bClearStackingOnOverflow_DEPRECATED;
+	ClassData->StackingExpirationPolicy = StackingExpirationPolicy_DEPRECATED;
+	ClassData->Modifiers = Modifiers_DEPRECATED;
+	ClassData->SpecificProperties = SpecificProperties_DEPRECATED;
+	ClassData->InstigatorApplicationPolicy = InstigatorApplicationPolicy_DEPRECATED;
+	ClassData->TagsForEffectAsset = TagsForEffectAsset_DEPRECATED;
+	ClassData->TagsApplyToOwnerOnApplied = TagsApplyToOwnerOnApplied_DEPRECATED;
+	ClassData->TagsRequiredOngoing = TagsRequiredOngoing_DEPRECATED;
+	ClassData->TagsBlockedOngoing = TagsBlockedOngoing_DEPRECATED;
+	ClassData->TagsOfEffectsWillBeRemoved = TagsOfEffectsWillBeRemoved_DEPRECATED;
+	ClassData->TagsOfEffectsWillBeBlocked = TagsOfEffectsWillBeBlocked_DEPRECATED;
+	ClassData->TagsRequireOwnerHasForApplication = TagsRequireOwnerHasForApplication_DEPRECATED;
+	ClassData->TagsBlockApplicationOnOwnerHas = TagsBlockApplicationOnOwnerHas_DEPRECATED;
+#endif
+}
+#endif
+
+FFireflyEffectDefinition& UFireflyEffect::GetMutableDefinition()
+{
+	if (!PrivateDefinition.IsValid())
+	{
+		PrivateDefinition = MakeShared<FFireflyEffectDefinition>(GetDefinition());
+		Definition = PrivateDefinition;
+	}
+
+	return *PrivateDefinition;
+}
+
+TSharedRef<const FFireflyEffectDefinition> UFireflyEffect::PinDefinition() const
+{
+	GetDefinition();
+
+	return Definition.ToSharedRef();
+}
+
+void UFireflyEffect::BindSharedDefinition(const TSharedRef<const FFireflyEffectDefinition>& NewDefinition)
+{
+	Definition = NewDefinition;
+	PrivateDefinition.Reset();
+}
+
 AActor* UFireflyEffect::GetOwnerActor() const
 {
 	UFireflyAbilitySystemComponent* Manager = GetOwnerManager();
@@ -67,108 +498,115 @@ UFireflyAbilitySystemComponent* UFireflyEffect::GetOwnerManager() const
 	return Cast<UFireflyAbilitySystemComponent>(GetOuter());
 }
 
+UFireflyEffectSchedulerSubsystem* UFireflyEffect::GetEffectScheduler() const
+{
+	const UWorld* World = GetWorld();
+	if (!IsValid(World))
+	{
+		return nullptr;
+	}
+
+	return World->GetSubsystem<UFireflyEffectSchedulerSubsystem>();
+}
+
 void UFireflyEffect::SetupEffectByDynamicConstructor(FFireflyEffectDynamicConstructor EffectSetup)
 {
-	DurationPolicy = EffectSetup.DurationPolicy;
-	Duration = EffectSetup.Duration;
-	bIsEffectExecutionPeriodic = EffectSetup.bIsEffectExecutionPeriodic;
-	PeriodicInterval = EffectSetup.PeriodicInterval;
-	StackingPolicy = EffectSetup.StackingPolicy;
-	StackingLimitation = EffectSetup.StackingLimitation;
-	bShouldRefreshDurationOnStacking = EffectSetup.bShouldRefreshDurationOnStacking;
-	bShouldResetPeriodicityOnStacking = EffectSetup.bShouldResetPeriodicityOnStacking;
-	OverflowEffects = EffectSetup.OverflowEffects;
-	bDenyNewStackingOnOverflow = EffectSetup.bDenyNewStackingOnOverflow;
-	bClearStackingOnOverflow = EffectSetup.bClearStackingOnOverflow;
-	StackingExpirationPolicy = EffectSetup.StackingExpirationPolicy;
-	Modifiers = EffectSetup.Modifiers;
-	SpecificProperties = EffectSetup.SpecificProperties;
-	InstigatorApplicationPolicy = EffectSetup.InstigatorApplicationPolicy;
-	TagsForEffectAsset = EffectSetup.TagsForEffectAsset;
-	TagsApplyToOwnerOnApplied = EffectSetup.TagsApplyToOwnerOnApplied;
-	TagsRequiredOngoing = EffectSetup.TagsRequiredOngoing;
-	TagsBlockedOngoing = EffectSetup.TagsBlockedOngoing;
-	TagsOfEffectsWillBeRemoved = EffectSetup.TagsOfEffectsWillBeRemoved;
-	TagsOfEffectsWillBeBlocked = EffectSetup.TagsOfEffectsWillBeBlocked;
-	TagsRequireOwnerHasForApplication = EffectSetup.TagsRequireOwnerHasForApplication;
-	TagsBlockApplicationOnOwnerHas = EffectSetup.TagsBlockApplicationOnOwnerHas;
+	BindSharedDefinition(FFireflyEffectDefinition::FindOrCreateForDynamicConstructor(EffectSetup));
 }
 
 void UFireflyEffect::SetTimeRemainingOfDuration(float NewDuration)
 {
-	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
-	if (!TimerManager.IsTimerActive(DurationTimer))
+	UFireflyEffectSchedulerSubsystem* Scheduler = GetEffectScheduler();
+	if (!IsValid(Scheduler) || !IsDurationTicking())
 	{
 		return;
 	}
 
-	TimerManager.ClearTimer(DurationTimer);
-	TimerManager.SetTimer(DurationTimer, this, 
-		&UFireflyEffect::ExecuteEffectExpiration, NewDuration);
+	Scheduler->ScheduleEffectExpiration(this, NewDuration);
 }
 
 float UFireflyEffect::GetTimeRemainingOfDuration() const
 {
-	return GetWorld()->GetTimerManager().GetTimerRemaining(DurationTimer);
+	const UFireflyEffectSchedulerSubsystem* Scheduler = GetEffectScheduler();
+	if (!IsValid(Scheduler) || !IsDurationTicking())
+	{
+		return -1.f;
+	}
+
+	return FMath::Max(DurationExpireTime - Scheduler->GetSchedulerTime(), 0.0);
 }
 
 void UFireflyEffect::TryExecuteOrRefreshDuration()
 {
-	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
-	/** 如果持续时间尚未开始计时，则执行计时器 */
-	if (!TimerManager.IsTimerActive(DurationTimer))
+	const FFireflyEffectDefinition& EffectDefinition = GetDefinition();
+
+	UFireflyEffectSchedulerSubsystem* Scheduler = GetEffectScheduler();
+	if (!IsValid(Scheduler))
+	{
+		return;
+	}
+
+	/** 如果持续时间尚未开始计时，则开始计时 */
+	if (!IsDurationTicking())
 	{
-		TimerManager.SetTimer(DurationTimer, this, &UFireflyEffect::ExecuteEffectExpiration, Duration);
+		Scheduler->ScheduleEffectExpiration(this, EffectDefinition.Duration);
 		return;
 	}
 
 	/** 如果堆叠不会刷新执行时间，或者堆叠到期策略为清理所有堆叠数，则不会刷新持续时间 */
-	if (!bShouldRefreshDurationOnStacking || StackingExpirationPolicy == EFireflyEffectDurationPolicyOnStackingExpired::ClearEntireStack)
+	if (!EffectDefinition.bShouldRefreshDurationOnStacking || EffectDefinition.StackingExpirationPolicy == EFireflyEffectDurationPolicyOnStackingExpired::ClearEntireStack)
 	{
 		return;
 	}
 
 	/** 刷新持续时间 */
-	TimerManager.ClearTimer(DurationTimer);
-	TimerManager.SetTimer(DurationTimer, this, &UFireflyEffect::ExecuteEffectExpiration, Duration);
+	Scheduler->ScheduleEffectExpiration(this, EffectDefinition.Duration);
 }
 
 void UFireflyEffect::TryExecuteOrResetPeriodicity()
 {
+	const FFireflyEffectDefinition& EffectDefinition = GetDefinition();
+
 	/** 如果该效果不是周期性执行，直接返回 */
-	if (!bIsEffectExecutionPeriodic)
+	if (!EffectDefinition.bIsEffectExecutionPeriodic)
+	{
+		return;
+	}
+
+	UFireflyEffectSchedulerSubsystem* Scheduler = GetEffectScheduler();
+	if (!IsValid(Scheduler))
 	{
 		return;
 	}
 
-	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
-	/** 如果效果的周期性执行尚未开始，则开始计时器，执行周期性逻辑 */
-	if (!TimerManager.IsTimerActive(PeriodicityTimer))
+	/** 如果效果的周期性执行尚未开始，则开始计时，执行周期性逻辑 */
+	if (!IsPeriodicityTicking())
 	{
-		TimerManager.SetTimer(PeriodicityTimer, this, &UFireflyEffect::ExecuteEffect, PeriodicInterval, true);
+		Scheduler->ScheduleEffectPeriodicity(this, EffectDefinition.PeriodicInterval);
 		return;
 	}
 
 	/** 如果堆叠不会重置周期性执行，或者堆叠到期策略为清理所有堆叠数，则不会重置周期性执行 */
-	if (!bShouldResetPeriodicityOnStacking || StackingExpirationPolicy == EFireflyEffectDurationPolicyOnStackingExpired::ClearEntireStack)
+	if (!EffectDefinition.bShouldResetPeriodicityOnStacking || EffectDefinition.StackingExpirationPolicy == EFireflyEffectDurationPolicyOnStackingExpired::ClearEntireStack)
 	{
 		return;
 	}
 
 	/** 重置周期性执行 */
-	TimerManager.ClearTimer(PeriodicityTimer);
-	TimerManager.SetTimer(PeriodicityTimer, this, &UFireflyEffect::ExecuteEffect, PeriodicInterval, true);
+	Scheduler->ScheduleEffectPeriodicity(this, EffectDefinition.PeriodicInterval);
 }
 
 void UFireflyEffect::AddEffectStack(int32 StackCountToAdd)
 {
+	const FFireflyEffectDefinition& EffectDefinition = GetDefinition();
+
 	if (StackCountToAdd <= 0)
 	{
 		return;
 	}
 
 	/** 如果已经开始堆叠 && 满堆叠 && 满堆叠时拒绝新的堆叠实例，直接返回 */
-	if (StackCount != 0 && StackCount == StackingLimitation && bDenyNewStackingOnOverflow)
+	if (IsNewStackingDenied())
 	{
 		return;
 	}
@@ -176,15 +614,25 @@ void UFireflyEffect::AddEffectStack(int32 StackCountToAdd)
 	/** 添加堆叠数，如果堆叠有上限，执行夹值 */
 	float OldStackCount = StackCount;
 	StackCount += StackCountToAdd;
-	if (StackingPolicy == EFireflyEffectStackingPolicy::StackHasLimit)
+	if (EffectDefinition.StackingPolicy == EFireflyEffectStackingPolicy::StackHasLimit)
 	{		
-		StackCount = FMath::Clamp<int32>(StackCount, 0, StackingLimitation);
+		StackCount = FMath::Clamp<int32>(StackCount, 0, EffectDefinition.StackingLimitation);
 	}
 	
+	SyncAppliedModifierStacks();
+
 	ReceiveAddEffectStack(StackCountToAdd);
 	GetOwnerManager()->OnEffectStackingChanged.Broadcast(EffectID, GetClass(), StackCount, OldStackCount);
 }
 
+bool UFireflyEffect::IsNewStackingDenied() const
+{
+	const FFireflyEffectDefinition& EffectDefinition = GetDefinition();
+
+	return EffectDefinition.StackingPolicy != EFireflyEffectStackingPolicy::None && StackCount != 0
+		&& StackCount == EffectDefinition.StackingLimitation && EffectDefinition.bDenyNewStackingOnOverflow;
+}
+
 bool UFireflyEffect::ReduceEffectStack(int32 StackCountToReduce)
 {
 	if (StackCountToReduce >= 0)
@@ -196,6 +644,8 @@ bool UFireflyEffect::ReduceEffectStack(int32 StackCountToReduce)
 	float OldStackCount = StackCount;
 	StackCount = FMath::Clamp<int32>(StackCount - StackCountToReduce, 0, OldStackCount);
 
+	SyncAppliedModifierStacks();
+
 	ReceiveReduceEffectStack(StackCountToReduce);
 	GetOwnerManager()->OnEffectStackingChanged.Broadcast(EffectID, GetClass(), StackCount, OldStackCount);
 
@@ -211,14 +661,15 @@ bool UFireflyEffect::TryExecuteEffectStackOverflow()
 {
 	/** 如果管理器不存在 || 堆叠数未达到最大值 || 效果的堆叠不受限制，直接返回 */
 	UFireflyAbilitySystemComponent* Manager = GetOwnerManager();
-	if (!IsValid(Manager) || StackCount != StackingLimitation
-		|| StackingPolicy != EFireflyEffectStackingPolicy::StackHasLimit)
+	const TSharedRef<const FFireflyEffectDefinition> EffectDefinition = PinDefinition();
+	if (!IsValid(Manager) || StackCount != EffectDefinition->StackingLimitation
+		|| EffectDefinition->StackingPolicy != EFireflyEffectStackingPolicy::StackHasLimit)
 	{
 		return false;
 	}
 
 	/** 应用堆叠数达到上限时触发的额外效果 */
-	for (auto EffectType : OverflowEffects)
+	for (auto EffectType : EffectDefinition->OverflowEffects)
 	{
 		Manager->ApplyEffectToOwnerByClass(GetOwnerActor(), EffectType);
 	}
@@ -237,17 +688,20 @@ void UFireflyEffect::ApplyEffect(AActor* InInstigator, AActor* InTarget, int32 S
 	}
 
 	/** 如果持续时间策略为Instant，直接按照申请的堆叠次数执行逻辑，并结束效果的应用 */
-	if (DurationPolicy == EFireflyEffectDurationPolicy::Instant)
+	if (GetDefinition().DurationPolicy == EFireflyEffectDurationPolicy::Instant)
 	{
 		Instigators.Emplace(InInstigator);
 		Target = InTarget;
 
-		for (int i = 0; i < StackToApply; ++i)
 		{
-			ExecuteEffect();
+			FFireflyScopedModifierTransaction Transaction(UFireflyAbilitySystemLibrary::GetFireflyAbilitySystem(Target));
+			for (int i = 0; i < StackToApply; ++i)
+			{
+				ExecuteEffect();
+			}
 		}
-		
-		MarkAsGarbage();
+
+		Manager->ReleaseEffectInstance(this);
 
 		return;
 	}
@@ -259,10 +713,10 @@ void UFireflyEffect::ApplyEffect(AActor* InInstigator, AActor* InTarget, int32 S
 	}
 
 	/** 如果该效果不可堆叠 */
-	if (StackingPolicy == EFireflyEffectStackingPolicy::None)
+	if (GetDefinition().StackingPolicy == EFireflyEffectStackingPolicy::None)
 	{
 		/** 第一次执行效果逻辑 */
-		if (!GetWorld()->GetTimerManager().IsTimerActive(DurationTimer))
+		if (!IsDurationTicking())
 		{
 			ApplyEffectFirstTime(Manager);
 		}
@@ -278,15 +732,17 @@ void UFireflyEffect::ApplyEffect(AActor* InInstigator, AActor* InTarget, int32 S
 	AddEffectStack(StackToApply);
 
 	/** 第一次执行有堆叠的效果逻辑 */
-	if (!GetWorld()->GetTimerManager().IsTimerActive(DurationTimer))
+	if (!IsDurationTicking())
 	{
 		ApplyEffectFirstTime(Manager);
 	}
 
 	/** 尝试执行满堆叠时的逻辑，如果满堆叠时清理堆叠并结束执行，直接结束效果 */
-	if (TryExecuteEffectStackOverflow() && bClearStackingOnOverflow)
+	if (TryExecuteEffectStackOverflow() && GetDefinition().bClearStackingOnOverflow)
 	{
-		RemoveEffect();		
+		RemoveEffect();
+
+		return;
 	}
 
 	/** 尝试刷新持续时间，尝试重置周期性执行执行 */
@@ -302,8 +758,8 @@ void UFireflyEffect::ApplyEffectFirstTime(UFireflyAbilitySystemComponent* Manage
 	}
 
 	Manager->HandleActiveEffectApplication(this, true);
-	Manager->OnActiveEffectApplied.Broadcast(EffectID, GetClass(), Duration);
-	Manager->OnTagContainerUpdated.AddDynamic(this, &UFireflyEffect::OnOwnerTagContainerUpdated);
+	Manager->OnActiveEffectApplied.Broadcast(EffectID, GetClass(), GetDefinition().Duration);
+	Manager->RegisterEffectOngoingRequirement(this);
 	ExecuteEffectTagRequirementToOwner(true);
 	ExecuteEffect();
 }
@@ -321,29 +777,19 @@ void UFireflyEffect::ExecuteEffect()
 		return;
 	}
 
-	if (DurationPolicy == EFireflyEffectDurationPolicy::Instant || bIsEffectExecutionPeriodic)
+	/** 所有修改器应用完毕后，每个被修改的属性只广播一次值的变化 */
+	FFireflyScopedModifierTransaction Transaction(TargetAbilitySystem);
+	const TSharedRef<const FFireflyEffectDefinition> EffectDefinition = PinDefinition();
+
+	if (EffectDefinition->DurationPolicy == EFireflyEffectDurationPolicy::Instant || EffectDefinition->bIsEffectExecutionPeriodic)
 	{
 		// 如果效果的持续时间策略为Instant，或者效果在持续期间周期性执行
-		for (auto Modifier : Modifiers)
+		for (const FFireflyEffectModifierData& Modifier : EffectDefinition->Modifiers)
 		{
-			float ModValueToUse = Modifier.ModValue;
-
-			/** 尝试使用计算器 */
-			if (Modifier.ModValueMethod == EFireflyEffectModifierValueMethod::CustomCalculator)
-			{				
-				if (!IsValid(Modifier.CalculatorInstance))
-				{
-					Modifier.CalculatorInstance = NewObject<UFireflyEffectModifierCalculator>(this, Modifier.CalculatorClass);
-				}
-				if (IsValid(Modifier.CalculatorInstance))
-				{
-					ModValueToUse = Modifier.CalculatorInstance->CalculateModifierValue(this, Modifier.ModValue);
-				}
-			}
-			/** 尝试使用某个属性值 */
-			else if (Modifier.ModValueMethod == EFireflyEffectModifierValueMethod::UsingAttribute)
+			float ModValueToUse = CalculateModifierValueToUse(Modifier);
+			if (ExecutingPeriodCount > 1)
 			{
-				ModValueToUse = GetOwnerManager()->GetAttributeValue(Modifier.AttributeTypeUsing);
+				ModValueToUse = ScaleModValueForPeriods(Modifier.ModOperator, ModValueToUse, ExecutingPeriodCount);
 			}
 
 			TargetAbilitySystem->ApplyModifierToAttributeInstant(Modifier.AttributeType,
@@ -358,44 +804,162 @@ void UFireflyEffect::ExecuteEffect()
 		}
 
 		// 如果效果在持续期间不周期性执行
-		for (auto Modifier : Modifiers)
+		ModifierHandles.SetNum(EffectDefinition->Modifiers.Num());
+		for (int32 i = 0; i < EffectDefinition->Modifiers.Num(); ++i)
 		{
-			float ModValueToUse = Modifier.ModValue;
-			
-			/** 尝试使用计算器 */
-			if (Modifier.ModValueMethod == EFireflyEffectModifierValueMethod::CustomCalculator)
+			const FFireflyEffectModifierData& Modifier = EffectDefinition->Modifiers[i];
+			const float ModValueToUse = CalculateModifierValueToUse(Modifier);
+
+			/** 已应用过的修改器直接通过句柄重设，否则应用新的修改器并记录句柄 */
+			FFireflyModifierHandle& ModifierHandle = ModifierHandles[i];
+			if (TargetAbilitySystem->IsModifierHandleValid(ModifierHandle))
 			{
-				if (!IsValid(Modifier.CalculatorInstance))
-				{
-					Modifier.CalculatorInstance = NewObject<UFireflyEffectModifierCalculator>(this, Modifier.CalculatorClass);
-				}
-				if (IsValid(Modifier.CalculatorInstance))
-				{
-					ModValueToUse = Modifier.CalculatorInstance->CalculateModifierValue(this, Modifier.ModValue);
-				}
+				TargetAbilitySystem->ResetModifierByHandle(ModifierHandle, ModValueToUse, StackCount);
 			}
-			/** 尝试使用某个属性值 */
-			else if (Modifier.ModValueMethod == EFireflyEffectModifierValueMethod::UsingAttribute)
+			else
 			{
-				ModValueToUse = GetOwnerManager()->GetAttributeValue(Modifier.AttributeTypeUsing);
+				ModifierHandle = TargetAbilitySystem->ApplyModifierToAttributeWithHandle(Modifier.AttributeType,
+					Modifier.ModOperator, this, ModValueToUse, StackCount);
 			}
-
-			TargetAbilitySystem->ApplyModifierToAttribute(Modifier.AttributeType, Modifier.ModOperator,
-				this, ModValueToUse, StackCount);
 		}
 	}	
 
 	ReceiveExecuteEffect();
 }
 
+void UFireflyEffect::ExecuteEffectPeriods(int32 PeriodCount)
+{
+	ExecutingPeriodCount = FMath::Max(PeriodCount, 1);
+	ExecuteEffect();
+	ExecutingPeriodCount = 1;
+}
+
+bool UFireflyEffect::CanCoalescePeriods() const
+{
+	/** 重写的执行逻辑每个周期都要触发，合并后只会执行一次 */
+	if (HasCustomExecuteLogic(GetClass()))
+	{
+		return false;
+	}
+
+	const TArray<FFireflyEffectModifierData>& Modifiers = GetDefinition().Modifiers;
+	for (const FFireflyEffectModifierData& Modifier : Modifiers)
+	{
+		/** 计算器的结果可能依赖每个周期的状态，无法由单个周期的操作值缩放得到 */
+		if (Modifier.ModValueMethod == EFireflyEffectModifierValueMethod::CustomCalculator)
+		{
+			return false;
+		}
+
+		/** 操作值取自该效果修改的属性时，每个周期的操作值都不同，包括修改器取值于自身修改的属性 */
+		if (Modifier.ModValueMethod == EFireflyEffectModifierValueMethod::UsingAttribute
+			&& Modifiers.ContainsByPredicate([&Modifier](const FFireflyEffectModifierData& OtherModifier)
+			{
+				return OtherModifier.AttributeType == Modifier.AttributeTypeUsing;
+			}))
+		{
+			return false;
+		}
+	}
+
+	if (Modifiers.Num() <= 1)
+	{
+		return true;
+	}
+
+	const UFireflyAbilitySystemComponent* TargetAbilitySystem = UFireflyAbilitySystemLibrary::GetFireflyAbilitySystem(Target);
+	if (!IsValid(TargetAbilitySystem))
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < Modifiers.Num(); ++i)
+	{
+		const FFireflyEffectModifierData& Modifier = Modifiers[i];
+
+		/** 每个周期结束时属性都会被夹值，多个修改器逐周期夹值的结果与合并后夹值一次不同 */
+		if (TargetAbilitySystem->IsAttributeValueClamped(Modifier.AttributeType))
+		{
+			return false;
+		}
+
+		for (int32 j = 0; j < Modifiers.Num(); ++j)
+		{
+			const FFireflyEffectModifierData& OtherModifier = Modifiers[j];
+			if (i == j)
+			{
+				continue;
+			}
+
+			if (OtherModifier.AttributeType == Modifier.AttributeType
+				&& GetModOperatorCategory(OtherModifier.ModOperator) != GetModOperatorCategory(Modifier.ModOperator))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool UFireflyEffect::HasCustomExecuteLogic(const UClass* EffectClass)
+{
+	if (!IsValid(EffectClass))
+	{
+		return false;
+	}
+
+	/** 原生子类可能重写了效果的执行逻辑 */
+	const UClass* NativeClass = EffectClass;
+	while (NativeClass && !NativeClass->HasAnyClassFlags(CLASS_Native))
+	{
+		NativeClass = NativeClass->GetSuperClass();
+	}
+	if (NativeClass != UFireflyEffect::StaticClass())
+	{
+		return true;
+	}
+
+	return EffectClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UFireflyEffect, ReceiveExecuteEffect));
+}
+
+float UFireflyEffect::CalculateModifierValueToUse(const FFireflyEffectModifierData& Modifier)
+{
+	/** 尝试使用计算器，未指定计算器实例时使用管理器中共享的计算器 */
+	if (Modifier.ModValueMethod == EFireflyEffectModifierValueMethod::CustomCalculator)
+	{
+		UFireflyEffectModifierCalculator* Calculator = Modifier.CalculatorInstance;
+		if (!IsValid(Calculator))
+		{
+			Calculator = GetOwnerManager()->GetModifierCalculator(Modifier.CalculatorClass);
+		}
+		if (IsValid(Calculator))
+		{
+			return Calculator->Calculate(this, Modifier.ModValue);
+		}
+	}
+	/** 尝试使用某个属性值 */
+	else if (Modifier.ModValueMethod == EFireflyEffectModifierValueMethod::UsingAttribute)
+	{
+		return GetOwnerManager()->GetLiveAttributeValue(Modifier.AttributeTypeUsing);
+	}
+
+	return Modifier.ModValue;
+}
+
 void UFireflyEffect::ExecuteEffectExpiration()
 {
-	/** 清理持续时间计时器 */
-	GetWorld()->GetTimerManager().ClearTimer(DurationTimer);
+	const FFireflyEffectDefinition& EffectDefinition = GetDefinition();
+
+	/** 清理持续时间的计时 */
+	if (UFireflyEffectSchedulerSubsystem* Scheduler = GetEffectScheduler())
+	{
+		Scheduler->CancelEffectExpiration(this);
+	}
 
 	/** 如果该效果不会堆叠，或者堆叠到期策略为 ClearEntireStack，结束效果 */
-	if (StackingExpirationPolicy == EFireflyEffectDurationPolicyOnStackingExpired::ClearEntireStack
-		|| StackingPolicy == EFireflyEffectStackingPolicy::None)
+	if (EffectDefinition.StackingExpirationPolicy == EFireflyEffectDurationPolicyOnStackingExpired::ClearEntireStack
+		|| EffectDefinition.StackingPolicy == EFireflyEffectStackingPolicy::None)
 	{
 		ReceiveExecuteEffectExpiration();
 		RemoveEffect();		
@@ -404,7 +968,7 @@ void UFireflyEffect::ExecuteEffectExpiration()
 	}
 
 	/** 如果堆叠到期策略为 RemoveSingleStackAndRefreshDuration，减少一个堆叠数 */
-	if (StackingExpirationPolicy == EFireflyEffectDurationPolicyOnStackingExpired::RemoveSingleStackAndRefreshDuration)
+	if (EffectDefinition.StackingExpirationPolicy == EFireflyEffectDurationPolicyOnStackingExpired::RemoveSingleStackAndRefreshDuration)
 	{
 		/** 如果堆叠数被清到0，结束效果 */
 		if (ReduceEffectStack(1))
@@ -430,41 +994,87 @@ void UFireflyEffect::RemoveEffect()
 		return;
 	}
 
-	/** 清理该效果携带的所有属性修改器 */
-	for (auto& Modifier : Modifiers)
+	/** 停止持续时间和周期性执行的计时 */
+	if (UFireflyEffectSchedulerSubsystem* Scheduler = GetEffectScheduler())
 	{
-		Manager->RemoveModifierFromAttribute(Modifier.AttributeType, Modifier.ModOperator, 
-			this, Modifier.ModValue);
+		Scheduler->CancelAllEffectEvents(this);
 	}
 
+	/** 清理该效果携带的所有属性修改器 */
+	RemoveAppliedModifiers(Manager);
+
 	/** 堆叠数重置为0 */
-	if (StackingPolicy != EFireflyEffectStackingPolicy::None && StackCount > 0)
+	if (GetDefinition().StackingPolicy != EFireflyEffectStackingPolicy::None && StackCount > 0)
 	{
 		ReduceEffectStack(StackCount);
 	}
 
 	Manager->OnActiveEffectRemoved.Broadcast(EffectID, GetClass());
-	/** 停止监听管理器的TagContainer更新 */
-	Manager->OnTagContainerUpdated.RemoveDynamic(this, &UFireflyEffect::OnOwnerTagContainerUpdated);
+	/** 停止响应持续生效条件的Tag变化 */
+	Manager->UnregisterEffectOngoingRequirement(this);
 
 	Manager->HandleActiveEffectApplication(this, false);
 
 	ExecuteEffectTagRequirementToOwner(false);
 	ReceiveRemoveEffect();
 
-	MarkAsGarbage();
+	Manager->ReleaseEffectInstance(this);
 }
 
-void UFireflyEffect::OnOwnerTagContainerUpdated(FGameplayTagContainer OwnerTagContainer)
+void UFireflyEffect::ResetEffectInstance()
 {
-	if (OwnerTagContainer.HasAnyExact(TagsBlockedOngoing))
+	if (UFireflyEffectSchedulerSubsystem* Scheduler = GetEffectScheduler())
+	{
+		Scheduler->CancelAllEffectEvents(this);
+	}
+
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearAllTimersForObject(this);
+	}
+
+	/** 恢复为默认对象的属性值，清除上一次应用留下的发起者、堆叠数和修改器句柄等运行时状态，配置属性由共享的定义提供，不再复制 */
+	const UObject* EffectCDO = GetClass()->GetDefaultObject();
+	for (TFieldIterator<FProperty> It(GetClass()); It; ++It)
+	{
+		if (It->GetOwnerClass() == UFireflyEffect::StaticClass() && It->HasAnyPropertyFlags(CPF_DisableEditOnInstance | CPF_Deprecated))
+		{
+			continue;
+		}
+
+		It->CopyCompleteValue_InContainer(this, EffectCDO);
+	}
+
+	BindSharedDefinition(FFireflyEffectDefinition::FindOrCreateForClass(GetClass()));
+}
+
+bool UFireflyEffect::HasOngoingRequirement() const
+{
+	const FFireflyEffectDefinition& EffectDefinition = GetDefinition();
+
+	return !EffectDefinition.TagsRequiredOngoing.IsEmpty() || !EffectDefinition.TagsBlockedOngoing.IsEmpty();
+}
+
+void UFireflyEffect::EvaluateOngoingRequirement()
+{
+	const UFireflyAbilitySystemComponent* Manager = GetOwnerManager();
+	if (!IsValid(Manager))
+	{
+		return;
+	}
+
+	const FFireflyEffectDefinition& EffectDefinition = GetDefinition();
+
+	const FFireflyGameplayTagBits& OwnedTagBits = Manager->GetOwnedTagBits();
+
+	if (OwnedTagBits.HasAny(EffectDefinition.TagsBlockedOngoingBits))
 	{
 		/** 使效果失效 */
 		SwitchEffectOngoingValidation(false);
 		return;
 	}
 
-	if (OwnerTagContainer.HasAllExact(TagsRequiredOngoing))
+	if (OwnedTagBits.HasAll(EffectDefinition.TagsRequiredOngoingBits))
 	{
 		/** 使效果重新生效 */
 		SwitchEffectOngoingValidation(true);
@@ -488,7 +1098,10 @@ void UFireflyEffect::SwitchEffectOngoingValidation(bool bIsEffective)
 
 		ExecuteEffectTagRequirementToOwner(false);
 
-		GetWorld()->GetTimerManager().UnPauseTimer(PeriodicityTimer);
+		if (UFireflyEffectSchedulerSubsystem* Scheduler = GetEffectScheduler())
+		{
+			Scheduler->UnPauseEffectPeriodicity(this);
+		}
 
 		ExecuteEffect();
 	}
@@ -498,13 +1111,43 @@ void UFireflyEffect::SwitchEffectOngoingValidation(bool bIsEffective)
 
 		ExecuteEffectTagRequirementToOwner(false);
 
-		GetWorld()->GetTimerManager().PauseTimer(PeriodicityTimer); 
-
-		for (auto Modifier : Modifiers)
+		if (UFireflyEffectSchedulerSubsystem* Scheduler = GetEffectScheduler())
 		{
-			Manager->RemoveModifierFromAttribute(Modifier.AttributeType, Modifier.ModOperator, 
-				this, Modifier.ModValue);
+			Scheduler->PauseEffectPeriodicity(this);
 		}
+
+		RemoveAppliedModifiers(Manager);
+	}
+}
+
+void UFireflyEffect::RemoveAppliedModifiers(UFireflyAbilitySystemComponent* Manager)
+{
+	if (!IsValid(Manager))
+	{
+		return;
+	}
+
+	FFireflyScopedModifierTransaction Transaction(Manager);
+	for (const FFireflyModifierHandle& ModifierHandle : ModifierHandles)
+	{
+		Manager->RemoveModifierByHandle(ModifierHandle);
+	}
+
+	ModifierHandles.Reset();
+}
+
+void UFireflyEffect::SyncAppliedModifierStacks()
+{
+	UFireflyAbilitySystemComponent* TargetAbilitySystem = UFireflyAbilitySystemLibrary::GetFireflyAbilitySystem(Target);
+	if (!IsValid(TargetAbilitySystem) || ModifierHandles.Num() == 0)
+	{
+		return;
+	}
+
+	FFireflyScopedModifierTransaction Transaction(TargetAbilitySystem);
+	for (const FFireflyModifierHandle& ModifierHandle : ModifierHandles)
+	{
+		TargetAbilitySystem->SetModifierStackByHandle(ModifierHandle, StackCount);
 	}
 }
 
@@ -516,14 +1159,15 @@ void UFireflyEffect::ExecuteEffectTagRequirementToOwner(bool bIsApplied)
 	}
 
 	UFireflyAbilitySystemComponent* Manager = GetOwnerManager();
+	const TSharedRef<const FFireflyEffectDefinition> EffectDefinition = PinDefinition();
 
-	Manager->UpdateBlockAndRemoveEffectTags(TagsOfEffectsWillBeBlocked, TagsOfEffectsWillBeRemoved, bIsApplied);
+	Manager->UpdateBlockAndRemoveEffectTags(EffectDefinition->TagsOfEffectsWillBeBlocked, EffectDefinition->TagsOfEffectsWillBeRemoved, bIsApplied);
 	if (bIsApplied)
 	{
-		Manager->AddTagsToManager(TagsApplyToOwnerOnApplied, 1);
+		Manager->AddTagsToManager(EffectDefinition->TagsApplyToOwnerOnApplied, 1);
 	}
 	else
 	{
-		Manager->RemoveTagsFromManager(TagsApplyToOwnerOnApplied, 1);
+		Manager->RemoveTagsFromManager(EffectDefinition->TagsApplyToOwnerOnApplied, 1);
 	}
 }
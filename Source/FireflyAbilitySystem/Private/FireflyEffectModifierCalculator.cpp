@@ -18,6 +18,23 @@ UWorld* UFireflyEffectModifierCalculator::GetWorld() const
 	return GetOuter()->GetWorld();
 }
 
+void UFireflyEffectModifierCalculator::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	bHasBlueprintCalculate = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UFireflyEffectModifierCalculator, CalculateModifierValue));
+}
+
+float UFireflyEffectModifierCalculator::Calculate(UFireflyEffect* EffectInstance, float OriginModValue)
+{
+	if (bHasBlueprintCalculate)
+	{
+		return CalculateModifierValue(EffectInstance, OriginModValue);
+	}
+
+	return CalculateModifierValue_Implementation(EffectInstance, OriginModValue);
+}
+
 float UFireflyEffectModifierCalculator::CalculateModifierValue_Implementation(UFireflyEffect* EffectInstance, float OriginModValue)
 {
 	return 0.f;
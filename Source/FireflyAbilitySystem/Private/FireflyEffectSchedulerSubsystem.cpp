@@ -0,0 +1,256 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyEffectSchedulerSubsystem.h"
+
+#include "FireflyAbilitySystemModule.h"
+#include "FireflyAbilitySystemSettings.h"
+#include "FireflyEffect.h"
+
+bool UFireflyEffectSchedulerSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	const UWorld* World = Cast<UWorld>(Outer);
+
+	return IsValid(World) && World->IsGameWorld();
+}
+
+void UFireflyEffectSchedulerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const UFireflyAbilitySystemSettings* Settings = UFireflyAbilitySystemSettings::Get();
+	FixedStep = Settings->bUseFixedStepEffectScheduling ? FMath::Max<double>(Settings->EffectSchedulingFixedStep, 0.001) : 0.0;
+	bCoalesceMissedPeriods = Settings->bCoalesceMissedEffectPeriods;
+}
+
+void UFireflyEffectSchedulerSubsystem::Deinitialize()
+{
+	EventHeap.Empty();
+	NumStaleEvents = 0;
+
+	Super::Deinitialize();
+}
+
+void UFireflyEffectSchedulerSubsystem::Tick(float DeltaTime)
+{
+	FireDueEvents(GetSchedulerTime());
+}
+
+bool UFireflyEffectSchedulerSubsystem::IsTickable() const
+{
+	return EventHeap.Num() > 0;
+}
+
+TStatId UFireflyEffectSchedulerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFireflyEffectSchedulerSubsystem, STATGROUP_Tickables);
+}
+
+double UFireflyEffectSchedulerSubsystem::GetSchedulerTime() const
+{
+	const double WorldTime = GetWorld()->GetTimeSeconds();
+	if (!IsFixedStep())
+	{
+		return WorldTime;
+	}
+
+	return FMath::FloorToDouble(WorldTime / FixedStep) * FixedStep;
+}
+
+void UFireflyEffectSchedulerSubsystem::ScheduleEffectExpiration(UFireflyEffect* Effect, float Delay)
+{
+	if (!IsValid(Effect))
+	{
+		return;
+	}
+
+	CancelEffectExpiration(Effect);
+	if (Delay <= 0.f)
+	{
+		return;
+	}
+
+	Effect->DurationExpireTime = GetSchedulerTime() + Delay;
+	Effect->DurationEventSerial = NextEventSerial++;
+	PushEvent(Effect, Effect->DurationExpireTime, Effect->DurationEventSerial, EFireflyScheduledEffectEventType::Expiration);
+}
+
+void UFireflyEffectSchedulerSubsystem::CancelEffectExpiration(UFireflyEffect* Effect)
+{
+	if (!IsValid(Effect) || Effect->DurationEventSerial == 0)
+	{
+		return;
+	}
+
+	Effect->DurationEventSerial = 0;
+	MarkEventStale();
+}
+
+void UFireflyEffectSchedulerSubsystem::ScheduleEffectPeriodicity(UFireflyEffect* Effect, float Interval)
+{
+	if (!IsValid(Effect))
+	{
+		return;
+	}
+
+	CancelEffectPeriodicity(Effect);
+	if (Interval <= 0.f)
+	{
+		return;
+	}
+
+	Effect->NextPeriodicTime = GetSchedulerTime() + Interval;
+	Effect->PeriodicityEventSerial = NextEventSerial++;
+	PushEvent(Effect, Effect->NextPeriodicTime, Effect->PeriodicityEventSerial, EFireflyScheduledEffectEventType::Periodicity);
+}
+
+void UFireflyEffectSchedulerSubsystem::CancelEffectPeriodicity(UFireflyEffect* Effect)
+{
+	if (!IsValid(Effect))
+	{
+		return;
+	}
+
+	Effect->PeriodicityPausedRemaining = -1.0;
+	if (Effect->PeriodicityEventSerial == 0)
+	{
+		return;
+	}
+
+	Effect->PeriodicityEventSerial = 0;
+	MarkEventStale();
+}
+
+void UFireflyEffectSchedulerSubsystem::PauseEffectPeriodicity(UFireflyEffect* Effect)
+{
+	if (!IsValid(Effect) || Effect->PeriodicityEventSerial == 0)
+	{
+		return;
+	}
+
+	const double Remaining = FMath::Max(Effect->NextPeriodicTime - GetSchedulerTime(), 0.0);
+	CancelEffectPeriodicity(Effect);
+	Effect->PeriodicityPausedRemaining = Remaining;
+}
+
+void UFireflyEffectSchedulerSubsystem::UnPauseEffectPeriodicity(UFireflyEffect* Effect)
+{
+	if (!IsValid(Effect) || Effect->PeriodicityPausedRemaining < 0.0)
+	{
+		return;
+	}
+
+	Effect->NextPeriodicTime = GetSchedulerTime() + Effect->PeriodicityPausedRemaining;
+	Effect->PeriodicityPausedRemaining = -1.0;
+	Effect->PeriodicityEventSerial = NextEventSerial++;
+	PushEvent(Effect, Effect->NextPeriodicTime, Effect->PeriodicityEventSerial, EFireflyScheduledEffectEventType::Periodicity);
+}
+
+void UFireflyEffectSchedulerSubsystem::CancelAllEffectEvents(UFireflyEffect* Effect)
+{
+	CancelEffectExpiration(Effect);
+	CancelEffectPeriodicity(Effect);
+}
+
+void UFireflyEffectSchedulerSubsystem::PushEvent(UFireflyEffect* Effect, double FireTime, uint64 Serial,
+	EFireflyScheduledEffectEventType EventType)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FireflyEffectSchedulerHeapPush);
+
+	EventHeap.HeapPush(FFireflyScheduledEffectEvent(FireTime, Serial, Effect, EventType));
+}
+
+void UFireflyEffectSchedulerSubsystem::MarkEventStale()
+{
+	++NumStaleEvents;
+
+	/** 失效事件超过一半时一次性剔除，避免频繁刷新持续时间的效果使最小堆无限增长 */
+	if (NumStaleEvents < 1024 || NumStaleEvents * 2 < EventHeap.Num())
+	{
+		return;
+	}
+
+	EventHeap.RemoveAllSwap([](const FFireflyScheduledEffectEvent& Event)
+	{
+		return !IsEventValid(Event);
+	}, false);
+	EventHeap.Heapify();
+	NumStaleEvents = 0;
+}
+
+bool UFireflyEffectSchedulerSubsystem::IsEventValid(const FFireflyScheduledEffectEvent& Event)
+{
+	const UFireflyEffect* Effect = Event.Effect.Get();
+	if (!IsValid(Effect))
+	{
+		return false;
+	}
+
+	return Event.EventType == EFireflyScheduledEffectEventType::Expiration
+		? Effect->DurationEventSerial == Event.Serial
+		: Effect->PeriodicityEventSerial == Event.Serial;
+}
+
+void UFireflyEffectSchedulerSubsystem::FireDueEvents(double Now)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FireflyEffectSchedulerFireDueEvents);
+
+	while (EventHeap.Num() > 0 && EventHeap.HeapTop().FireTime <= Now)
+	{
+		FFireflyScheduledEffectEvent Event;
+		{
+			SCOPE_CYCLE_COUNTER(STAT_FireflyEffectSchedulerHeapPop);
+			EventHeap.HeapPop(Event, false);
+		}
+
+		if (!IsEventValid(Event))
+		{
+			NumStaleEvents = FMath::Max(NumStaleEvents - 1, 0);
+			continue;
+		}
+
+		INC_DWORD_STAT(STAT_FireflyEffectSchedulerEventsFired);
+
+		UFireflyEffect* Effect = Event.Effect.Get();
+		if (Event.EventType == EFireflyScheduledEffectEventType::Expiration)
+		{
+			Effect->DurationEventSerial = 0;
+			Effect->ExecuteEffectExpiration();
+			continue;
+		}
+
+		if (Effect->GetDefinition().PeriodicInterval <= 0.f)
+		{
+			Effect->PeriodicityEventSerial = 0;
+			continue;
+		}
+
+		/** 先调度下一次周期性执行，执行逻辑中取消或重置周期性时该事件自然失效；落后多个周期时在同一帧内补齐 */
+		const double Interval = Effect->GetDefinition().PeriodicInterval;
+		if (!bCoalesceMissedPeriods || !Effect->CanCoalescePeriods())
+		{
+			Effect->NextPeriodicTime = Event.FireTime + Interval;
+			PushEvent(Effect, Effect->NextPeriodicTime, Event.Serial, EFireflyScheduledEffectEventType::Periodicity);
+			Effect->ExecuteEffect();
+			continue;
+		}
+
+		/** 修改器可交换顺序时，合并落后的所有周期，以一次缩放后的执行代替；有持续时间时只合并严格早于到期时间的周期，与逐周期执行时同一时间到期事件先触发、恰好落在到期时间上的周期不执行的结果一致 */
+		int32 PeriodCount = 1 + FMath::FloorToInt32((Now - Event.FireTime) / Interval);
+		if (Effect->IsDurationTicking())
+		{
+			const int32 PeriodCountBeforeExpiry = FMath::CeilToInt32((Effect->DurationExpireTime - Event.FireTime) / Interval);
+			PeriodCount = FMath::Max(FMath::Min(PeriodCount, PeriodCountBeforeExpiry), 1);
+		}
+		Effect->NextPeriodicTime = Event.FireTime + Interval * PeriodCount;
+		PushEvent(Effect, Effect->NextPeriodicTime, Event.Serial, EFireflyScheduledEffectEventType::Periodicity);
+		Effect->ExecuteEffectPeriods(PeriodCount);
+	}
+
+	INC_DWORD_STAT_BY(STAT_FireflyEffectSchedulerQueuedEvents, EventHeap.Num());
+}
@@ -0,0 +1,174 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyGameplayTagBits.h"
+
+void FFireflyGameplayTagBits::SetBit(int32 BitIndex)
+{
+	if (BitIndex < 0)
+	{
+		return;
+	}
+
+	const int32 WordIndex = BitIndex / 64;
+	if (Words.Num() <= WordIndex)
+	{
+		Words.SetNumZeroed(WordIndex + 1);
+	}
+
+	Words[WordIndex] |= 1ull << (BitIndex % 64);
+}
+
+void FFireflyGameplayTagBits::ClearBit(int32 BitIndex)
+{
+	const int32 WordIndex = BitIndex / 64;
+	if (BitIndex < 0 || Words.Num() <= WordIndex)
+	{
+		return;
+	}
+
+	Words[WordIndex] &= ~(1ull << (BitIndex % 64));
+}
+
+bool FFireflyGameplayTagBits::HasBit(int32 BitIndex) const
+{
+	const int32 WordIndex = BitIndex / 64;
+	if (BitIndex < 0 || Words.Num() <= WordIndex)
+	{
+		return false;
+	}
+
+	return (Words[WordIndex] & (1ull << (BitIndex % 64))) != 0;
+}
+
+bool FFireflyGameplayTagBits::HasAny(const FFireflyGameplayTagBits& Other) const
+{
+	const int32 NumWords = FMath::Min(Words.Num(), Other.Words.Num());
+	for (int32 i = 0; i < NumWords; ++i)
+	{
+		if (Words[i] & Other.Words[i])
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FFireflyGameplayTagBits::HasAll(const FFireflyGameplayTagBits& Other) const
+{
+	for (int32 i = 0; i < Other.Words.Num(); ++i)
+	{
+		const uint64 Word = Words.IsValidIndex(i) ? Words[i] : 0;
+		if ((Word & Other.Words[i]) != Other.Words[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FFireflyGameplayTagBits::IsEmpty() const
+{
+	for (const uint64 Word : Words)
+	{
+		if (Word)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+FFireflyGameplayTagBits& FFireflyGameplayTagBits::operator|=(const FFireflyGameplayTagBits& Other)
+{
+	if (Words.Num() < Other.Words.Num())
+	{
+		Words.SetNumZeroed(Other.Words.Num());
+	}
+
+	for (int32 i = 0; i < Other.Words.Num(); ++i)
+	{
+		Words[i] |= Other.Words[i];
+	}
+
+	return *this;
+}
+
+FFireflyGameplayTagBits FFireflyGameplayTagBits::MakeExact(const FGameplayTagContainer& Tags)
+{
+	FFireflyGameplayTagBitRegistry& Registry = FFireflyGameplayTagBitRegistry::Get();
+
+	FFireflyGameplayTagBits Bits;
+	for (const FGameplayTag& Tag : Tags)
+	{
+		Bits.SetBit(Registry.FindOrAddBitIndex(Tag));
+	}
+
+	return Bits;
+}
+
+FFireflyGameplayTagBits FFireflyGameplayTagBits::MakeWithParents(const FGameplayTagContainer& Tags)
+{
+	FFireflyGameplayTagBitRegistry& Registry = FFireflyGameplayTagBitRegistry::Get();
+
+	FFireflyGameplayTagBits Bits;
+	for (const FGameplayTag& Tag : Tags)
+	{
+		Bits |= Registry.GetTagAndParentBits(Tag);
+	}
+
+	return Bits;
+}
+
+FFireflyGameplayTagBitRegistry& FFireflyGameplayTagBitRegistry::Get()
+{
+	static FFireflyGameplayTagBitRegistry Registry;
+
+	return Registry;
+}
+
+int32 FFireflyGameplayTagBitRegistry::FindOrAddBitIndex(const FGameplayTag& Tag)
+{
+	if (!Tag.IsValid())
+	{
+		return INDEX_NONE;
+	}
+
+	if (const int32* BitIndex = TagBitIndices.Find(Tag))
+	{
+		return *BitIndex;
+	}
+
+	const int32 NewBitIndex = TagBitIndices.Num();
+	TagBitIndices.Add(Tag, NewBitIndex);
+	TagAndParentBits.AddDefaulted();
+
+	return NewBitIndex;
+}
+
+const FFireflyGameplayTagBits& FFireflyGameplayTagBitRegistry::GetTagAndParentBits(const FGameplayTag& Tag)
+{
+	static const FFireflyGameplayTagBits EmptyBits;
+
+	const int32 BitIndex = FindOrAddBitIndex(Tag);
+	if (BitIndex == INDEX_NONE)
+	{
+		return EmptyBits;
+	}
+
+	if (TagAndParentBits[BitIndex].IsEmpty())
+	{
+		/** 先算出位集合再写入，分配父级Tag的位索引时数组可能扩容 */
+		FFireflyGameplayTagBits Bits;
+		for (const FGameplayTag& ParentTag : Tag.GetGameplayTagParents())
+		{
+			Bits.SetBit(FindOrAddBitIndex(ParentTag));
+		}
+		TagAndParentBits[BitIndex] = MoveTemp(Bits);
+	}
+
+	return TagAndParentBits[BitIndex];
+}
@@ -0,0 +1,30 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyReplicatedTagCount.h"
+
+#include "FireflyAbilitySystemComponent.h"
+
+void FFireflyReplicatedTagCountEntry::PreReplicatedRemove(const FFireflyReplicatedTagCountContainer& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.Owner))
+	{
+		InArraySerializer.Owner->SetReplicatedTagCount(Tag, 0);
+	}
+}
+
+void FFireflyReplicatedTagCountEntry::PostReplicatedAdd(const FFireflyReplicatedTagCountContainer& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.Owner))
+	{
+		InArraySerializer.Owner->SetReplicatedTagCount(Tag, Count);
+	}
+}
+
+void FFireflyReplicatedTagCountEntry::PostReplicatedChange(const FFireflyReplicatedTagCountContainer& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.Owner))
+	{
+		InArraySerializer.Owner->SetReplicatedTagCount(Tag, Count);
+	}
+}
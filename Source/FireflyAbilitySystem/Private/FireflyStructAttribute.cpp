@@ -0,0 +1,80 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyStructAttribute.h"
+
+#include "FireflyAbilitySystemComponent.h"
+
+void FFireflyStructAttribute::InitializeFromTemplate(const UFireflyAttribute* Template)
+{
+	if (!IsValid(Template))
+	{
+		return;
+	}
+
+	AttributeType = Template->AttributeType;
+	bAttributeMustNotLessThanSelection = Template->bAttributeMustNotLessThanSelection;
+	LessBaseValue = Template->LessBaseValue;
+	bAttributeHasRange = Template->bAttributeHasRange;
+	RangeMinValue = Template->RangeMinValue;
+	RangeMaxValue = Template->RangeMaxValue;
+	RangeMaxValueType = Template->RangeMaxValueType;
+}
+
+void FFireflyStructAttribute::GetDependencySourceTypes(
+	TArray<EFireflyAttributeType, TInlineAllocator<4>>& OutSourceTypes) const
+{
+	OutSourceTypes.Reset();
+
+	if (bAttributeHasRange && RangeMaxValueType != AttributeType_Default)
+	{
+		OutSourceTypes.Add(RangeMaxValueType);
+	}
+}
+
+float FFireflyStructAttribute::ClampValue(float InValue, const UFireflyAbilitySystemComponent* Manager) const
+{
+	if (bAttributeHasRange)
+	{
+		const float FinalRangeMax = RangeMaxValueType != AttributeType_Default ?
+			Manager->GetLiveAttributeValue(RangeMaxValueType) : RangeMaxValue;
+
+		return FMath::Clamp<float>(InValue, RangeMinValue, FinalRangeMax);
+	}
+
+	if (bAttributeMustNotLessThanSelection)
+	{
+		return InValue < LessBaseValue ? LessBaseValue : InValue;
+	}
+
+	return InValue;
+}
+
+bool FFireflyStructAttribute::IsValueInAttributeRange(float InValue, const UFireflyAbilitySystemComponent* Manager) const
+{
+	if (!bAttributeHasRange)
+	{
+		return true;
+	}
+
+	const float FinalRangeMax = RangeMaxValue == 0.f ?
+		Manager->GetLiveAttributeValue(RangeMaxValueType) : RangeMaxValue;
+
+	return InValue >= RangeMinValue && InValue <= FinalRangeMax;
+}
+
+void FFireflyStructAttribute::PostReplicatedAdd(const FFireflyStructAttributeContainer& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.Owner))
+	{
+		InArraySerializer.Owner->OnStructAttributeReplicated(*this, true);
+	}
+}
+
+void FFireflyStructAttribute::PostReplicatedChange(const FFireflyStructAttributeContainer& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.Owner))
+	{
+		InArraySerializer.Owner->OnStructAttributeReplicated(*this, false);
+	}
+}
@@ -0,0 +1,58 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyAbilitySystemComponent.h"
+
+#include "Tests/FireflyAutomationTestWorld.h"
+#include "Misc/AutomationTest.h"
+#include "NativeGameplayTags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FireflyAbilityCooldownTest
+{
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_CooldownTest_First, "FireflyTest.Cooldown.First");
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_CooldownTest_Second, "FireflyTest.Cooldown.Second");
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyAbilityCooldownTagSetTest, "FireflyAbilitySystem.Ability.CooldownTagSets",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyAbilityCooldownTagSetTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyAbilityCooldownTest;
+
+	FFireflyAutomationTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+
+	const FGameplayTagContainer FirstTags(TAG_CooldownTest_First);
+	const FGameplayTagContainer SecondTags(TAG_CooldownTest_Second);
+	FGameplayTagContainer BothTags = FirstTags;
+	BothTags.AddTag(TAG_CooldownTest_Second);
+
+	/** 分别进入冷却的标签不会组合成同时携带两个标签的冷却 */
+	AbilitySystem->ApplyCooldown(FirstTags, 5.f);
+	AbilitySystem->ApplyCooldown(SecondTags, 5.f);
+	TestTrue(TEXT("First tag on cooldown"), AbilitySystem->IsOnCooldown(FirstTags));
+	TestTrue(TEXT("Second tag on cooldown"), AbilitySystem->IsOnCooldown(SecondTags));
+	TestFalse(TEXT("Separately applied tags on cooldown together"), AbilitySystem->IsOnCooldown(BothTags));
+
+	/** 一起进入冷却的标签使只需要其中部分标签的冷却也处于冷却中 */
+	AbilitySystem->ApplyCooldown(BothTags, 10.f);
+	TestTrue(TEXT("Tags applied together on cooldown"), AbilitySystem->IsOnCooldown(BothTags));
+	TestEqual(TEXT("Remaining of the tags applied together"), AbilitySystem->GetCooldownTimeRemaining(BothTags), 10.f);
+	TestEqual(TEXT("Remaining of a subset takes the latest entry"), AbilitySystem->GetCooldownTimeRemaining(FirstTags), 10.f);
+
+	/** 修改剩余时间只影响同时携带所有标签的冷却记录 */
+	AbilitySystem->SetCooldownRemaining(BothTags, 2.f);
+	TestEqual(TEXT("Remaining after shortening the combined entry"), AbilitySystem->GetCooldownTimeRemaining(BothTags), 2.f);
+	TestEqual(TEXT("Remaining of the separate entry"), AbilitySystem->GetCooldownTimeRemaining(SecondTags), 5.f);
+
+	TestWorld.World->TimeSeconds = 6.0;
+	TestFalse(TEXT("First tag after every entry expired"), AbilitySystem->IsOnCooldown(FirstTags));
+	TestEqual(TEXT("Remaining after every entry expired"), AbilitySystem->GetCooldownTimeRemaining(BothTags), 0.f);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,178 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyAbilitySystemComponent.h"
+#include "FireflyAbilitySystemSettings.h"
+
+#include "Tests/FireflyAutomationTestWorld.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FireflyAttributeHistoryTest
+{
+	constexpr EFireflyAttributeType FirstType = AttributeType001;
+	constexpr EFireflyAttributeType SecondType = AttributeType002;
+	constexpr EFireflyAttributeType ThirdType = AttributeType003;
+
+	/** 构造三个初始值为0的属性 */
+	void ConstructTestAttributes(UFireflyAbilitySystemComponent* AbilitySystem)
+	{
+		for (const EFireflyAttributeType AttributeType : { FirstType, SecondType, ThirdType })
+		{
+			FFireflyAttributeConstructor Constructor;
+			Constructor.AttributeType = AttributeType;
+			AbilitySystem->ConstructAttributeByConstructor(Constructor);
+			AbilitySystem->InitializeAttributeByType(AttributeType, 0.f);
+		}
+	}
+
+	/** 构造最大生命值和以最大生命值为上限的生命值，二者初始值都为100 */
+	void ConstructRangedAttributes(UFireflyAbilitySystemComponent* AbilitySystem)
+	{
+		FFireflyAttributeConstructor MaxHealth;
+		MaxHealth.AttributeType = FirstType;
+		AbilitySystem->ConstructAttributeByConstructor(MaxHealth);
+
+		FFireflyAttributeConstructor Health;
+		Health.AttributeType = SecondType;
+		Health.bAttributeHasRange = true;
+		Health.RangeMinValue = 0.f;
+		Health.RangeMaxValueType = FirstType;
+		AbilitySystem->ConstructAttributeByConstructor(Health);
+
+		AbilitySystem->InitializeAttributeByType(FirstType, 100.f);
+		AbilitySystem->InitializeAttributeByType(SecondType, 100.f);
+	}
+
+	/** 进入新的一帧，并将世界时间推进到指定的服务端时间 */
+	void AdvanceFrame(UWorld* World, double ServerTime)
+	{
+		++GFrameCounter;
+		World->TimeSeconds = ServerTime;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyAttributeHistoryRingBufferTest, "FireflyAbilitySystem.Attribute.HistoryRingBuffer",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyAttributeHistoryRingBufferTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyAttributeHistoryTest;
+
+	/** 3帧的环形缓冲，每帧最多记录2个属性 */
+	UFireflyAbilitySystemSettings* Settings = UFireflyAbilitySystemSettings::Get();
+	TGuardValue<bool> EnableGuard(Settings->bEnableAttributeHistory, true);
+	TGuardValue<int32> FrameCountGuard(Settings->AttributeHistoryFrameCount, 3);
+	TGuardValue<int32> MaxChangesGuard(Settings->AttributeHistoryMaxChangesPerFrame, 2);
+
+	FFireflyAutomationTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+	ConstructTestAttributes(AbilitySystem);
+	AbilitySystem->GetOwner()->DispatchBeginPlay();
+
+	UObject* ModSource = AbilitySystem;
+	float Value = 0.f;
+
+	/** 同一帧内同一属性多次变化，只记录第一次变化前的值 */
+	AdvanceFrame(TestWorld.World, 1.0);
+	AbilitySystem->ApplyModifierToAttributeInstant(FirstType, EFireflyAttributeModOperator::Plus, ModSource, 10.f);
+	AbilitySystem->ApplyModifierToAttributeInstant(FirstType, EFireflyAttributeModOperator::Plus, ModSource, 10.f);
+
+	AdvanceFrame(TestWorld.World, 2.0);
+	AbilitySystem->ApplyModifierToAttributeInstant(FirstType, EFireflyAttributeModOperator::Plus, ModSource, 10.f);
+
+	TestTrue(TEXT("Query before the deduplicated frame"), AbilitySystem->GetAttributeValueAtTime(FirstType, 0.5, Value));
+	TestEqual(TEXT("Value before the deduplicated frame"), Value, 0.f);
+	TestTrue(TEXT("Query between frames"), AbilitySystem->GetAttributeValueAtTime(FirstType, 1.5, Value));
+	TestEqual(TEXT("Value between frames"), Value, 20.f);
+
+	/** 回滚期间查询历史值时，从属性的真实当前值开始回溯 */
+	TestTrue(TEXT("Rewind before every frame"), AbilitySystem->RewindAttributesToTime(0.5));
+	TestEqual(TEXT("Rewound value"), AbilitySystem->GetAttributeValue(FirstType), 0.f);
+	TestEqual(TEXT("Rewound out of range attribute"), AbilitySystem->GetAttributeValue(AttributeType_Max), 0.f);
+	TestTrue(TEXT("Query after every frame while rewound"), AbilitySystem->GetAttributeValueAtTime(FirstType, 2.5, Value));
+	TestEqual(TEXT("Value after every frame while rewound"), Value, 30.f);
+	AbilitySystem->RestoreRewoundAttributes();
+	TestEqual(TEXT("Restored value"), AbilitySystem->GetAttributeValue(FirstType), 30.f);
+
+	/** 环形缓冲写满后覆盖最早的帧，早于最早一帧的查询失败 */
+	AdvanceFrame(TestWorld.World, 3.0);
+	AbilitySystem->ApplyModifierToAttributeInstant(SecondType, EFireflyAttributeModOperator::Plus, ModSource, 1.f);
+	AdvanceFrame(TestWorld.World, 4.0);
+	AbilitySystem->ApplyModifierToAttributeInstant(SecondType, EFireflyAttributeModOperator::Plus, ModSource, 1.f);
+
+	TestFalse(TEXT("Query before the overwritten frame"), AbilitySystem->GetAttributeValueAtTime(FirstType, 0.5, Value));
+	TestFalse(TEXT("Query before the oldest frame"), AbilitySystem->GetAttributeValueAtTime(FirstType, 1.5, Value));
+	TestTrue(TEXT("Query within the wrapped buffer"), AbilitySystem->GetAttributeValueAtTime(SecondType, 2.5, Value));
+	TestEqual(TEXT("Value within the wrapped buffer"), Value, 0.f);
+	TestTrue(TEXT("Query between wrapped frames"), AbilitySystem->GetAttributeValueAtTime(SecondType, 3.5, Value));
+	TestEqual(TEXT("Value between wrapped frames"), Value, 1.f);
+
+	/** 某帧变化的属性数超出每帧最大记录数后，跨越该帧的查询和回滚失败 */
+	AdvanceFrame(TestWorld.World, 5.0);
+	AbilitySystem->ApplyModifierToAttributeInstant(FirstType, EFireflyAttributeModOperator::Plus, ModSource, 1.f);
+	AbilitySystem->ApplyModifierToAttributeInstant(SecondType, EFireflyAttributeModOperator::Plus, ModSource, 1.f);
+	AbilitySystem->ApplyModifierToAttributeInstant(ThirdType, EFireflyAttributeModOperator::Plus, ModSource, 1.f);
+
+	TestFalse(TEXT("Query across the overflowed frame"), AbilitySystem->GetAttributeValueAtTime(SecondType, 4.5, Value));
+	TestFalse(TEXT("Rewind across the overflowed frame"), AbilitySystem->RewindAttributesToTime(4.5));
+	TestFalse(TEXT("Rewound after a failed rewind"), AbilitySystem->IsAttributeRewound());
+	TestTrue(TEXT("Query after the overflowed frame"), AbilitySystem->GetAttributeValueAtTime(ThirdType, 5.5, Value));
+	TestEqual(TEXT("Value after the overflowed frame"), Value, 1.f);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyAttributeHistoryWhileRewoundTest, "FireflyAbilitySystem.Attribute.HistoryChangesWhileRewound",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyAttributeHistoryWhileRewoundTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyAttributeHistoryTest;
+
+	UFireflyAbilitySystemSettings* Settings = UFireflyAbilitySystemSettings::Get();
+	TGuardValue<bool> EnableGuard(Settings->bEnableAttributeHistory, true);
+	TGuardValue<int32> FrameCountGuard(Settings->AttributeHistoryFrameCount, 8);
+	TGuardValue<int32> MaxChangesGuard(Settings->AttributeHistoryMaxChangesPerFrame, 4);
+
+	FFireflyAutomationTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+	ConstructRangedAttributes(AbilitySystem);
+	AbilitySystem->GetOwner()->DispatchBeginPlay();
+
+	UObject* ModSource = AbilitySystem;
+	float Value = 0.f;
+
+	/** 最大生命值提升到200，生命值随后提升到170 */
+	AdvanceFrame(TestWorld.World, 1.0);
+	AbilitySystem->ApplyModifierToAttributeInstant(FirstType, EFireflyAttributeModOperator::Plus, ModSource, 100.f);
+	AdvanceFrame(TestWorld.World, 2.0);
+	AbilitySystem->ApplyModifierToAttributeInstant(SecondType, EFireflyAttributeModOperator::Plus, ModSource, 70.f);
+
+	/** 回滚到最大生命值为100的时间，此时生命值的真实变化仍按当前的最大生命值夹值 */
+	TestTrue(TEXT("Rewind before every frame"), AbilitySystem->RewindAttributesToTime(0.5));
+	TestEqual(TEXT("Rewound max health"), AbilitySystem->GetAttributeValue(FirstType), 100.f);
+
+	AdvanceFrame(TestWorld.World, 3.0);
+	AbilitySystem->ApplyModifierToAttributeInstant(SecondType, EFireflyAttributeModOperator::Plus, ModSource, 50.f);
+	TestEqual(TEXT("Live health clamped by live max health"), AbilitySystem->GetLiveAttributeValue(SecondType), 200.f);
+	TestEqual(TEXT("Rewound health is unchanged"), AbilitySystem->GetAttributeValue(SecondType), 100.f);
+
+	AbilitySystem->RestoreRewoundAttributes();
+	TestEqual(TEXT("Restored health"), AbilitySystem->GetAttributeValue(SecondType), 200.f);
+
+	/** 回滚期间的变化被记录到历史中 */
+	TestTrue(TEXT("Query before the change made while rewound"), AbilitySystem->GetAttributeValueAtTime(SecondType, 2.5, Value));
+	TestEqual(TEXT("Health before the change made while rewound"), Value, 170.f);
+	TestTrue(TEXT("Query after the change made while rewound"), AbilitySystem->GetAttributeValueAtTime(SecondType, 3.5, Value));
+	TestEqual(TEXT("Health after the change made while rewound"), Value, 200.f);
+
+	TestTrue(TEXT("Rewind across the change made while rewound"), AbilitySystem->RewindAttributesToTime(2.5));
+	TestEqual(TEXT("Health rewound across the change made while rewound"), AbilitySystem->GetAttributeValue(SecondType), 170.f);
+	AbilitySystem->RestoreRewoundAttributes();
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,121 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyAttribute.h"
+
+#include "FireflyAbilitySystemModule.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FireflyAttributeMemoryTest
+{
+	/** 修改器改为槽位存储之前的修改器结构 */
+	struct FLegacyModifier
+	{
+		UObject* ModSource = nullptr;
+		float ModValue = 0.f;
+		int32 StackCount = 0;
+		bool bIsActive = true;
+	};
+
+	/** 修改器改为槽位存储之前，属性按运算符分别使用一个数组存储修改器 */
+	struct FLegacyModifierLayout
+	{
+		TArray<FLegacyModifier> PlusMods;
+		TArray<FLegacyModifier> MinusMods;
+		TArray<FLegacyModifier> MultiplyMods;
+		TArray<FLegacyModifier> DivideMods;
+		TArray<FLegacyModifier> InnerOverrideMods;
+		TArray<FLegacyModifier> OuterOverrideMods;
+
+		TArray<FLegacyModifier>& GetModsByOperator(EFireflyAttributeModOperator ModOperator)
+		{
+			switch (ModOperator)
+			{
+			case EFireflyAttributeModOperator::Minus:
+				return MinusMods;
+			case EFireflyAttributeModOperator::Multiply:
+				return MultiplyMods;
+			case EFireflyAttributeModOperator::Divide:
+				return DivideMods;
+			case EFireflyAttributeModOperator::InnerOverride:
+				return InnerOverrideMods;
+			case EFireflyAttributeModOperator::OuterOverride:
+				return OuterOverrideMods;
+			default:
+				return PlusMods;
+			}
+		}
+
+		SIZE_T GetAllocatedSize() const
+		{
+			return PlusMods.GetAllocatedSize() + MinusMods.GetAllocatedSize() + MultiplyMods.GetAllocatedSize()
+				+ DivideMods.GetAllocatedSize() + InnerOverrideMods.GetAllocatedSize() + OuterOverrideMods.GetAllocatedSize();
+		}
+	};
+
+	/** 修改器按常见的先后顺序轮流使用的运算符 */
+	const EFireflyAttributeModOperator ModOperatorsInUse[] =
+	{
+		EFireflyAttributeModOperator::Plus,
+		EFireflyAttributeModOperator::Multiply,
+		EFireflyAttributeModOperator::Minus,
+		EFireflyAttributeModOperator::Divide,
+		EFireflyAttributeModOperator::InnerOverride,
+		EFireflyAttributeModOperator::OuterOverride,
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyAttributeModifierMemoryTest, "FireflyAbilitySystem.Attribute.ModifierMemory",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyAttributeModifierMemoryTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyAttributeMemoryTest;
+
+	UObject* ModSource = GetTransientPackage();
+	const int32 ModifierCountsToReport[] = { 0, 1, 2, 3, 4, 6, 8 };
+
+	for (const int32 ModifierCount : ModifierCountsToReport)
+	{
+		FFireflyAttributeModifierContainer Modifiers;
+		FLegacyModifierLayout LegacyModifiers;
+		for (int32 i = 0; i < ModifierCount; ++i)
+		{
+			const EFireflyAttributeModOperator ModOperator = ModOperatorsInUse[i % UE_ARRAY_COUNT(ModOperatorsInUse)];
+			Modifiers.AddModifier(ModOperator, ModSource, 1.f, 1);
+
+			FLegacyModifier& LegacyModifier = LegacyModifiers.GetModsByOperator(ModOperator).AddDefaulted_GetRef();
+			LegacyModifier.ModSource = ModSource;
+			LegacyModifier.ModValue = 1.f;
+			LegacyModifier.StackCount = 1;
+		}
+
+		const SIZE_T Bytes = sizeof(FFireflyAttributeModifierContainer) + Modifiers.GetAllocatedSize();
+		const SIZE_T LegacyBytes = sizeof(FLegacyModifierLayout) + LegacyModifiers.GetAllocatedSize();
+
+		UE_LOG(LogFireflyAttribute, Display, TEXT("%d modifiers: %d bytes per attribute (%d heap), legacy six-array layout %d bytes (%d heap)"),
+			ModifierCount, static_cast<int32>(Bytes), static_cast<int32>(Modifiers.GetAllocatedSize()),
+			static_cast<int32>(LegacyBytes), static_cast<int32>(LegacyModifiers.GetAllocatedSize()));
+
+		/** 不超过内联容量的修改器不产生堆分配，且总占用少于按运算符分数组的布局 */
+		if (ModifierCount <= 2)
+		{
+			TestEqual(FString::Printf(TEXT("Heap bytes with %d modifiers"), ModifierCount), static_cast<int32>(Modifiers.GetAllocatedSize()), 0);
+			TestTrue(FString::Printf(TEXT("Inline buffer is smaller than the legacy layout with %d modifiers"), ModifierCount), Bytes < LegacyBytes);
+		}
+	}
+
+	/** 属性实例整体的大小，与Firefly.Attribute.ReportMemory的输出一致 */
+	UFireflyAttribute* Attribute = NewObject<UFireflyAttribute>(GetTransientPackage());
+	UE_LOG(LogFireflyAttribute, Display, TEXT("UFireflyAttribute: %d object bytes, %d modifier heap bytes"),
+		UFireflyAttribute::StaticClass()->GetStructureSize(), static_cast<int32>(Attribute->GetModifierHeapSize()));
+	TestEqual(TEXT("Modifier heap bytes of a new attribute"), static_cast<int32>(Attribute->GetModifierHeapSize()), 0);
+	Attribute->MarkAsGarbage();
+
+	return true;
+}
+
+#endif
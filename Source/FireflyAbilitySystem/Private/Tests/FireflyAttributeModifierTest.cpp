@@ -0,0 +1,78 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyAbilitySystemComponent.h"
+
+#include "Tests/FireflyAutomationTestWorld.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FireflyAttributeModifierTest
+{
+	constexpr EFireflyAttributeType AttributeType = AttributeType001;
+
+	/** 生成技能系统组件，并构建一个初始值为0的属性 */
+	UFireflyAbilitySystemComponent* SpawnAbilitySystemWithAttribute(const FFireflyAutomationTestWorld& TestWorld)
+	{
+		UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+		FFireflyAttributeConstructor Constructor;
+		Constructor.AttributeType = AttributeType;
+		AbilitySystem->ConstructAttributeByConstructor(Constructor);
+		AbilitySystem->InitializeAttributeByType(AttributeType, 0.f);
+
+		return AbilitySystem;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyAttributeModifierLegacyStackTest, "FireflyAbilitySystem.Attribute.LegacyModifierApplyStacks",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyAttributeModifierLegacyStackTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyAttributeModifierTest;
+
+	FFireflyAutomationTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = SpawnAbilitySystemWithAttribute(TestWorld);
+	UObject* ModSource = AbilitySystem->GetOwner();
+
+	/** 来源和值都相同时，旧接口复用已有的修改器，仅重设其堆叠数 */
+	AbilitySystem->ApplyModifierToAttribute(AttributeType, EFireflyAttributeModOperator::Plus, ModSource, 5.f, 1);
+	AbilitySystem->ApplyModifierToAttribute(AttributeType, EFireflyAttributeModOperator::Plus, ModSource, 5.f, 3);
+	TestEqual(TEXT("Value after restacking"), AbilitySystem->GetAttributeValue(AttributeType), 15.f);
+
+	AbilitySystem->RemoveModifierFromAttribute(AttributeType, EFireflyAttributeModOperator::Plus, ModSource, 5.f);
+	TestEqual(TEXT("Value after removal"), AbilitySystem->GetAttributeValue(AttributeType), 0.f);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyAttributeModifierHandleTest, "FireflyAbilitySystem.Attribute.HandleModifiersAreIndependent",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyAttributeModifierHandleTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyAttributeModifierTest;
+
+	FFireflyAutomationTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = SpawnAbilitySystemWithAttribute(TestWorld);
+	UObject* ModSource = AbilitySystem->GetOwner();
+
+	/** 来源和值都相同的修改器各自占用一个槽位 */
+	const FFireflyModifierHandle FirstHandle = AbilitySystem->ApplyModifierToAttributeWithHandle(AttributeType,
+		EFireflyAttributeModOperator::Plus, ModSource, 5.f, 1);
+	const FFireflyModifierHandle SecondHandle = AbilitySystem->ApplyModifierToAttributeWithHandle(AttributeType,
+		EFireflyAttributeModOperator::Plus, ModSource, 5.f, 1);
+	TestFalse(TEXT("Handles are shared"), FirstHandle == SecondHandle);
+	TestEqual(TEXT("Value with both modifiers"), AbilitySystem->GetAttributeValue(AttributeType), 10.f);
+
+	/** 移除一个句柄不影响另一个 */
+	AbilitySystem->RemoveModifierByHandle(FirstHandle);
+	TestFalse(TEXT("Removed handle is invalid"), AbilitySystem->IsModifierHandleValid(FirstHandle));
+	TestTrue(TEXT("Other handle is still valid"), AbilitySystem->IsModifierHandleValid(SecondHandle));
+	TestEqual(TEXT("Value after removing one handle"), AbilitySystem->GetAttributeValue(AttributeType), 5.f);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,239 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyAbilitySystemComponent.h"
+
+#include "Tests/FireflyAutomationTestWorld.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FireflyAttributeTransactionTest
+{
+	constexpr EFireflyAttributeType MaxHealthType = AttributeType001;
+	constexpr EFireflyAttributeType HealthType = AttributeType002;
+	constexpr EFireflyAttributeType ArmorType = AttributeType003;
+
+	/** 构造最大生命值、以最大生命值为上限的生命值和不夹值的护甲，生命值为满值 */
+	void ConstructTestAttributes(UFireflyAbilitySystemComponent* AbilitySystem)
+	{
+		FFireflyAttributeConstructor MaxHealth;
+		MaxHealth.AttributeType = MaxHealthType;
+		AbilitySystem->ConstructAttributeByConstructor(MaxHealth);
+
+		FFireflyAttributeConstructor Health;
+		Health.AttributeType = HealthType;
+		Health.bAttributeHasRange = true;
+		Health.RangeMinValue = 0.f;
+		Health.RangeMaxValueType = MaxHealthType;
+		AbilitySystem->ConstructAttributeByConstructor(Health);
+
+		FFireflyAttributeConstructor Armor;
+		Armor.AttributeType = ArmorType;
+		AbilitySystem->ConstructAttributeByConstructor(Armor);
+
+		AbilitySystem->InitializeAttributeByType(MaxHealthType, 100.f);
+		AbilitySystem->InitializeAttributeByType(HealthType, 100.f);
+		AbilitySystem->InitializeAttributeByType(ArmorType, 0.f);
+	}
+
+	FFireflyEffectModifierData MakeModifier(EFireflyAttributeType AttributeType, float ModValue)
+	{
+		FFireflyEffectModifierData Modifier;
+		Modifier.AttributeType = AttributeType;
+		Modifier.ModOperator = EFireflyAttributeModOperator::Plus;
+		Modifier.ModValue = ModValue;
+
+		return Modifier;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyAttributeTransactionClampTest, "FireflyAbilitySystem.Attribute.TransactionReadsFreshValues",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyAttributeTransactionClampTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyAttributeTransactionTest;
+
+	FFireflyAutomationTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+	ConstructTestAttributes(AbilitySystem);
+
+	int32 NumHealthBroadcasts = 0;
+	float BroadcastOldHealth = 0.f;
+	float BroadcastNewHealth = 0.f;
+	AbilitySystem->GetAttributeValueChangeDelegate(HealthType).AddLambda(
+		[&NumHealthBroadcasts, &BroadcastOldHealth, &BroadcastNewHealth](EFireflyAttributeType, float NewValue, float OldValue)
+		{
+			++NumHealthBroadcasts;
+			BroadcastNewHealth = NewValue;
+			BroadcastOldHealth = OldValue;
+		});
+
+	/** 满生命值时同一个Instant效果先提高最大生命值再恢复生命值，恢复的生命值不应被旧的上限截断 */
+	FFireflyEffectDynamicConstructor EffectSetup;
+	EffectSetup.DurationPolicy = EFireflyEffectDurationPolicy::Instant;
+	EffectSetup.Modifiers.Add(MakeModifier(MaxHealthType, 50.f));
+	EffectSetup.Modifiers.Add(MakeModifier(HealthType, 50.f));
+
+	/** 取值于最大生命值的修改器读到的是本次效果修改后的值 */
+	FFireflyEffectModifierData ArmorModifier = MakeModifier(ArmorType, 0.f);
+	ArmorModifier.ModValueMethod = EFireflyEffectModifierValueMethod::UsingAttribute;
+	ArmorModifier.AttributeTypeUsing = MaxHealthType;
+	EffectSetup.Modifiers.Add(ArmorModifier);
+
+	AbilitySystem->ApplyEffectDynamicConstructorToOwner(nullptr, EffectSetup);
+
+	TestEqual(TEXT("MaxHealth"), AbilitySystem->GetAttributeValue(MaxHealthType), 150.f);
+	TestEqual(TEXT("Health keeps the gain clamped against the new MaxHealth"), AbilitySystem->GetAttributeValue(HealthType), 150.f);
+	TestEqual(TEXT("Health base value"), AbilitySystem->GetAttributeBaseValue(HealthType), 150.f);
+	TestEqual(TEXT("UsingAttribute value reads the updated MaxHealth"), AbilitySystem->GetAttributeValue(ArmorType), 150.f);
+
+	/** 事务中的变化在提交时只广播一次 */
+	TestEqual(TEXT("Health broadcasts"), NumHealthBroadcasts, 1);
+	TestEqual(TEXT("Broadcast old Health"), BroadcastOldHealth, 100.f);
+	TestEqual(TEXT("Broadcast new Health"), BroadcastNewHealth, 150.f);
+
+	/** 手动开启的事务中，读取到的值同样是最新的 */
+	AbilitySystem->BeginModifierTransaction();
+	AbilitySystem->ApplyModifierToAttributeInstant(MaxHealthType, EFireflyAttributeModOperator::Plus, AbilitySystem, 50.f);
+	TestEqual(TEXT("MaxHealth inside a transaction"), AbilitySystem->GetAttributeValue(MaxHealthType), 200.f);
+	AbilitySystem->ApplyModifierToAttributeInstant(HealthType, EFireflyAttributeModOperator::Plus, AbilitySystem, 50.f);
+	TestEqual(TEXT("Broadcasts are deferred inside a transaction"), NumHealthBroadcasts, 1);
+	AbilitySystem->CommitModifierTransaction();
+
+	TestEqual(TEXT("Health after a manual transaction"), AbilitySystem->GetAttributeValue(HealthType), 200.f);
+	TestEqual(TEXT("Health broadcasts after a manual transaction"), NumHealthBroadcasts, 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyAttributeTransactionDeferredRecomputeTest, "FireflyAbilitySystem.Attribute.TransactionDefersRecompute",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyAttributeTransactionDeferredRecomputeTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyAttributeTransactionTest;
+
+	FFireflyAutomationTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+	ConstructTestAttributes(AbilitySystem);
+
+	int32 NumHealthBroadcasts = 0;
+	AbilitySystem->GetAttributeValueChangeDelegate(HealthType).AddLambda([&NumHealthBroadcasts](EFireflyAttributeType, float, float)
+	{
+		++NumHealthBroadcasts;
+	});
+
+	/** 事务中的修改器只标记属性，依赖于被修改属性的属性也随之过期 */
+	AbilitySystem->BeginModifierTransaction();
+	for (int32 i = 0; i < 3; ++i)
+	{
+		AbilitySystem->ApplyModifierToAttributeWithHandle(MaxHealthType, EFireflyAttributeModOperator::Minus, AbilitySystem, 10.f, 1);
+	}
+	TestTrue(TEXT("MaxHealth is stale inside a transaction"), AbilitySystem->IsAttributeValueStale(MaxHealthType));
+	TestTrue(TEXT("Health depending on MaxHealth is stale inside a transaction"), AbilitySystem->IsAttributeValueStale(HealthType));
+	TestFalse(TEXT("Unrelated Armor is not stale"), AbilitySystem->IsAttributeValueStale(ArmorType));
+
+	/** 读取过期的属性时先行重新计算 */
+	TestEqual(TEXT("Health read inside a transaction"), AbilitySystem->GetAttributeValue(HealthType), 70.f);
+	TestFalse(TEXT("Health is fresh after being read"), AbilitySystem->IsAttributeValueStale(HealthType));
+	TestEqual(TEXT("Broadcasts are deferred after a read"), NumHealthBroadcasts, 0);
+
+	AbilitySystem->ApplyModifierToAttributeWithHandle(MaxHealthType, EFireflyAttributeModOperator::Minus, AbilitySystem, 10.f, 1);
+	TestTrue(TEXT("Health is stale again after another modifier"), AbilitySystem->IsAttributeValueStale(HealthType));
+	AbilitySystem->CommitModifierTransaction();
+
+	/** 提交时重新计算剩余的过期属性，每个属性只广播一次 */
+	TestFalse(TEXT("Health is fresh after commit"), AbilitySystem->IsAttributeValueStale(HealthType));
+	TestEqual(TEXT("MaxHealth after commit"), AbilitySystem->GetAttributeValue(MaxHealthType), 60.f);
+	TestEqual(TEXT("Health after commit"), AbilitySystem->GetAttributeValue(HealthType), 60.f);
+	TestEqual(TEXT("Health broadcasts after commit"), NumHealthBroadcasts, 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyAttributeTransactionBaseValueTest, "FireflyAbilitySystem.Attribute.TransactionCoalescesBaseValueSets",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyAttributeTransactionBaseValueTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyAttributeTransactionTest;
+
+	FFireflyAutomationTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+	ConstructTestAttributes(AbilitySystem);
+
+	int32 NumBaseBroadcasts = 0;
+	float BroadcastOldBase = 0.f;
+	float BroadcastNewBase = 0.f;
+	AbilitySystem->GetAttributeBaseValueChangeDelegate(ArmorType).AddLambda(
+		[&NumBaseBroadcasts, &BroadcastOldBase, &BroadcastNewBase](EFireflyAttributeType, float NewValue, float OldValue)
+		{
+			++NumBaseBroadcasts;
+			BroadcastNewBase = NewValue;
+			BroadcastOldBase = OldValue;
+		});
+
+	int32 NumBroadcasts = 0;
+	AbilitySystem->GetAttributeValueChangeDelegate(ArmorType).AddLambda([&NumBroadcasts](EFireflyAttributeType, float, float)
+	{
+		++NumBroadcasts;
+	});
+
+	/** 同一事务中既设置基础值又应用修改器，提交时每个属性只广播一次从事务开始前的值到最终值的变化 */
+	AbilitySystem->BeginModifierTransaction();
+	AbilitySystem->InitializeAttributeByType(ArmorType, 5.f);
+	AbilitySystem->ApplyModifierToAttributeInstant(ArmorType, EFireflyAttributeModOperator::Plus, AbilitySystem, 10.f);
+	AbilitySystem->InitializeAttributeByType(ArmorType, 20.f);
+	TestEqual(TEXT("Base value broadcasts inside a transaction"), NumBaseBroadcasts, 0);
+	TestEqual(TEXT("Current value broadcasts inside a transaction"), NumBroadcasts, 0);
+	AbilitySystem->CommitModifierTransaction();
+
+	TestEqual(TEXT("Base value broadcasts"), NumBaseBroadcasts, 1);
+	TestEqual(TEXT("Broadcast old base value"), BroadcastOldBase, 0.f);
+	TestEqual(TEXT("Broadcast new base value"), BroadcastNewBase, 20.f);
+	TestEqual(TEXT("Current value broadcasts"), NumBroadcasts, 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyAttributeUnbalancedTransactionTest, "FireflyAbilitySystem.Attribute.UnbalancedTransactionFlushedAtEndOfFrame",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyAttributeUnbalancedTransactionTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyAttributeTransactionTest;
+
+	FFireflyAutomationTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+	ConstructTestAttributes(AbilitySystem);
+
+	int32 NumArmorBroadcasts = 0;
+	AbilitySystem->GetAttributeValueChangeDelegate(ArmorType).AddLambda([&NumArmorBroadcasts](EFireflyAttributeType, float, float)
+	{
+		++NumArmorBroadcasts;
+	});
+
+	/** 开启的事务没有被提交，例如蓝图调用者提前返回 */
+	AbilitySystem->BeginModifierTransaction();
+	AbilitySystem->BeginModifierTransaction();
+	AbilitySystem->ApplyModifierToAttributeInstant(ArmorType, EFireflyAttributeModOperator::Plus, AbilitySystem, 10.f);
+	AbilitySystem->CommitModifierTransaction();
+	TestEqual(TEXT("Broadcasts inside the unbalanced transaction"), NumArmorBroadcasts, 0);
+
+	/** 帧末报告不配对的调用，结束所有事务并广播推迟的变化 */
+	AddExpectedError(TEXT("was not committed before end of frame"), EAutomationExpectedErrorFlags::Contains, 1);
+	AbilitySystem->TickComponent(0.f, LEVELTICK_All, &AbilitySystem->PrimaryComponentTick);
+	TestFalse(TEXT("Transaction is closed at end of frame"), AbilitySystem->IsInModifierTransaction());
+	TestEqual(TEXT("Broadcasts after end of frame"), NumArmorBroadcasts, 1);
+
+	/** 之后的修改不再被推迟 */
+	AbilitySystem->ApplyModifierToAttributeInstant(ArmorType, EFireflyAttributeModOperator::Plus, AbilitySystem, 10.f);
+	TestEqual(TEXT("Broadcasts after the transaction is closed"), NumArmorBroadcasts, 2);
+	TestEqual(TEXT("Armor"), AbilitySystem->GetAttributeValue(ArmorType), 20.f);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,41 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyEffect.h"
+
+#include "FireflyAbilitySystemModule.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyEffectInstanceMemoryTest, "FireflyAbilitySystem.Effect.InstanceMemory",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyEffectInstanceMemoryTest::RunTest(const FString& Parameters)
+{
+	/** 只用于迁移旧资产的属性只存在于编辑器中，不计入打包后效果实例的大小 */
+	int32 MigrationOnlyBytes = 0;
+	for (TFieldIterator<FProperty> It(UFireflyEffect::StaticClass()); It; ++It)
+	{
+		if (It->HasAnyPropertyFlags(CPF_Deprecated))
+		{
+			MigrationOnlyBytes += It->GetSize();
+			continue;
+		}
+
+		/** Tag容器等配置只保存在稀疏类数据中，效果实例上不应再有这些属性 */
+		const FStructProperty* StructProperty = CastField<FStructProperty>(*It);
+		TestFalse(FString::Printf(TEXT("%s is stored on every effect instance"), *It->GetName()),
+			StructProperty && StructProperty->Struct == FGameplayTagContainer::StaticStruct());
+	}
+
+	const int32 InstanceBytes = UFireflyEffect::StaticClass()->GetStructureSize() - MigrationOnlyBytes;
+	const int32 ClassDataBytes = FFireflyEffectSparseClassData::StaticStruct()->GetStructureSize();
+
+	UE_LOG(LogFireflyEffect, Display, TEXT("UFireflyEffect: %d bytes per instance, %d bytes per class in sparse class data, %d bytes per instance when the configuration was copied to every instance"),
+		InstanceBytes, ClassDataBytes, InstanceBytes + ClassDataBytes);
+
+	return true;
+}
+
+#endif
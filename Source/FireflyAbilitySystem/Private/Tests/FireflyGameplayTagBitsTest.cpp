@@ -0,0 +1,142 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyGameplayTagBits.h"
+
+#include "FireflyAbilitySystemComponent.h"
+#include "Tests/FireflyAutomationTestWorld.h"
+#include "FireflyEffect.h"
+#include "Misc/AutomationTest.h"
+#include "NativeGameplayTags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FireflyGameplayTagBitsTest
+{
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_TagBitsTest_Parent, "FireflyTest.TagBits.Parent");
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_TagBitsTest_Child, "FireflyTest.TagBits.Parent.Child");
+	UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_TagBitsTest_Other, "FireflyTest.TagBits.Other");
+
+	/** 参与比较的Tag集合，覆盖空集合、父级Tag、子级Tag和无关的Tag */
+	TArray<FGameplayTagContainer> MakeTestContainers()
+	{
+		const FGameplayTag Parent = TAG_TagBitsTest_Parent;
+		const FGameplayTag Child = TAG_TagBitsTest_Child;
+		const FGameplayTag Other = TAG_TagBitsTest_Other;
+
+		TArray<FGameplayTagContainer> Containers;
+		Containers.Emplace();
+		Containers.Emplace(Parent);
+		Containers.Emplace(Child);
+		Containers.Emplace(Other);
+		Containers.Emplace(FGameplayTagContainer::CreateFromArray(TArray<FGameplayTag>{ Parent, Other }));
+		Containers.Emplace(FGameplayTagContainer::CreateFromArray(TArray<FGameplayTag>{ Child, Other }));
+		Containers.Emplace(FGameplayTagContainer::CreateFromArray(TArray<FGameplayTag>{ Parent, Child }));
+
+		return Containers;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyGameplayTagBitsQueryTest, "FireflyAbilitySystem.GameplayTagBits.MatchesTagContainerQueries",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyGameplayTagBitsQueryTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyGameplayTagBitsTest;
+
+	const TArray<FGameplayTagContainer> Containers = MakeTestContainers();
+	for (const FGameplayTagContainer& Tags : Containers)
+	{
+		const FFireflyGameplayTagBits TagsExact = FFireflyGameplayTagBits::MakeExact(Tags);
+		const FFireflyGameplayTagBits TagsWithParents = FFireflyGameplayTagBits::MakeWithParents(Tags);
+
+		for (const FGameplayTagContainer& OtherTags : Containers)
+		{
+			const FFireflyGameplayTagBits OtherExact = FFireflyGameplayTagBits::MakeExact(OtherTags);
+			const FString Pair = FString::Printf(TEXT("[%s] vs [%s]"), *Tags.ToStringSimple(), *OtherTags.ToStringSimple());
+
+			TestEqual(TEXT("HasAll ") + Pair, TagsWithParents.HasAll(OtherExact), Tags.HasAll(OtherTags));
+			TestEqual(TEXT("HasAny ") + Pair, TagsWithParents.HasAny(OtherExact), Tags.HasAny(OtherTags));
+			TestEqual(TEXT("HasAllExact ") + Pair, TagsExact.HasAll(OtherExact), Tags.HasAllExact(OtherTags));
+			TestEqual(TEXT("HasAnyExact ") + Pair, TagsExact.HasAny(OtherExact), Tags.HasAnyExact(OtherTags));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyGameplayTagBitsApplicationTest, "FireflyAbilitySystem.GameplayTagBits.MatchesEffectApplicationBlocking",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyGameplayTagBitsApplicationTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyGameplayTagBitsTest;
+
+	FFireflyAutomationTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+
+	const TArray<FGameplayTagContainer> Containers = MakeTestContainers();
+	for (const FGameplayTagContainer& OwnerTags : Containers)
+	{
+		/** 拥有的Tag通过管理器的接口添加，位集合由管理器自己维护 */
+		AbilitySystem->AddTagsToManager(OwnerTags);
+
+		for (const FGameplayTagContainer& RequireTags : Containers)
+		{
+			for (const FGameplayTagContainer& BlockTags : Containers)
+			{
+				const FFireflyEffectApplicationTagBits TagBits(FGameplayTagContainer::EmptyContainer, RequireTags, BlockTags);
+				const FString Case = FString::Printf(TEXT("Require [%s] Block [%s] Owner [%s]"),
+					*RequireTags.ToStringSimple(), *BlockTags.ToStringSimple(), *OwnerTags.ToStringSimple());
+
+				/** 改用位集合之前管理器的判定：要求的Tags包含拥有者的所有Tags，且拥有者不含任何阻挡的Tag */
+				const FGameplayTagContainer& ContainedTags = AbilitySystem->GetContainedTags();
+				const bool bBlocked = !RequireTags.HasAll(ContainedTags) || BlockTags.HasAnyExact(ContainedTags);
+
+				TestEqual(TEXT("Application blocked ") + Case, AbilitySystem->IsEffectApplicationBlocked(TagBits), bBlocked);
+			}
+		}
+
+		AbilitySystem->RemoveTagsFromManager(OwnerTags);
+		TestTrue(FString::Printf(TEXT("Owned tag bits are empty after removing [%s]"), *OwnerTags.ToStringSimple()),
+			AbilitySystem->GetOwnedTagBits().IsEmpty() && AbilitySystem->GetOwnedTagBitsWithParents().IsEmpty());
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyGameplayTagBitsParentCountTest, "FireflyAbilitySystem.GameplayTagBits.OwnedParentBitsFollowRemoval",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyGameplayTagBitsParentCountTest::RunTest(const FString& Parameters)
+{
+	using namespace FireflyGameplayTagBitsTest;
+
+	FFireflyAutomationTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+
+	const FGameplayTag Parent = TAG_TagBitsTest_Parent;
+	const FGameplayTag Child = TAG_TagBitsTest_Child;
+	const FFireflyGameplayTagBits ParentBits = FFireflyGameplayTagBits::MakeExact(FGameplayTagContainer(Parent));
+	const FFireflyGameplayTagBits ChildBits = FFireflyGameplayTagBits::MakeExact(FGameplayTagContainer(Child));
+
+	/** 父级Tag同时被显式拥有和作为子级Tag的父级引用，移除任意一方后仍然保留 */
+	AbilitySystem->AddTagToManager(Parent);
+	AbilitySystem->AddTagToManager(Child);
+
+	AbilitySystem->RemoveTagFromManager(Child);
+	TestTrue(TEXT("Parent bit after removing the child"), AbilitySystem->GetOwnedTagBitsWithParents().HasAll(ParentBits));
+	TestFalse(TEXT("Child bit after removing the child"), AbilitySystem->GetOwnedTagBitsWithParents().HasAny(ChildBits));
+
+	AbilitySystem->AddTagToManager(Child);
+	AbilitySystem->RemoveTagFromManager(Parent);
+	TestTrue(TEXT("Parent bit after removing the explicit parent"), AbilitySystem->GetOwnedTagBitsWithParents().HasAll(ParentBits));
+	TestFalse(TEXT("Explicit parent bit after removing the explicit parent"), AbilitySystem->GetOwnedTagBits().HasAny(ParentBits));
+
+	AbilitySystem->RemoveTagFromManager(Child);
+	TestTrue(TEXT("Bits with parents after removing every tag"), AbilitySystem->GetOwnedTagBitsWithParents().IsEmpty());
+
+	return true;
+}
+
+#endif
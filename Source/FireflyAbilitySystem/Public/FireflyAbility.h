@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "FireflyAbilitySystemTypes.h"
+#include "FireflyGameplayTagBits.h"
 #include "GameplayTagContainer.h"
 #include "UObject/NoExportTypes.h"
 #include "FireflyAbility.generated.h"
@@ -265,6 +266,29 @@ protected:
 	UFUNCTION()
 	void ExecuteAbilityTagRequirementToOwner(bool bIsActivated);
 
+public:
+	/** 技能资产Tags的位集合 */
+	const FFireflyGameplayTagBits& GetTagsForAbilityAssetBits() const;
+
+protected:
+	/** 第一次使用时根据技能的Tag容器构建预计算的位集合，技能的Tag容器只在类型中配置 */
+	void BuildTagBits() const;
+
+	/** 预计算的位集合是否已构建 */
+	mutable bool bTagBitsBuilt = false;
+
+	/** TagsForAbilityAsset的位集合 */
+	mutable FFireflyGameplayTagBits TagsForAbilityAssetBits;
+
+	/** TagsRequireOwnerHasForActivation的位集合 */
+	mutable FFireflyGameplayTagBits TagsRequireOwnerHasForActivationBits;
+
+	/** TagsBlockActivationOnOwnerHas的位集合 */
+	mutable FFireflyGameplayTagBits TagsBlockActivationOnOwnerHasBits;
+
+	/** TagsOfAbilitiesWillBeCanceled的位集合 */
+	mutable FFireflyGameplayTagBits TagsOfAbilitiesWillBeCanceledBits;
+
 protected:
 	/** 该技能的激活需要的正在执行的技能的类型，数组中有一个技能正在激活，都可以让该技能激活 */
 	UPROPERTY(EditDefaultsOnly, Category = "ActivationRequirement|AbilityRequired")
@@ -518,6 +542,11 @@ protected:
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Effect", Meta = (BlueprintProtected = true))
 	void ApplyEffectToTargetByClass(AActor* Target, TSubclassOf<UFireflyEffect> EffectType, FName EffectID = NAME_None, int32 StackToApply = 1);
 
+	/** 为多个目标应用同一种效果，返回每个目标的应用结果，必须在拥有权限端执行，否则无效 */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Effect", Meta = (BlueprintProtected = true))
+	TArray<EFireflyEffectApplicationResult> ApplyEffectToTargetsByClass(const TArray<AActor*>& Targets, TSubclassOf<UFireflyEffect> EffectType,
+		FName EffectID = NAME_None, int32 StackToApply = 1);
+
 	/** 为目标应用一个根据动态构造器实现的效果，必须在拥有权限端执行，否则无效 */
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Effect", Meta = (BlueprintProtected = true))
 	void ApplyEffectDynamicConstructorToOwner(FFireflyEffectDynamicConstructor EffectSetup, int32 StackToApply = 1);
@@ -0,0 +1,65 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "FireflyAbilityCooldown.generated.h"
+
+class UFireflyAbilitySystemComponent;
+struct FFireflyAbilityCooldownContainer;
+
+/** 一组一起进入冷却的冷却标签的冷却记录，只同步冷却结束的服务端时间，客户端在本地计算剩余时间 */
+USTRUCT()
+struct FIREFLYABILITYSYSTEM_API FFireflyAbilityCooldownEntry : public FFastArraySerializerItem
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	void PostReplicatedAdd(const FFireflyAbilityCooldownContainer& InArraySerializer);
+
+	void PostReplicatedChange(const FFireflyAbilityCooldownContainer& InArraySerializer);
+
+	/** 一起进入冷却的所有冷却标签，创建后不再改变 */
+	UPROPERTY()
+	FGameplayTagContainer CooldownTags;
+
+	/** 冷却结束的服务端时间 */
+	UPROPERTY()
+	double ExpireServerTime = 0.0;
+
+	/** 冷却的总时长 */
+	UPROPERTY()
+	float TotalDuration = 0.f;
+};
+
+/** 技能管理器中所有冷却记录的容器，以FastArray的形式增量同步，冷却结束的记录会被保留并复用 */
+USTRUCT()
+struct FIREFLYABILITYSYSTEM_API FFireflyAbilityCooldownContainer : public FFastArraySerializer
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FFireflyAbilityCooldownEntry, FFireflyAbilityCooldownContainer>(Items, DeltaParms, *this);
+	}
+
+	/** 所有冷却记录 */
+	UPROPERTY()
+	TArray<FFireflyAbilityCooldownEntry> Items;
+
+	/** 容器所属的技能管理器 */
+	UPROPERTY(NotReplicated)
+	UFireflyAbilitySystemComponent* Owner = nullptr;
+};
+
+template<>
+struct TStructOpsTypeTraits<FFireflyAbilityCooldownContainer> : public TStructOpsTypeTraitsBase2<FFireflyAbilityCooldownContainer>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
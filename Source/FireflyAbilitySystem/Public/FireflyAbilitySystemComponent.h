@@ -4,10 +4,14 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Containers/StaticBitArray.h"
 #include "FireflyAbilitySystemTypes.h"
 #include "FireflyAbility.h"
+#include "FireflyAbilityCooldown.h"
 #include "FireflyEffect.h"
+#include "FireflyReplicatedTagCount.h"
 #include "FireflyAttribute.h"
+#include "FireflyStructAttribute.h"
 #include "FireflyAbilitySystemComponent.generated.h"
 
 class UInputAction;
@@ -57,6 +61,78 @@ public:
 	}
 };
 
+/** 某种效果类型的空闲效果实例 */
+USTRUCT()
+struct FFireflyEffectInstancePool
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	/** 已被重置、等待复用的效果实例 */
+	UPROPERTY()
+	TArray<UFireflyEffect*> Instances;
+};
+
+/** 属性修改事务中被标记为脏的属性 */
+struct FFireflyDirtyAttribute
+{
+	/** 被标记为脏的属性的类型 */
+	EFireflyAttributeType AttributeType = AttributeType_Default;
+
+	/** 属性被标记为脏时的基础值 */
+	float OldBaseValue = 0.f;
+
+	/** 属性被标记为脏时的当前值 */
+	float OldCurrentValue = 0.f;
+
+	FFireflyDirtyAttribute() {}
+
+	FFireflyDirtyAttribute(EFireflyAttributeType InAttributeType, float InOldBaseValue, float InOldCurrentValue)
+		: AttributeType(InAttributeType), OldBaseValue(InOldBaseValue), OldCurrentValue(InOldCurrentValue) {}
+};
+
+/** 批量检验修改器时某个属性被依次修改后的预测基础值 */
+struct FFireflyProjectedAttribute
+{
+	/** 被修改的属性的类型 */
+	EFireflyAttributeType AttributeType = AttributeType_Default;
+
+	/** 属性为结构体属性时指向该属性 */
+	FFireflyStructAttribute* StructAttribute = nullptr;
+
+	/** 属性为对象属性时指向该属性 */
+	UFireflyAttribute* Attribute = nullptr;
+
+	/** 已检验的修改器全部应用后的基础值 */
+	float ProjectedBaseValue = 0.f;
+};
+
+/** 属性历史记录中某一帧内某个属性变化前的值 */
+struct FFireflyAttributeHistorySample
+{
+	/** 发生变化的属性的类型 */
+	EFireflyAttributeType AttributeType = AttributeType_Default;
+
+	/** 属性在该帧第一次变化前的当前值 */
+	float OldValue = 0.f;
+};
+
+/** 属性历史记录中的一帧 */
+struct FFireflyAttributeHistoryFrame
+{
+	/** 该帧的服务端世界时间 */
+	double ServerTime = 0.0;
+
+	/** 该帧的引擎帧号 */
+	uint64 FrameNumber = 0;
+
+	/** 该帧记录的属性数 */
+	int32 NumSamples = 0;
+
+	/** 该帧变化的属性数超出了每帧最大记录数，跨越该帧的查询不可靠 */
+	bool bOverflowed = false;
+};
+
 /** 技能执行周期的代理声明 */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FFireflyAbilityExecutionDelegate, FName, AbilityID, TSubclassOf<UFireflyAbility>, AbilityType);
 /** 技能执行冷却的代理声明 */
@@ -66,6 +142,8 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FFireflyAbilityCooldownRemainingCh
 
 /** 属性数值变更的代理声明 */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FFireflyAttributeValueChangeDelegate, TEnumAsByte<EFireflyAttributeType>, AttributeType, float, NewValue, float, OldValue);
+/** 单个属性数值变更的原生代理声明 */
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FFireflyAttributeValueChangeNativeDelegate, EFireflyAttributeType /*AttributeType*/, float /*NewValue*/, float /*OldValue*/);
 
 /** 效果执行开始的代理声明 */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FFireflyEffectStartExecutingDelegate, FName, EffectID, TSubclassOf<UFireflyEffect>, EffectType, float, TotalDuration);
@@ -78,6 +156,12 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FFireflyEffectStackingChangedDeleg
 
 /** Tag存在周期的代理声明 */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFireflyGameplayTagExecutionDelegate, FGameplayTagContainer, TagsUpdated);
+/** 管理器中出现和消失的Tag的代理声明，一次批量操作只触发一次 */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FFireflyGameplayTagDeltaDelegate, const FGameplayTagContainer&, AddedTags, const FGameplayTagContainer&, RemovedTags);
+/** 管理器中出现和消失的Tag的原生代理声明，一次批量操作只触发一次 */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FFireflyGameplayTagDeltaNativeDelegate, TArrayView<const FGameplayTag> /*AddedTags*/, TArrayView<const FGameplayTag> /*RemovedTags*/);
+/** 单个Tag在管理器中出现或消失的原生代理声明 */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FFireflyGameplayTagChangeNativeDelegate, FGameplayTag /*Tag*/, bool /*bAdded*/);
 
 /** 处理消息事件的代理声明 */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FFireflyMessageEventDelegate, FGameplayTag, EventTag, FFireflyMessageEventData, EventData);
@@ -94,6 +178,12 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void OnRegister() override;
+
+	virtual void OnUnregister() override;
+
 public:
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
@@ -102,6 +192,8 @@ public:
 
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
 #pragma endregion
 
 
@@ -201,6 +293,9 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Ability")
 	void CancelAbilitiesWithTags(FGameplayTagContainer CancelTags);
 
+	/** 取消所有资产Tag与预计算的位集合有交集的技能的激活状态，必须在拥有权限端执行，否则无效 */
+	void CancelAbilitiesWithTagBits(const FFireflyGameplayTagBits& CancelTagBits);
+
 	/** 某个技能结束执行时执行的函数 */
 	UFUNCTION()
 	virtual void OnAbilityEndActivation(UFireflyAbility* AbilityJustEnded);
@@ -242,23 +337,73 @@ public:
 #pragma endregion
 
 
+#pragma region Ability_Cooldown 技能冷却
+
+public:
+	/** 是否存在同时携带所有冷却标签且处于冷却中的冷却记录，与原先要求同一个冷却效果携带所有冷却标签的判定一致，分别进入冷却的标签不会组合 */
+	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Ability")
+	bool IsOnCooldown(const FGameplayTagContainer& CooldownTags) const;
+
+	/** 获取同时携带所有冷却标签的冷却记录中最晚结束的剩余时间，不在冷却中时返回0 */
+	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Ability")
+	float GetCooldownTimeRemaining(const FGameplayTagContainer& CooldownTags) const;
+
+	/** 使一组冷却标签作为一条冷却记录进入冷却，同一组标签复用同一条记录，必须在拥有权限端执行，否则无效 */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Ability")
+	void ApplyCooldown(const FGameplayTagContainer& CooldownTags, float Duration);
+
+	/** 更改同时携带所有冷却标签且处于冷却中的冷却记录的剩余时间，必须在拥有权限端执行，否则无效 */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Ability")
+	void SetCooldownRemaining(const FGameplayTagContainer& CooldownTags, float NewTimeRemaining);
+
+	/** 冷却使用的服务端时间，客户端使用GameState同步的服务端时间 */
+	double GetCooldownServerTime() const;
+
+	/** 冷却记录同步到客户端时执行的函数 */
+	void OnAbilityCooldownReplicated(const FFireflyAbilityCooldownEntry& Entry);
+
+protected:
+	/** 获取某组冷却标签的冷却记录，不存在时创建，仅在拥有权限端使用 */
+	FFireflyAbilityCooldownEntry& FindOrAddCooldownEntry(const FGameplayTagContainer& CooldownTags);
+
+	/** 遍历同时携带所有冷却标签且处于冷却中的冷却记录，传入记录的下标和剩余时间 */
+	template<typename FuncType>
+	void ForEachActiveCooldownEntry(const FGameplayTagContainer& CooldownTags, FuncType&& Func) const;
+
+protected:
+	/** 所有冷却标签的冷却记录，仅同步给拥有者 */
+	UPROPERTY(Replicated)
+	FFireflyAbilityCooldownContainer AbilityCooldowns;
+
+	/** 冷却标签及携带该标签的冷却记录的下标，拥有权限端和客户端各自维护 */
+	TMap<FGameplayTag, TArray<int32, TInlineAllocator<2>>> CooldownEntriesByTag;
+
+#pragma endregion
+
+
 #pragma region Ability_Requirement 技能释放条件
 
 protected:
 	/** 获取管理器当前会阻挡激活的技能资产Tags */
 	UFUNCTION()
-	FGameplayTagContainer GetBlockAbilityTags() const;
+	FORCEINLINE const FGameplayTagContainer& GetBlockAbilityTags() const { return BlockAbilityTagContainer; }
 
 public:
-	/** 更新管理器的阻断技能Tags，或当CancelTags生效时取消某些技能，仅当某个技能激活时才会触发 */
-	UFUNCTION()
-	void UpdateBlockAndCancelAbilityTags(FGameplayTagContainer BlockTags, FGameplayTagContainer CancelTags, bool bIsActivated);
+	/** 更新管理器的阻断技能Tags，或当技能激活时取消资产Tag与CancelTagBits有交集的技能，CancelTagBits由技能预计算 */
+	void UpdateBlockAndCancelAbilityTags(const FGameplayTagContainer& BlockTags, const FFireflyGameplayTagBits& CancelTagBits, bool bIsActivated);
 
 protected:
 	/** 携带这些资产Tag的技能会被阻拦激活 */
 	UPROPERTY()
 	TMap<FGameplayTag, int32> BlockAbilityTags;
 
+	/** BlockAbilityTags中的所有Tag，只在Tag的计数从0变为1或从1变为0时增量更新 */
+	UPROPERTY()
+	FGameplayTagContainer BlockAbilityTagContainer;
+
+	/** BlockAbilityTags的位集合 */
+	FFireflyGameplayTagBits BlockAbilityTagBits;
+
 #pragma endregion
 
 
@@ -323,6 +468,31 @@ protected:
 	UFUNCTION()
 	UFireflyAttribute* GetAttributeByName(FName AttributeName) const;
 
+	/** 将构造完成的属性添加到属性容器中，并同步属性查找表 */
+	void AddAttributeToContainer(UFireflyAttribute* NewAttribute);
+
+	/** 根据属性容器重建属性查找表 */
+	void RebuildAttributeLookupTable();
+
+	/** 属性容器被同步到客户端时触发 */
+	UFUNCTION()
+	void OnRep_AttributeContainer();
+
+	/** 获取某个属性的修改器容器，不区分属性实例和结构体属性 */
+	FFireflyAttributeModifierContainer* GetAttributeModifiers(EFireflyAttributeType AttributeType);
+
+	/** 获取某个属性未经内部覆盖修改器处理的基础值，不区分属性实例和结构体属性 */
+	float GetAttributeRawBaseValue(EFireflyAttributeType AttributeType) const;
+
+	/** 获取某个属性实际的当前值，不受属性回滚影响，不区分属性实例和结构体属性 */
+	float GetAttributeRawCurrentValue(EFireflyAttributeType AttributeType) const;
+
+	/** 重新计算某个属性的当前值，不区分属性实例和结构体属性 */
+	void UpdateAttributeCurrentValueByType(EFireflyAttributeType AttributeType);
+
+	/** 按照运算符永久修改某个属性的基础值，不区分属性实例和结构体属性 */
+	void UpdateAttributeBaseValueByType(EFireflyAttributeType AttributeType, EFireflyAttributeModOperator ModOperator, float ModValue);
+
 public:
 	/** 通过属性标签获取一个属性的当前值 */
 	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Attribute")
@@ -332,6 +502,9 @@ public:
 	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Attribute")
 	float GetAttributeBaseValue(EFireflyAttributeType AttributeType) const;
 
+	/** 某个属性的值是否会被夹在值域中，不区分属性实例和结构体属性 */
+	bool IsAttributeValueClamped(EFireflyAttributeType AttributeType) const;
+
 	/** 通过构造器设置构造属性并添加到属性修改器中 */
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
 	void ConstructAttributeByConstructor(FFireflyAttributeConstructor AttributeConstructor);
@@ -354,9 +527,16 @@ public:
 
 protected:
 	/** 属性容器 */
-	UPROPERTY(Replicated)
+	UPROPERTY(ReplicatedUsing = OnRep_AttributeContainer)
 	TArray<UFireflyAttribute*> AttributeContainer;
 
+	/** 属性类型到属性容器下标的查找表，属性不存在时为INDEX_NONE，同类型属性重复构造时只记录第一个 */
+	int16 AttributeLookupTable[AttributeType_Max];
+
+	/** 为true时，没有原生或蓝图重写逻辑的属性以结构体的形式存储在组件中，不再为每个属性创建UObject，适用于大量简单NPC */
+	UPROPERTY(EditDefaultsOnly, Category = "FireflyAbilitySystem|Attribute")
+	bool bUseStructAttributes = false;
+
 public:
 	/** 属性的当前值更新时触发的代理 */
 	UPROPERTY(BlueprintAssignable, Category = "FireflyAbilitySystem|Attribute")
@@ -366,33 +546,220 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "FireflyAbilitySystem|Attribute")
 	FFireflyAttributeValueChangeDelegate OnAttributeBaseValueChanged;
 
+	/** 获取某个属性的当前值更新时触发的原生代理，只有监听该属性的对象会被通知 */
+	FFireflyAttributeValueChangeNativeDelegate& GetAttributeValueChangeDelegate(EFireflyAttributeType AttributeType);
+
+	/** 获取某个属性的基础值更新时触发的原生代理，只有监听该属性的对象会被通知 */
+	FFireflyAttributeValueChangeNativeDelegate& GetAttributeBaseValueChangeDelegate(EFireflyAttributeType AttributeType);
+
+	/** 广播属性当前值的变化，先通知该属性的原生监听者，再通知蓝图代理 */
+	void BroadcastAttributeValueChanged(EFireflyAttributeType AttributeType, float NewValue, float OldValue);
+
+	/** 广播属性基础值的变化，先通知该属性的原生监听者，再通知蓝图代理 */
+	void BroadcastAttributeBaseValueChanged(EFireflyAttributeType AttributeType, float NewValue, float OldValue);
+
+protected:
+	/** 按属性类型存储的当前值变化的原生代理，只为被监听的属性分配，广播期间新增监听不会使代理失效 */
+	TMap<EFireflyAttributeType, TUniquePtr<FFireflyAttributeValueChangeNativeDelegate>> AttributeValueChangeDelegates;
+
+	/** 按属性类型存储的基础值变化的原生代理，只为被监听的属性分配，广播期间新增监听不会使代理失效 */
+	TMap<EFireflyAttributeType, TUniquePtr<FFireflyAttributeValueChangeNativeDelegate>> AttributeBaseValueChangeDelegates;
+
+#pragma endregion
+
+
+#pragma region Attribute_Struct 结构体属性
+
+protected:
+	/** 某个属性类是否可以以结构体的形式存储，要求开启结构体属性模式，且属性类没有原生或蓝图重写的逻辑 */
+	bool CanConstructStructAttribute(TSubclassOf<UFireflyAttribute> AttributeClass) const;
+
+	/** 将构造完成的结构体属性添加到结构体属性容器中，并同步查找表和依赖关系 */
+	void AddStructAttribute(const FFireflyStructAttribute& NewAttribute);
+
+	/** 根据类型获取结构体属性 */
+	FFireflyStructAttribute* GetStructAttributeByType(EFireflyAttributeType AttributeType);
+
+	/** 根据类型获取结构体属性 */
+	const FFireflyStructAttribute* GetStructAttributeByType(EFireflyAttributeType AttributeType) const;
+
+	/** 根据结构体属性容器重建结构体属性查找表 */
+	void RebuildStructAttributeLookupTable();
+
+	/** 初始化结构体属性的基础值 */
+	void InitializeStructAttributeValue(FFireflyStructAttribute& Attribute, float InitValue);
+
+	/** 重新计算结构体属性的当前值 */
+	void UpdateStructAttributeCurrentValue(FFireflyStructAttribute& Attribute);
+
+	/** 按照运算符永久修改结构体属性的基础值 */
+	void UpdateStructAttributeBaseValue(FFireflyStructAttribute& Attribute, EFireflyAttributeModOperator ModOperator, float ModValue);
+
+public:
+	/** 结构体属性被同步到客户端时触发，广播属性值的变化 */
+	void OnStructAttributeReplicated(FFireflyStructAttribute& Attribute, bool bAdded);
+
+protected:
+	/** 结构体属性容器 */
+	UPROPERTY(Replicated)
+	FFireflyStructAttributeContainer StructAttributes;
+
+	/** 属性类型到结构体属性容器下标的查找表，属性不存在时为INDEX_NONE */
+	int16 StructAttributeLookupTable[AttributeType_Max];
+
+#pragma endregion
+
+
+#pragma region Attribute_Store 世界属性存储
+
+protected:
+	/** 若启用了世界属性存储，将属性托管到世界属性存储中 */
+	void RegisterAttributeToStore(UFireflyAttribute* Attribute);
+
+	/** 释放所有属性在世界属性存储中占用的槽位 */
+	void UnregisterAttributesFromStore();
+
+public:
+	/** 世界属性存储将计算后的当前值同步回属性时触发，广播属性值的变化并更新依赖该属性的属性 */
+	void OnAttributeStoreValuePublished(UFireflyAttribute* Attribute, float OldValue);
+
+#pragma endregion
+
+
+#pragma region Attribute_History 属性历史
+
+public:
+	/** 查询某个属性在过去某个服务端时间的当前值，时间超出历史记录范围或记录不完整时返回false，不分配内存 */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	bool GetAttributeValueAtTime(EFireflyAttributeType AttributeType, double ServerTime, float& OutValue) const;
+
+	/** 将所有属性回滚到过去某个服务端时间的当前值，回滚期间GetAttributeValue返回历史值，属性的真实变化仍作用于当前值并被记录，用完后必须调用RestoreRewoundAttributes */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	bool RewindAttributesToTime(double ServerTime);
+
+	/** 结束属性回滚，GetAttributeValue重新返回属性的当前值 */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	void RestoreRewoundAttributes();
+
+	/** 属性当前是否处于回滚状态 */
+	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Attribute")
+	FORCEINLINE bool IsAttributeRewound() const { return bIsAttributeRewound; }
+
+	/** 不受属性回滚影响的属性当前值，夹值、范围检验和修改器取值等内部逻辑总是使用该值 */
+	float GetLiveAttributeValue(EFireflyAttributeType AttributeType) const;
+
+protected:
+	/** 若在项目设置中启用了属性历史记录，在服务端一次性分配环形缓冲 */
+	void InitializeAttributeHistory();
+
+	/** 在属性历史记录的当前帧中记录属性变化前的值，同一帧内同一属性只记录第一次变化 */
+	void RecordAttributeHistory(EFireflyAttributeType AttributeType, float OldValue);
+
+	/** 从最新的帧开始，向前遍历所有晚于某个时间的历史帧，历史记录能够覆盖该时间时返回true */
+	template<typename FuncType>
+	bool ForEachAttributeHistoryFrameAfter(double ServerTime, FuncType&& Func) const;
+
+protected:
+	/** 属性历史记录的帧环形缓冲 */
+	TArray<FFireflyAttributeHistoryFrame> AttributeHistoryFrames;
+
+	/** 属性历史记录的数据，每帧占用固定数量的连续槽位 */
+	TArray<FFireflyAttributeHistorySample> AttributeHistorySamples;
+
+	/** 最新的历史帧在环形缓冲中的下标 */
+	int32 AttributeHistoryHead = INDEX_NONE;
+
+	/** 环形缓冲中有效的历史帧数 */
+	int32 AttributeHistoryFrameNum = 0;
+
+	/** 每帧最多记录的属性数 */
+	int32 AttributeHistoryMaxChangesPerFrame = 0;
+
+	/** 属性当前是否处于回滚状态 */
+	bool bIsAttributeRewound = false;
+
+	/** 回滚期间被回滚的属性 */
+	TStaticBitArray<AttributeType_Max> RewoundAttributeMask;
+
+	/** 回滚期间被回滚的属性的历史值 */
+	float RewoundAttributeValues[AttributeType_Max];
+
+#pragma endregion
+
+
+#pragma region Attribute_Dependency 属性依赖
+
+protected:
+	/** 注册属性对其源属性的依赖，会形成循环依赖的依赖关系将被拒绝 */
+	void RegisterAttributeDependencies(EFireflyAttributeType DependentType, TArrayView<const EFireflyAttributeType> SourceTypes);
+
+	/** 检测某个属性是否直接或间接依赖于另一个属性 */
+	bool IsAttributeDependentOn(EFireflyAttributeType DependentType, EFireflyAttributeType SourceType) const;
+
+	/** 根据依赖关系重新计算所有属性的拓扑层级，源属性的层级总是低于依赖它的属性 */
+	void RebuildAttributeTopologicalRanks();
+
+	/** 按拓扑顺序重新计算一组属性及其所有直接或间接依赖的属性，每个属性只计算一次 */
+	void UpdateAttributesInDependencyOrder(TArrayView<const EFireflyAttributeType> RootTypes, bool bIncludeRoots = true);
+
+protected:
+	/** 源属性类型到直接依赖它的属性类型的映射 */
+	TMap<EFireflyAttributeType, TArray<EFireflyAttributeType>> AttributeDependents;
+
+	/** 属性类型在依赖图中的拓扑层级 */
+	uint8 AttributeTopologicalRanks[AttributeType_Max] = {};
+
 #pragma endregion
 
 
 #pragma region Attribute_Modifier 属性修改器
 
 protected:
-	/** 修改器被应用前处理的逻辑 */
+	/** 修改器被应用前处理的逻辑，不创建效果实例执行的效果以效果类型的默认对象作为修改器来源，其ID和发起者通过GetExecutingEffectSpec获取 */
 	UFUNCTION()
 	virtual void PreModiferApplied(EFireflyAttributeType AttributeType, EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply);
 
-	/** 修改器被应用后处理的逻辑 */
+	/** 修改器被应用后处理的逻辑，不创建效果实例执行的效果以效果类型的默认对象作为修改器来源，其ID和发起者通过GetExecutingEffectSpec获取 */
 	UFUNCTION()
 	virtual void PostModiferApplied(EFireflyAttributeType AttributeType, EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply);
 
 public:
-	/** 应用一个修改器到某个属性的当前值中，必须在拥有权限端执行，否则无效 */
-	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	/** 应用一个修改器到某个属性的当前值中，来源和值都相同的修改器已存在时仅重设其堆叠数，必须在拥有权限端执行，否则无效，已弃用，请使用ApplyModifierToAttributeWithHandle */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute", Meta = (DeprecatedFunction, DeprecationMessage = "Use ApplyModifierToAttributeWithHandle and keep the returned handle."))
 	virtual void ApplyModifierToAttribute(EFireflyAttributeType AttributeType, EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply);
 
-	/** 移除某个作用于某个属性的当前值的修改器，必须在拥有权限端执行，否则无效 */
+	/** 应用一个修改器到某个属性的当前值中，每次调用都添加一个新的修改器并返回其句柄，来源和值相同的修改器也互不影响，必须在拥有权限端执行，否则无效 */
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	virtual FFireflyModifierHandle ApplyModifierToAttributeWithHandle(EFireflyAttributeType AttributeType, EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply);
+
+	/** 移除第一个来源和值都相同的作用于某个属性的当前值的修改器，必须在拥有权限端执行，否则无效，已弃用，请使用RemoveModifierByHandle */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute", Meta = (DeprecatedFunction, DeprecationMessage = "Use RemoveModifierByHandle with the handle returned by ApplyModifierToAttributeWithHandle."))
 	virtual void RemoveModifierFromAttribute(EFireflyAttributeType AttributeType, EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue);
 
-	/** 更改某个修改器的活跃状态 */
-	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	/** 更改第一个来源和值都相同的修改器的活跃状态，已弃用，请使用ShiftModifierActiveStateByHandle */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute", Meta = (DeprecatedFunction, DeprecationMessage = "Use ShiftModifierActiveStateByHandle with the handle returned by ApplyModifierToAttributeWithHandle."))
 	virtual void ShiftModifierActiveState(EFireflyAttributeType AttributeType, EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, bool bNewActiveState);
 
+	/** 通过句柄移除某个修改器，必须在拥有权限端执行，否则无效 */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	virtual void RemoveModifierByHandle(const FFireflyModifierHandle& ModifierHandle);
+
+	/** 通过句柄重设某个修改器的堆叠数，必须在拥有权限端执行，否则无效 */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	virtual void SetModifierStackByHandle(const FFireflyModifierHandle& ModifierHandle, int32 NewStackCount);
+
+	/** 通过句柄重设某个修改器的值和堆叠数，必须在拥有权限端执行，否则无效 */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	virtual void ResetModifierByHandle(const FFireflyModifierHandle& ModifierHandle, float NewModValue, int32 NewStackCount);
+
+	/** 通过句柄更改某个修改器的活跃状态，必须在拥有权限端执行，否则无效 */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	virtual void ShiftModifierActiveStateByHandle(const FFireflyModifierHandle& ModifierHandle, bool bNewActiveState);
+
+	/** 句柄指向的修改器是否仍然存在 */
+	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Attribute")
+	bool IsModifierHandleValid(const FFireflyModifierHandle& ModifierHandle) const;
+
 	/** 检验某个属性修改器是否可以被应用，该函数仅考虑属性的值被修改器修改后是否仍处于属性的价值范围内，所以要被检验的属性必须是被夹值的 */
 	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Attribute")
 	virtual bool CanApplyModifierInstant(EFireflyAttributeType AttributeType, EFireflyAttributeModOperator ModOperator, float ModValue) const;
@@ -405,6 +772,83 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
 	virtual void ApplyOrResetModifierToAttribute(EFireflyAttributeType AttributeType, EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackToApply);
 
+	/** 检验一组修改器是否可以被依次应用，同一属性的多个修改器按累计后的基础值检验 */
+	bool CanApplyModifiersInstant(TArrayView<const FFireflyEffectModifierData> ModifiersToApply) const;
+
+	/** 检验并在一次属性修改事务中应用一组永久修改基础值的修改器，任意一个检验失败时都不应用，必须在拥有权限端执行，否则无效 */
+	bool TryApplyModifiersInstant(TArrayView<const FFireflyEffectModifierData> ModifiersToApply, UObject* ModSource);
+
+protected:
+	/** 解析修改器实际使用的修改值，UsingAttribute方式取所用属性的当前值，CustomCalculator方式由共享的计算器实例以效果类型的默认对象为上下文计算，否则取修改器配置的修改值 */
+	float ResolveModifierValueInstant(const FFireflyEffectModifierData& Modifier) const;
+
+	/** 解析一组修改器要修改的属性及每个修改器的修改值，并检验累计修改后的基础值是否仍处于属性的范围内，每个属性只解析一次 */
+	bool ProjectModifiersInstant(TArrayView<const FFireflyEffectModifierData> ModifiersToApply,
+		TArray<FFireflyProjectedAttribute, TInlineAllocator<8>>& OutProjections,
+		TArray<float, TInlineAllocator<8>>& OutModValues) const;
+
+#pragma endregion
+
+
+#pragma region Attribute_Transaction 属性修改事务
+
+public:
+	/** 开启一次属性修改事务，可嵌套，事务期间被修改的属性只标记为脏，提交时按拓扑顺序每个属性只重新计算一次并广播一次，事务中读取过期的属性值时先行重新计算；开启和提交必须在同一帧内成对调用，见CloseUnbalancedModifierTransactions */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	void BeginModifierTransaction();
+
+	/** 提交属性修改事务，最外层事务提交时每个被修改的属性只广播一次从事务开始前的值到最终值的变化 */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Attribute")
+	void CommitModifierTransaction();
+
+	/** 当前是否处于属性修改事务中 */
+	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Attribute")
+	FORCEINLINE bool IsInModifierTransaction() const { return ModifierTransactionDepth > 0; }
+
+	/** 属性的当前值是否在事务中过期，等待提交或被读取时重新计算 */
+	FORCEINLINE bool IsAttributeValueStale(EFireflyAttributeType AttributeType) const
+	{
+		return AttributeType < AttributeType_Max && StaleAttributeMask[AttributeType];
+	}
+
+protected:
+	/** 将属性标记为脏，记录属性在事务中第一次被修改前的值，必须在属性的基础值被修改前调用 */
+	void MarkAttributeDirty(EFireflyAttributeType AttributeType);
+
+	/** 将属性标记为脏，属性的值已被修改时由调用者传入修改前的值 */
+	void MarkAttributeDirty(EFireflyAttributeType AttributeType, float OldBaseValue, float OldCurrentValue);
+
+	/** 更新属性及依赖于它的属性的当前值，处于事务中时推迟到提交时或被读取时重新计算 */
+	void RefreshAttributeCurrentValue(EFireflyAttributeType AttributeType);
+
+	/** 将属性及直接或间接依赖于它的属性标记为过期 */
+	void MarkAttributeStale(EFireflyAttributeType AttributeType);
+
+	/** 按拓扑顺序重新计算事务中所有待重新计算的属性，每个属性只计算一次，必须在事务中调用，计算引起的变化由事务提交时广播 */
+	void RecomputePendingAttributes();
+
+	/** 重新计算待重新计算的属性，结束所有事务，并广播事务中的变化 */
+	void CloseModifierTransaction();
+
+	/** 不配对的事务调用的唯一处理策略：报告错误，然后结束所有事务并广播推迟的变化，避免之后的广播一直被推迟 */
+	void CloseUnbalancedModifierTransactions();
+
+	/** 广播所有被标记为脏的属性从事务开始前的值到最终值的变化 */
+	void FlushDirtyAttributes();
+
+protected:
+	/** 属性修改事务的嵌套层数 */
+	int32 ModifierTransactionDepth = 0;
+
+	/** 当前事务中被标记为脏的属性 */
+	TArray<FFireflyDirtyAttribute> DirtyAttributes;
+
+	/** 当前事务中待重新计算的属性 */
+	TArray<EFireflyAttributeType, TInlineAllocator<8>> PendingRecomputeAttributes;
+
+	/** 待重新计算的属性及依赖于它们的属性，这些属性的当前值已过期 */
+	TStaticBitArray<AttributeType_Max> StaleAttributeMask;
+
 #pragma endregion
 
 
@@ -423,9 +867,32 @@ public:
 	UFUNCTION()
 	TArray<UFireflyEffect*> GetActiveEffectsByTag(FGameplayTagContainer EffectAssetTags) const;
 
+	/** 获取特定ID的激活中的所有效果的视图，不分配内存，有效果被应用或移除后视图失效 */
+	TArrayView<UFireflyEffect* const> GetActiveEffectsViewByID(FName EffectID) const;
+
+	/** 获取特定类型的激活中的所有效果的视图，不分配内存，有效果被应用或移除后视图失效 */
+	TArrayView<UFireflyEffect* const> GetActiveEffectsViewByClass(TSubclassOf<UFireflyEffect> EffectType) const;
+
+	/** 对带有所有特定资产Tags的激活中的效果逐个执行回调，不分配内存，回调中不能应用或移除效果 */
+	template<typename FuncType>
+	void ForEachActiveEffectWithTags(const FGameplayTagContainer& EffectAssetTags, FuncType&& Func) const;
+
+	/** 是否存在带有所有特定资产Tags的激活中的效果 */
+	bool HasActiveEffectWithTags(const FGameplayTagContainer& EffectAssetTags) const;
+
 	/** 获取管理器当前会阻挡激活的技能资产Tags */
 	UFUNCTION()
-	FGameplayTagContainer GetBlockEffectTags() const;
+	FORCEINLINE const FGameplayTagContainer& GetBlockEffectTags() const { return BlockEffectTagContainer; }
+
+	/** 携带这些Tags的效果应用到该管理器时是否会被阻挡 */
+	bool IsEffectApplicationBlocked(const FGameplayTagContainer& EffectAssetTags, const FGameplayTagContainer& RequireTags,
+		const FGameplayTagContainer& BlockTags) const;
+
+	/** 使用预计算的Tag位集合判定效果应用到该管理器时是否会被阻挡 */
+	bool IsEffectApplicationBlocked(const FFireflyEffectApplicationTagBits& TagBits) const;
+
+	/** 效果规格应用到该管理器时是否会被阻挡，规格带有预计算的Tag位集合时直接使用 */
+	bool IsEffectSpecApplicationBlocked(const FFireflyEffectSpec& EffectSpec) const;
 
 	/** 为自身应用一个效果实例或应用效果的固定堆叠数，必须在拥有权限端执行，否则无效 */
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Effect")
@@ -435,6 +902,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Effect")
 	void ApplyEffectToTarget(AActor* Target, UFireflyEffect* EffectInstance, int32 StackToApply = 1);
 
+	/** 为多个目标应用同一种效果，效果的定义和修改器只解析一次，返回每个目标的应用结果，必须在拥有权限端执行，否则无效 */
+	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Effect")
+	TArray<EFireflyEffectApplicationResult> ApplyEffectToTargetsByClass(const TArray<AActor*>& Targets, TSubclassOf<UFireflyEffect> EffectType,
+		FName EffectID = NAME_None, int32 StackToApply = 1);
+
+	/** 为多个目标应用同一种效果，OutResults与Targets一一对应，必须在拥有权限端执行，否则无效 */
+	void ApplyEffectToTargets(TArrayView<AActor* const> Targets, TSubclassOf<UFireflyEffect> EffectType, FName EffectID,
+		int32 StackToApply, TArray<EFireflyEffectApplicationResult>& OutResults);
+
 	/** 为自身应用效果或应用效果的固定堆叠数，必须在拥有权限端执行，否则无效 */
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Effect")
 	void ApplyEffectToOwnerByID(AActor* Instigator, FName EffectID, int32 StackToApply = 1);
@@ -485,17 +961,47 @@ public:
 
 	/** 更新管理器的阻断技能Tags，或当CancelTags生效时取消某些效果，仅当某个不为Instant的效果被应用时才会触发，必须在拥有权限端执行，否则无效 */
 	UFUNCTION()
-	void UpdateBlockAndRemoveEffectTags(FGameplayTagContainer BlockTags, FGameplayTagContainer RemoveTags, bool bIsApplied);
+	void UpdateBlockAndRemoveEffectTags(const FGameplayTagContainer& BlockTags, const FGameplayTagContainer& RemoveTags, bool bIsApplied);
+
+protected:
+	/** 将效果加入类型、ID和资产标签的索引 */
+	void AddActiveEffectToIndices(UFireflyEffect* InEffect);
+
+	/** 将效果从类型、ID和资产标签的索引中移除 */
+	void RemoveActiveEffectFromIndices(UFireflyEffect* InEffect);
+
+	/** 根据激活中的效果重建所有索引 */
+	void RebuildActiveEffectIndices();
+
+	/** 激活中的效果被同步到客户端时触发 */
+	UFUNCTION()
+	void OnRep_ActiveEffects();
 
 protected:
 	/** 所有激活中的执行策略不是Instant的效果 */
-	UPROPERTY(Replicated)
+	UPROPERTY(ReplicatedUsing = OnRep_ActiveEffects)
 	TArray<UFireflyEffect*> ActiveEffects;
 
+	/** 按类型索引的激活中的效果，保持效果被应用的顺序 */
+	TMap<TSubclassOf<UFireflyEffect>, TArray<UFireflyEffect*>> ActiveEffectsByClass;
+
+	/** 按ID索引的激活中的效果，保持效果被应用的顺序 */
+	TMap<FName, TArray<UFireflyEffect*>> ActiveEffectsByID;
+
+	/** 按资产标签中的每个标签索引的激活中的效果，保持效果被应用的顺序 */
+	TMap<FGameplayTag, TArray<UFireflyEffect*>> ActiveEffectsByAssetTag;
+
 	/** 携带这些资产Tag的技能会被阻拦激活 */
 	UPROPERTY()
 	TMap<FGameplayTag, int32> BlockEffectTags;
 
+	/** BlockEffectTags中的所有Tag，只在Tag的计数从0变为1或从1变为0时增量更新 */
+	UPROPERTY()
+	FGameplayTagContainer BlockEffectTagContainer;
+
+	/** BlockEffectTags的位集合 */
+	FFireflyGameplayTagBits BlockEffectTagBits;
+
 public:
 	/** 当不为Instant的效果被应用时触发的代理 */
 	UPROPERTY(BlueprintAssignable, Category = "FireflyAbilitySystem|Effect")
@@ -508,6 +1014,39 @@ public:
 #pragma endregion
 
 
+#pragma region Effect_Pool 效果实例池
+
+public:
+	/** 从实例池中取出一个指定类型的效果实例，池中没有空闲实例时创建新的实例 */
+	UFireflyEffect* AcquireEffectInstance(TSubclassOf<UFireflyEffect> EffectType);
+
+	/** 效果实例结束使用时调用，允许池化的实例被重置后放回实例池，否则标记为垃圾 */
+	void ReleaseEffectInstance(UFireflyEffect* EffectInstance);
+
+	/** 不创建效果实例，直接为自身执行一个Instant效果的固定堆叠数，必须在拥有权限端执行，否则无效 */
+	void ApplyEffectSpecToOwner(const FFireflyEffectSpec& EffectSpec, int32 StackToApply = 1);
+
+	/** 获取正在为自身执行的效果规格，不在效果规格的执行期间时为空 */
+	FORCEINLINE const FFireflyEffectSpec* GetExecutingEffectSpec() const { return ExecutingEffectSpec; }
+
+protected:
+	/** 不检验阻挡Tags，直接为自身执行效果规格的修改器 */
+	void ExecuteEffectSpecOnOwner(const FFireflyEffectSpec& EffectSpec, int32 StackToApply);
+
+	/** 不检验阻挡Tags，按效果的发起者应用策略为自身应用一个效果实例，返回效果是否被应用 */
+	EFireflyEffectApplicationResult ApplyEffectInstanceToOwner(AActor* Instigator, UFireflyEffect* EffectInstance, int32 StackToApply);
+
+protected:
+	/** 按效果类型存储的空闲效果实例 */
+	UPROPERTY()
+	TMap<TSubclassOf<UFireflyEffect>, FFireflyEffectInstancePool> EffectInstancePools;
+
+	/** 正在为自身执行的效果规格，只在ExecuteEffectSpecOnOwner期间有效 */
+	const FFireflyEffectSpec* ExecutingEffectSpec = nullptr;
+
+#pragma endregion
+
+
 #pragma region Effect_Duration 效果持续时间
 
 public:
@@ -607,20 +1146,27 @@ public:
 	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Effect")
 	FORCEINLINE TArray<FFireflySpecificProperty> GetSpecificProperties() const { return SpecificProperties; }
 
+	/** 获取某个类型的计算器在该管理器中共享的实例，同一类型的计算器只会创建一次 */
+	UFireflyEffectModifierCalculator* GetModifierCalculator(TSubclassOf<UFireflyEffectModifierCalculator> CalculatorClass);
+
 protected:
 	/** 被效果赋予的特殊属性集合 */
 	UPROPERTY()
 	TArray<FFireflySpecificProperty> SpecificProperties;
 
+	/** 按类型缓存的共享计算器实例 */
+	UPROPERTY()
+	TMap<TSubclassOf<UFireflyEffectModifierCalculator>, UFireflyEffectModifierCalculator*> ModifierCalculators;
+
 #pragma endregion
 
 
 #pragma region TagManagement 标签管理
 
 public:
-	/** 获取拥有的所有Tag */
+	/** 获取拥有的所有Tag，包含父级Tag */
 	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Tag")
-	FGameplayTagContainer GetContainedTags() const;
+	FORCEINLINE const FGameplayTagContainer& GetContainedTags() const { return OwnedTags; }
 
 	/** 添加Tag到管理器中 */
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Tag")
@@ -632,22 +1178,105 @@ public:
 
 	/** 将一些Tag添加到管理器中 */
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Tag")
-	void AddTagsToManager(FGameplayTagContainer TagsToAdd, int32 CountToAdd = 1);
+	void AddTagsToManager(const FGameplayTagContainer& TagsToAdd, int32 CountToAdd = 1);
 
 	/** 将一些Tag从管理器中移除 */
 	UFUNCTION(BlueprintCallable, Category = "FireflyAbilitySystem|Tag")
-	void RemoveTagsFromManager(FGameplayTagContainer TagsToRemove, int32 CountToRemove = 1);
+	void RemoveTagsFromManager(const FGameplayTagContainer& TagsToRemove, int32 CountToRemove = 1);
+
+	/** 管理器是否拥有某个Tag，不构造Tag容器 */
+	FORCEINLINE bool HasTagExact(const FGameplayTag& Tag) const { return TagCountContainer.Contains(Tag) || ReplicatedTagCountContainer.Contains(Tag); }
+
+	/** 管理器是否拥有Tags中的任意一个，不构造Tag容器 */
+	bool HasAnyTagsExact(const FGameplayTagContainer& Tags) const;
+
+	/** 管理器是否拥有Tags中的所有Tag，不构造Tag容器 */
+	bool HasAllTagsExact(const FGameplayTagContainer& Tags) const;
+
+	/** 拥有的所有Tag的位集合，不含父级Tag，用于精确判定 */
+	FORCEINLINE const FFireflyGameplayTagBits& GetOwnedTagBits() const { return OwnedTagBits; }
+
+	/** 拥有的所有Tag及其父级Tag的位集合，用于非精确判定 */
+	FORCEINLINE const FFireflyGameplayTagBits& GetOwnedTagBitsWithParents() const { return OwnedTagBitsWithParents; }
 
 protected:
 	/** 所有拥有的Tag及其对应的堆叠数 */
 	UPROPERTY()
 	TMap<FGameplayTag, int32> TagCountContainer;
 
+	/** 所有拥有的Tag，只在Tag的堆叠数从0变为1或从1变为0时增量更新 */
+	UPROPERTY()
+	FGameplayTagContainer OwnedTags;
+
+	/** OwnedTags中显式拥有的Tag的位集合 */
+	FFireflyGameplayTagBits OwnedTagBits;
+
+	/** OwnedTags中的Tag及其父级Tag的位集合 */
+	FFireflyGameplayTagBits OwnedTagBitsWithParents;
+
+	/** 按位索引记录每个位被多少个拥有的Tag作为自身或父级Tag引用，计数归零时从OwnedTagBitsWithParents中清除 */
+	TArray<int32> OwnedTagParentBitCounts;
+
+	/** Tag开始被拥有时更新OwnedTags及其位集合 */
+	void AddOwnedTag(const FGameplayTag& Tag);
+
+	/** Tag不再被拥有时更新OwnedTags及其位集合 */
+	void RemoveOwnedTags(TArrayView<const FGameplayTag> Tags);
+
+public:
+	/** 记录服务端同步到客户端的Tag堆叠数，仅在客户端执行 */
+	void SetReplicatedTagCount(const FGameplayTag& Tag, int32 NewCount);
+
+protected:
+	/** 将Tag当前的堆叠数写入同步记录，仅在拥有权限端执行 */
+	void UpdateReplicatedTagCount(const FGameplayTag& Tag);
+
+	/** 客户端收到的服务端Tag堆叠数，与本地添加的堆叠数分开记录 */
+	TMap<FGameplayTag, int32> ReplicatedTagCountContainer;
+
+	/** 同步到客户端的Tag堆叠数，记录不会被删除，堆叠数清零后再次添加时复用原记录 */
+	UPROPERTY(Replicated)
+	FFireflyReplicatedTagCountContainer ReplicatedTagCounts;
+
+	/** Tag在同步记录中的下标，仅在拥有权限端使用 */
+	TMap<FGameplayTag, int32> ReplicatedTagCountIndices;
+
+public:
+	/** 将效果登记到其持续生效条件引用的Tag的索引中 */
+	void RegisterEffectOngoingRequirement(UFireflyEffect* Effect);
+
+	/** 将效果从持续生效条件的索引中移除 */
+	void UnregisterEffectOngoingRequirement(UFireflyEffect* Effect);
+
+protected:
+	/** 一些Tag在管理器中出现或消失时，只重新检验持续生效条件引用了这些Tag的效果 */
+	void ReevaluateEffectOngoingRequirements(TArrayView<const FGameplayTag> ChangedTags);
+
+	/** Tag到持续生效条件引用了该Tag的效果的倒排索引，效果由ActiveEffects持有 */
+	TMap<FGameplayTag, TArray<UFireflyEffect*>> OngoingRequirementEffectsByTag;
+
 public:
 	/** 管理器的TagCountContainer更新时触发的代理 */
 	UPROPERTY(BlueprintAssignable, Category = "FireflyAbilitySystem|Tag")
 	FFireflyGameplayTagExecutionDelegate OnTagContainerUpdated;
 
+	/** 管理器中有Tag出现或消失时触发的代理，只携带变化的Tag */
+	UPROPERTY(BlueprintAssignable, Category = "FireflyAbilitySystem|Tag")
+	FFireflyGameplayTagDeltaDelegate OnTagsChanged;
+
+	/** 管理器中有Tag出现或消失时触发的原生代理，只携带变化的Tag */
+	FFireflyGameplayTagDeltaNativeDelegate OnTagsChangedNative;
+
+	/** 获取某个Tag在管理器中出现或消失时触发的原生代理，只有监听该Tag的对象会被通知 */
+	FFireflyGameplayTagChangeNativeDelegate& GetTagChangeDelegate(FGameplayTag Tag);
+
+protected:
+	/** 通知Tag的出现和消失，先重新检验受影响的效果，再通知该Tag的原生监听者，最后广播整体的变化 */
+	void BroadcastTagsChanged(TArrayView<const FGameplayTag> AddedTags, TArrayView<const FGameplayTag> RemovedTags);
+
+	/** 按Tag存储的原生代理，只为被监听的Tag分配，广播期间新增监听不会使代理失效 */
+	TMap<FGameplayTag, TUniquePtr<FFireflyGameplayTagChangeNativeDelegate>> TagChangeDelegates;
+
 #pragma endregion
 
 
@@ -681,3 +1310,65 @@ public:
 
 #pragma endregion
 };
+
+template<typename FuncType>
+void UFireflyAbilitySystemComponent::ForEachActiveEffectWithTags(const FGameplayTagContainer& EffectAssetTags,
+	FuncType&& Func) const
+{
+	if (!EffectAssetTags.IsValid())
+	{
+		return;
+	}
+
+	/** 只需遍历查询标签中效果最少的那个标签的索引 */
+	const TArray<UFireflyEffect*>* SmallestBucket = nullptr;
+	for (const FGameplayTag& Tag : EffectAssetTags)
+	{
+		const TArray<UFireflyEffect*>* Bucket = ActiveEffectsByAssetTag.Find(Tag);
+		if (!Bucket)
+		{
+			return;
+		}
+
+		if (!SmallestBucket || Bucket->Num() < SmallestBucket->Num())
+		{
+			SmallestBucket = Bucket;
+		}
+	}
+
+	for (UFireflyEffect* Effect : *SmallestBucket)
+	{
+		if (Effect->GetDefinition().TagsForEffectAsset.HasAllExact(EffectAssetTags))
+		{
+			Func(Effect);
+		}
+	}
+}
+
+/** 属性修改事务的作用域，构造时开启事务，析构时提交事务 */
+struct FIREFLYABILITYSYSTEM_API FFireflyScopedModifierTransaction
+{
+	explicit FFireflyScopedModifierTransaction(UFireflyAbilitySystemComponent* InManager)
+		: Manager(InManager)
+	{
+		if (Manager.IsValid())
+		{
+			Manager->BeginModifierTransaction();
+		}
+	}
+
+	~FFireflyScopedModifierTransaction()
+	{
+		if (Manager.IsValid())
+		{
+			Manager->CommitModifierTransaction();
+		}
+	}
+
+	FFireflyScopedModifierTransaction(const FFireflyScopedModifierTransaction&) = delete;
+	FFireflyScopedModifierTransaction& operator=(const FFireflyScopedModifierTransaction&) = delete;
+
+private:
+	/** 开启事务的管理器 */
+	TWeakObjectPtr<UFireflyAbilitySystemComponent> Manager;
+};
@@ -20,6 +20,12 @@ public:
 	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem")
 	static class UFireflyAbilitySystemComponent* GetFireflyAbilitySystem(const AActor* Actor);
 
+	/** 将技能系统管理器登记到缓存中，GetFireflyAbilitySystem优先从缓存中查找，不再遍历Actor的组件 */
+	static void RegisterFireflyAbilitySystem(class UFireflyAbilitySystemComponent* AbilitySystem);
+
+	/** 将技能系统管理器从缓存中移除 */
+	static void UnregisterFireflyAbilitySystem(class UFireflyAbilitySystemComponent* AbilitySystem);
+
 #pragma endregion
 
 
@@ -43,6 +49,9 @@ public:
 	/** 返回一个属性实例的名称 */
 	static FString GetAttributeTypeName(EFireflyAttributeType AttributeType);
 
+	/** 根据属性名称返回属性类型，名称与属性类型的映射只在首次调用时构建一次，不存在时返回AttributeType_Max */
+	static EFireflyAttributeType GetAttributeTypeByName(FName AttributeName);
+
 	/** 获取Actor的某个属性的当前值，如果不存在，返回0 */
 	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Attribute")
 	static float GetAttributeValue(const AActor* Actor, EFireflyAttributeType AttributeType);
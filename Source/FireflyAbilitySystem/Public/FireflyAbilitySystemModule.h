@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 
 #include "Logging/LogMacros.h"
+#include "Stats/Stats.h"
 
 class FFireflyAbilitySystemModule : public IModuleInterface
 {
@@ -20,4 +21,12 @@ FIREFLYABILITYSYSTEM_API DECLARE_LOG_CATEGORY_EXTERN(LogFireflyAttribute, Log, A
 FIREFLYABILITYSYSTEM_API DECLARE_LOG_CATEGORY_EXTERN(LogFireflyAbility, Log, All);
 FIREFLYABILITYSYSTEM_API DECLARE_LOG_CATEGORY_EXTERN(LogFireflyEffect, Log, All);
 
+DECLARE_STATS_GROUP(TEXT("FireflyAbilitySystem"), STATGROUP_FireflyAbilitySystem, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Modifier Calculators Created"), STAT_FireflyModifierCalculatorsCreated, STATGROUP_FireflyAbilitySystem, FIREFLYABILITYSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Effect Scheduler Fire Due Events"), STAT_FireflyEffectSchedulerFireDueEvents, STATGROUP_FireflyAbilitySystem, FIREFLYABILITYSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Effect Scheduler Heap Pop"), STAT_FireflyEffectSchedulerHeapPop, STATGROUP_FireflyAbilitySystem, FIREFLYABILITYSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Effect Scheduler Heap Push"), STAT_FireflyEffectSchedulerHeapPush, STATGROUP_FireflyAbilitySystem, FIREFLYABILITYSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Effect Scheduler Events Fired"), STAT_FireflyEffectSchedulerEventsFired, STATGROUP_FireflyAbilitySystem, FIREFLYABILITYSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Effect Scheduler Queued Events"), STAT_FireflyEffectSchedulerQueuedEvents, STATGROUP_FireflyAbilitySystem, FIREFLYABILITYSYSTEM_API);
+
 FIREFLYABILITYSYSTEM_API FString GetContextNetRoleStringFireflyAS(UObject* ContextObject = nullptr);
\ No newline at end of file
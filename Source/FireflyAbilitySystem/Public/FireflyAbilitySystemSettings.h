@@ -66,5 +66,41 @@ public:
 	UPROPERTY(Config, EditAnywhere, Category = AttributeTypes)
 	TArray<FFireflyAttributeTypeName> AttributeTypes;
 
+	// 是否将属性托管到世界属性存储中，以SoA的形式批量计算属性的当前值，属性值变化的事件会延迟到世界属性存储的Tick中广播
+	UPROPERTY(Config, EditAnywhere, Category = Performance)
+	bool bUseWorldAttributeStore = false;
+
+	// 每个管理器为每种允许池化的效果类型最多保留的空闲效果实例数，超出的实例会被直接回收
+	UPROPERTY(Config, EditAnywhere, Category = Performance, Meta = (ClampMin = 0))
+	int32 EffectInstancePoolSizePerClass = 16;
+
+	// 是否在服务端以环形缓冲记录每帧变化的属性当前值，用于延迟补偿和回滚时查询过去某个时刻的属性值
+	UPROPERTY(Config, EditAnywhere, Category = AttributeHistory)
+	bool bEnableAttributeHistory = false;
+
+	// 属性历史记录保留的帧数，每个组件的内存占用与帧数乘以每帧最大记录数成正比
+	UPROPERTY(Config, EditAnywhere, Category = AttributeHistory, Meta = (ClampMin = 1, EditCondition = "bEnableAttributeHistory"))
+	int32 AttributeHistoryFrameCount = 64;
+
+	// 属性历史记录每帧最多记录的属性数，超出时该帧被标记为溢出，跨越该帧的查询会失败
+	UPROPERTY(Config, EditAnywhere, Category = AttributeHistory, Meta = (ClampMin = 1, EditCondition = "bEnableAttributeHistory"))
+	int32 AttributeHistoryMaxChangesPerFrame = 16;
+
+	// 是否让效果调度器按固定步长推进，效果的持续时间和周期性执行只在全局固定步长的边界上触发，便于回放战斗
+	UPROPERTY(Config, EditAnywhere, Category = EffectScheduling)
+	bool bUseFixedStepEffectScheduling = false;
+
+	// 效果调度器的固定步长（秒），所有世界共享同一时间网格
+	UPROPERTY(Config, EditAnywhere, Category = EffectScheduling, Meta = (ClampMin = 0.001, EditCondition = "bUseFixedStepEffectScheduling"))
+	float EffectSchedulingFixedStep = 1.f / 30.f;
+
+	// 卡顿后周期性效果错过多个周期时，是否合并为一次按周期数缩放的执行，关闭时或效果的修改器不可交换顺序时逐个周期补齐执行
+	UPROPERTY(Config, EditAnywhere, Category = EffectScheduling)
+	bool bCoalesceMissedEffectPeriods = false;
+
+	// 管理器的Tag堆叠数是否只同步给拥有者，关闭时同步给所有客户端
+	UPROPERTY(Config, EditAnywhere, Category = Replication)
+	bool bReplicateTagCountsToOwnerOnly = false;
+
 #pragma endregion
 };
@@ -202,6 +202,42 @@ public:
 	TEnumAsByte<EFireflyAttributeType> RangeMaxValueType = AttributeType_Default;
 };
 
+/** 属性修改器的句柄，由属性类型、修改器槽位和槽位的代数组成，槽位被复用后旧的句柄自动失效 */
+USTRUCT(BlueprintType)
+struct FFireflyModifierHandle
+{
+	GENERATED_BODY()
+
+public:
+	/** 修改器作用的属性类型 */
+	UPROPERTY()
+	TEnumAsByte<EFireflyAttributeType> AttributeType = AttributeType_Max;
+
+	/** 修改器在属性中的槽位 */
+	UPROPERTY()
+	int32 SlotIndex = INDEX_NONE;
+
+	/** 修改器槽位的代数 */
+	UPROPERTY()
+	int32 Generation = 0;
+
+	FFireflyModifierHandle() {}
+
+	FFireflyModifierHandle(EFireflyAttributeType InAttributeType, int32 InSlotIndex, int32 InGeneration)
+		: AttributeType(InAttributeType), SlotIndex(InSlotIndex), Generation(InGeneration) {}
+
+	/** 句柄是否指向过一个修改器，不代表修改器仍然存在 */
+	FORCEINLINE bool IsValid() const { return SlotIndex != INDEX_NONE; }
+
+	/** 使句柄失效 */
+	FORCEINLINE void Invalidate() { SlotIndex = INDEX_NONE; }
+
+	FORCEINLINE bool operator==(const FFireflyModifierHandle& Other) const
+	{
+		return AttributeType == Other.AttributeType && SlotIndex == Other.SlotIndex && Generation == Other.Generation;
+	}
+};
+
 #pragma endregion
 
 
@@ -263,6 +299,20 @@ enum class EFireflyEffectInstigatorApplicationPolicy : uint8
 	InstigatorsShareOne,
 };
 
+/** 批量应用效果时每个目标的应用结果 */
+UENUM(BlueprintType)
+enum class EFireflyEffectApplicationResult : uint8
+{
+	/** 效果已被应用 */
+	Applied,
+	/** 目标无效或目标没有技能系统管理器 */
+	InvalidTarget,
+	/** 效果被目标的Tags阻挡 */
+	Blocked,
+	/** 目标已有的同种效果没有接受本次应用，如满堆叠时拒绝新的堆叠 */
+	NotApplied,
+};
+
 /** 效果的属性修改器使用的取值方法 */
 UENUM()
 enum class EFireflyEffectModifierValueMethod : uint8
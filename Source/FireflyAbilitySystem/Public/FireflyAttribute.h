@@ -10,6 +10,7 @@
 // CurrentValue = NewestOuterOverrideMod || (((BaseValue || NewestInnerOverrideMod) + PlusMods - MinusMods) * (1 + MultiplyMods)) / (TotalDivideMod == 0.f ? 1.f : TotalDivideMod))
 
 class UFireflyAbilitySystemComponent;
+class UFireflyAttributeStoreSubsystem;
 
 /** 属性修改器 */
 USTRUCT()
@@ -24,9 +25,22 @@ public:
 	UPROPERTY()
 	float ModValue = 0.f;
 
+	/** 修改器的堆叠数，槽位空闲时记录下一个空闲槽位 */
 	UPROPERTY()
 	int32 StackCount = 0;
 
+	/** 修改器的应用序号，用于确定覆盖修改器的先后顺序 */
+	UPROPERTY()
+	uint32 ApplyOrder = 0;
+
+	/** 修改器槽位的代数，槽位每次被释放时递增 */
+	UPROPERTY()
+	uint16 Generation = 0;
+
+	/** 修改器的运算符，为None时表示该槽位空闲 */
+	UPROPERTY()
+	EFireflyAttributeModOperator ModOperator = EFireflyAttributeModOperator::None;
+
 	UPROPERTY()
 	bool bIsActive = true;
 
@@ -40,6 +54,116 @@ public:
 	{
 		return ModSource == Other.ModSource && ModValue == Other.ModValue;
 	}
+
+	/** 修改器对所属运算符的合值的贡献 */
+	FORCEINLINE float GetAggregateContribution() const
+	{
+		return bIsActive ? ModValue * StackCount : 0.f;
+	}
+};
+
+/** 属性修改器容器，按槽位存储修改器并增量维护各运算符的合值，属性实例和结构体属性共用 */
+USTRUCT()
+struct FIREFLYABILITYSYSTEM_API FFireflyAttributeModifierContainer
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	/** 添加一个修改器，返回修改器所在的槽位 */
+	int32 AddModifier(EFireflyAttributeModOperator ModOperator, UObject* ModSource, float ModValue, int32 StackCount);
+
+	/** 移除某个槽位的修改器，并释放该槽位 */
+	void RemoveModifierAt(int32 SlotIndex);
+
+	/** 重设某个槽位的修改器的堆叠数 */
+	void SetModifierStackAt(int32 SlotIndex, int32 NewStackCount);
+
+	/** 重设某个槽位的修改器的值和堆叠数 */
+	void SetModifierValueAt(int32 SlotIndex, float NewModValue, int32 NewStackCount);
+
+	/** 更改某个槽位的修改器的活跃状态 */
+	void SetModifierActiveAt(int32 SlotIndex, bool bNewActiveState);
+
+	/** 查找来源和值都相同的修改器的槽位，不存在时返回INDEX_NONE，仅供按来源和值指定修改器的已弃用接口使用，新代码应使用句柄 */
+	int32 FindModifier(EFireflyAttributeModOperator ModOperator, const UObject* ModSource, float ModValue) const;
+
+	/** 查找来源相同的修改器的槽位，不存在时返回INDEX_NONE */
+	int32 FindModifierBySource(EFireflyAttributeModOperator ModOperator, const UObject* ModSource) const;
+
+	/** 查找某个运算符最先应用的修改器的槽位，不存在时返回INDEX_NONE */
+	int32 FindFirstAppliedModifier(EFireflyAttributeModOperator ModOperator, bool bActiveOnly) const;
+
+	/** 为某个槽位的修改器生成句柄 */
+	FFireflyModifierHandle MakeModifierHandle(EFireflyAttributeType AttributeType, int32 SlotIndex) const;
+
+	/** 句柄指向的槽位是否仍然是生成句柄时的修改器，不校验属性类型 */
+	bool IsModifierHandleValid(const FFireflyModifierHandle& ModifierHandle) const;
+
+	/** 获取某个槽位的修改器 */
+	FORCEINLINE const FFireflyAttributeModifier& GetModifierAt(int32 SlotIndex) const { return ModifierSlots[SlotIndex]; }
+
+	/** 某个运算符的修改器数量 */
+	FORCEINLINE int32 GetModifierCount(EFireflyAttributeModOperator ModOperator) const { return ModifierCounts[static_cast<uint8>(ModOperator)]; }
+
+	/** 获取基础值或最先应用的活跃的内部覆盖修改器的值 */
+	float GetBaseValueToUse(float BaseValue) const;
+
+	/** 获取最先应用的外部覆盖修改器的值，不存在时返回false */
+	bool GetOuterOverrideValue(float& OutValue) const;
+
+	/** 按照属性公式计算未夹值的当前值，存在外部覆盖修改器时直接使用其值 */
+	float EvaluateCurrentValue(float BaseValue) const;
+
+	/** 按照运算符修改一个值，用于永久修改属性的基础值 */
+	static float ApplyModOperatorToValue(float Value, EFireflyAttributeModOperator ModOperator, float ModValue);
+
+	/** 遍历所有修改器，完整地重新计算各运算符的合值 */
+	void RecalculateAggregates();
+
+	/** 调试模式下校验增量维护的合值与完整重新计算的结果是否一致，不一致时输出警告并修正 */
+	void VerifyAggregates(EFireflyAttributeType AttributeType);
+
+	/** 向垃圾回收报告所有修改器的来源 */
+	void AddReferencedObjects(FReferenceCollector& Collector, const UObject* Referencer);
+
+	/** 修改器存储在堆上分配的字节数，修改器数量不超过内联容量时为0 */
+	FORCEINLINE SIZE_T GetAllocatedSize() const { return ModifierSlots.GetAllocatedSize(); }
+
+	FORCEINLINE float GetTotalPlus() const { return PlusAggregate; }
+
+	FORCEINLINE float GetTotalMinus() const { return MinusAggregate; }
+
+	FORCEINLINE float GetTotalMultiply() const { return MultiplyAggregate; }
+
+	FORCEINLINE float GetTotalDivide() const { return DivideAggregate == 0.f ? 1.f : DivideAggregate; }
+
+protected:
+	/** 修改器被添加、移除、重设堆叠数或切换活跃状态后，以增量的方式更新对应运算符的合值 */
+	void UpdateAggregate(EFireflyAttributeModOperator ModOperator, float OldContribution, float NewContribution);
+
+	/** 所有修改器，按运算符标记，被释放的槽位会被新的修改器复用，少量修改器时不产生堆分配 */
+	TArray<FFireflyAttributeModifier, TInlineAllocator<2>> ModifierSlots;
+
+	/** 第一个空闲的修改器槽位，空闲槽位通过堆叠数串联 */
+	int32 FirstFreeModifierSlot = INDEX_NONE;
+
+	/** 下一个被应用的修改器的应用序号 */
+	uint32 NextModifierApplyOrder = 0;
+
+	/** 各运算符的修改器数量 */
+	uint16 ModifierCounts[static_cast<uint8>(EFireflyAttributeModOperator::OuterOverride) + 1] = {};
+
+	/** 加法修改器的合值 */
+	float PlusAggregate = 0.f;
+
+	/** 减法修改器的合值 */
+	float MinusAggregate = 0.f;
+
+	/** 乘法修改器的合值 */
+	float MultiplyAggregate = 0.f;
+
+	/** 除法修改器的合值 */
+	float DivideAggregate = 0.f;
 };
 
 /** 属性 */
@@ -59,6 +183,8 @@ public:
 
 	virtual int32 GetFunctionCallspace(UFunction* Function, FFrame* Stack) override;
 
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
 #pragma endregion
 
 
@@ -102,6 +228,9 @@ public:
 	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Attribute", Meta = (BlueprintProtected = "true"))
 	FORCEINLINE float GetBaseValueToUse() const;
 
+	/** 获取该属性的当前值所依赖的所有源属性类型，包括范围最大值属性类型和派生属性的源属性类型 */
+	void GetDependencySourceTypes(TArray<EFireflyAttributeType, TInlineAllocator<4>>& OutSourceTypes) const;
+
 protected:
 	/** 属性名 */
 	UPROPERTY(EditDefaultsOnly, Category = "Basic")
@@ -139,8 +268,14 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "ClampRange", Meta = (EditCondition = "bAttributeHasRange"))
 	TEnumAsByte<EFireflyAttributeType> RangeMaxValueType = AttributeType_Default;
 
+	/** 派生属性的当前值所依赖的源属性类型，源属性的当前值变化时该属性会被重新计算，不可形成循环依赖 */
+	UPROPERTY(EditDefaultsOnly, Category = "Dependency")
+	TArray<TEnumAsByte<EFireflyAttributeType>> DerivedSourceTypes;
+
 	friend UFireflyAbilitySystemComponent;
 
+	friend struct FFireflyStructAttribute;
+
 #pragma endregion
 
 
@@ -178,30 +313,34 @@ protected:
 	/** 获取属性的内部覆盖修改器的最新值 */
 	UFUNCTION(BlueprintPure, Category = "FireflyAbilitySystem|Attribute", Meta = (BlueprintProtected = "true"))
 	FORCEINLINE bool GetNewestOuterOverrideModifier(float& NewestValue) const;
-	
-	/** 属性的所有加法修改器 */
-	UPROPERTY()
-	TArray<FFireflyAttributeModifier> PlusMods = TArray<FFireflyAttributeModifier>{};
 
-	/** 属性的所有减法修改器 */
-	UPROPERTY()
-	TArray<FFireflyAttributeModifier> MinusMods = TArray<FFireflyAttributeModifier>{};
+public:
+	/** 修改器存储在堆上分配的字节数，修改器数量不超过内联容量时为0 */
+	FORCEINLINE SIZE_T GetModifierHeapSize() const { return Modifiers.GetAllocatedSize(); }
 
-	/** 属性的所有乘法修改器 */
-	UPROPERTY()
-	TArray<FFireflyAttributeModifier> MultiplyMods = TArray<FFireflyAttributeModifier>{};
+protected:
+	/** 作用于该属性的所有修改器，由AddReferencedObjects维持修改器来源的引用 */
+	FFireflyAttributeModifierContainer Modifiers;
 
-	/** 属性的所有除法修改器 */
-	UPROPERTY()
-	TArray<FFireflyAttributeModifier> DivideMods = TArray<FFireflyAttributeModifier>{};
+#pragma endregion
 
-	/** 属性的所有内部覆盖修改器 */
-	UPROPERTY()
-	TArray<FFireflyAttributeModifier> InnerOverrideMods = TArray<FFireflyAttributeModifier>{};
 
-	/** 属性的所有外部覆盖修改器 */
-	UPROPERTY()
-	TArray<FFireflyAttributeModifier> OuterOverrideMods = TArray<FFireflyAttributeModifier>{};
+#pragma region AttributeStore 世界属性存储
+
+protected:
+	/** 属性是否可以托管到世界属性存储中，原生子类或蓝图重写了当前值计算逻辑的属性不能托管 */
+	bool CanUseAttributeStore() const;
+
+	/** 将计算当前值所需的基础值、修改器合值和夹值范围写入世界属性存储 */
+	void WriteToAttributeStore();
+
+	/** 属性托管的世界属性存储 */
+	UFireflyAttributeStoreSubsystem* AttributeStore = nullptr;
+
+	/** 属性在世界属性存储中的槽位 */
+	int32 AttributeStoreSlot = INDEX_NONE;
+
+	friend UFireflyAttributeStoreSubsystem;
 
 #pragma endregion
 };
@@ -0,0 +1,123 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FireflyAttributeStoreSubsystem.generated.h"
+
+class UFireflyAttribute;
+
+/** 世界属性存储，以SoA的形式连续存放世界中所有托管属性的基础值、修改器合值和夹值范围，并批量地以SIMD计算脏属性的当前值 */
+UCLASS()
+class FIREFLYABILITYSYSTEM_API UFireflyAttributeStoreSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Override 基类重载
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+#pragma endregion
+
+
+#pragma region Slot 槽位
+
+public:
+	/** 为属性分配一个槽位，返回槽位的下标 */
+	int32 RegisterAttribute(UFireflyAttribute* Attribute);
+
+	/** 释放属性占用的槽位 */
+	void UnregisterAttribute(int32 Slot);
+
+	/** 写入槽位计算当前值所需的数据，并将槽位标记为脏 */
+	void WriteAttributeOperands(int32 Slot, float BaseValue, float PlusValue, float MinusValue, float MultiplyValue,
+		float DivideValue, float RangeMinValue, float RangeMaxValue);
+
+	/** 读取槽位的当前值，槽位为脏时立即计算该槽位所在的块 */
+	float ReadAttributeValue(int32 Slot);
+
+protected:
+	/** 扩容一个块的槽位，新的槽位均为空闲 */
+	void AddSlotBlock();
+
+	/** 将槽位初始化为不会影响计算结果的空值 */
+	void ResetSlot(int32 Slot);
+
+protected:
+	/** 每个块包含的槽位数，与SIMD寄存器的宽度一致 */
+	static constexpr int32 SlotsPerBlock = 4;
+
+	/** 槽位对应的属性 */
+	TArray<TWeakObjectPtr<UFireflyAttribute>> SlotAttributes;
+
+	/** 空闲的槽位 */
+	TArray<int32> FreeSlots;
+
+	/** 基础值或内部覆盖修改器的值，外部覆盖时为外部覆盖修改器的值 */
+	TArray<float> BaseValues;
+
+	/** 加法修改器的合值 */
+	TArray<float> PlusValues;
+
+	/** 减法修改器的合值 */
+	TArray<float> MinusValues;
+
+	/** 乘法修改器的合值 */
+	TArray<float> MultiplyValues;
+
+	/** 除法修改器的合值，为0时已被替换为1 */
+	TArray<float> DivideValues;
+
+	/** 夹值范围的最小值 */
+	TArray<float> RangeMinValues;
+
+	/** 夹值范围的最大值 */
+	TArray<float> RangeMaxValues;
+
+	/** 计算得到的当前值 */
+	TArray<float> CurrentValues;
+
+#pragma endregion
+
+
+#pragma region Evaluation 批量计算
+
+public:
+	/** 计算所有脏块，并将变化的当前值同步回属性 */
+	void FlushAttributeStore();
+
+protected:
+	/** 以SIMD计算一个块中所有槽位的当前值 */
+	void EvaluateBlock(int32 BlockIndex);
+
+	/** 计算所有脏块 */
+	void EvaluateDirtyBlocks();
+
+	/** 将计算后发生变化的当前值同步回属性，并通知属性所属的管理器 */
+	void PublishEvaluatedValues();
+
+protected:
+	/** 每个块是否为脏 */
+	TBitArray<> DirtyBlocks;
+
+	/** 脏块的数量 */
+	int32 NumDirtyBlocks = 0;
+
+	/** 计算后等待同步回属性的槽位 */
+	TArray<int32> PendingPublishSlots;
+
+	/** 槽位是否已在等待同步的列表中 */
+	TBitArray<> PendingPublishMask;
+
+#pragma endregion
+};
@@ -4,13 +4,281 @@
 
 #include "CoreMinimal.h"
 #include "FireflyAbilitySystemTypes.h"
+#include "FireflyGameplayTagBits.h"
 #include "UObject/NoExportTypes.h"
 #include "FireflyEffect.generated.h"
 
 class UFireflyAbilitySystemComponent;
+class UFireflyEffect;
+class UFireflyEffectSchedulerSubsystem;
+
+/** 效果应用判定使用的预计算Tag位集合 */
+struct FIREFLYABILITYSYSTEM_API FFireflyEffectApplicationTagBits
+{
+	/** 效果的资产Tags */
+	FFireflyGameplayTagBits AssetTags;
+
+	/** 效果应用时要求拥有者具有的Tags，包含父级Tag */
+	FFireflyGameplayTagBits RequireTagsWithParents;
+
+	/** 拥有者具有这些Tags时效果无法应用 */
+	FFireflyGameplayTagBits BlockTags;
+
+	FFireflyEffectApplicationTagBits() {}
+
+	FFireflyEffectApplicationTagBits(const FGameplayTagContainer& InAssetTags, const FGameplayTagContainer& InRequireTags,
+		const FGameplayTagContainer& InBlockTags);
+};
+
+/** 效果的不可变定义，同一效果类型或内容相同的动态构造器共享同一份定义，效果实例只保存运行时状态 */
+struct FIREFLYABILITYSYSTEM_API FFireflyEffectDefinition
+{
+	/** 效果的持续性策略 */
+	EFireflyEffectDurationPolicy DurationPolicy = EFireflyEffectDurationPolicy::Instant;
+
+	/** 效果的持续时间，仅在持续策略为“HasDuration”时起作用 */
+	float Duration = 0.f;
+
+	/** 效果是否周期性执行 */
+	bool bIsEffectExecutionPeriodic = false;
+
+	/** 效果周期性执行的间隔时间 */
+	float PeriodicInterval = 0.f;
+
+	/** 效果的堆叠策略 */
+	EFireflyEffectStackingPolicy StackingPolicy = EFireflyEffectStackingPolicy::None;
+
+	/** 效果的堆叠上限 */
+	int32 StackingLimitation = 0;
+
+	/** 效果堆叠时是否刷新持续时间 */
+	bool bShouldRefreshDurationOnStacking = false;
+
+	/** 效果堆叠时是否重置周期性执行 */
+	bool bShouldResetPeriodicityOnStacking = false;
+
+	/** 效果堆叠溢出时应用的效果 */
+	TArray<TSubclassOf<UFireflyEffect>> OverflowEffects;
+
+	/** 效果堆叠溢出时是否拒绝新的堆叠 */
+	bool bDenyNewStackingOnOverflow = false;
+
+	/** 效果堆叠溢出时是否清除所有堆叠 */
+	bool bClearStackingOnOverflow = false;
+
+	/** 效果持续时间到期时堆叠的处理策略 */
+	EFireflyEffectDurationPolicyOnStackingExpired StackingExpirationPolicy = EFireflyEffectDurationPolicyOnStackingExpired::ClearEntireStack;
+
+	/** 效果携带的属性修改器 */
+	TArray<FFireflyEffectModifierData> Modifiers;
+
+	/** 效果携带的特殊属性 */
+	TArray<FFireflySpecificProperty> SpecificProperties;
+
+	/** 效果的发起者应用策略 */
+	EFireflyEffectInstigatorApplicationPolicy InstigatorApplicationPolicy = EFireflyEffectInstigatorApplicationPolicy::InstigatorsApplyTheirOwnOnly;
+
+	/** 效果的资产Tags */
+	FGameplayTagContainer TagsForEffectAsset;
+
+	/** 效果生效时赋予拥有者的Tags */
+	FGameplayTagContainer TagsApplyToOwnerOnApplied;
+
+	/** 效果持续生效要求拥有者具有的Tags */
+	FGameplayTagContainer TagsRequiredOngoing;
+
+	/** 拥有者具有这些Tags时效果暂时失效 */
+	FGameplayTagContainer TagsBlockedOngoing;
+
+	/** 效果生效时移除带有这些资产Tags的效果 */
+	FGameplayTagContainer TagsOfEffectsWillBeRemoved;
+
+	/** 效果生效期间阻挡带有这些资产Tags的效果 */
+	FGameplayTagContainer TagsOfEffectsWillBeBlocked;
+
+	/** 效果应用时要求拥有者具有的Tags */
+	FGameplayTagContainer TagsRequireOwnerHasForApplication;
+
+	/** 拥有者具有这些Tags时效果无法应用 */
+	FGameplayTagContainer TagsBlockApplicationOnOwnerHas;
+
+	/** 效果应用判定使用的Tag位集合 */
+	FFireflyEffectApplicationTagBits ApplicationTagBits;
+
+	/** TagsRequiredOngoing的位集合 */
+	FFireflyGameplayTagBits TagsRequiredOngoingBits;
+
+	/** TagsBlockedOngoing的位集合 */
+	FFireflyGameplayTagBits TagsBlockedOngoingBits;
+
+	FFireflyEffectDefinition() {}
+
+	explicit FFireflyEffectDefinition(const UFireflyEffect* EffectCDO);
+
+	explicit FFireflyEffectDefinition(const FFireflyEffectSparseClassData& ClassData);
+
+	explicit FFireflyEffectDefinition(const FFireflyEffectDynamicConstructor& EffectSetup);
+
+	bool operator==(const FFireflyEffectDefinition& Other) const;
+
+	friend uint32 GetTypeHash(const FFireflyEffectDefinition& Definition);
+
+	/** 根据Tag容器重建预计算的Tag位集合，修改Tag容器后需要调用 */
+	void BuildTagBits();
+
+	/** 向垃圾回收报告定义引用的计算器实例和溢出效果类型 */
+	void AddReferencedObjects(FReferenceCollector& Collector) const;
+
+	/** 获取某个效果类型的共享定义，首次获取时根据类型的默认对象构建 */
+	static TSharedRef<const FFireflyEffectDefinition> FindOrCreateForClass(TSubclassOf<UFireflyEffect> EffectType);
+
+	/** 获取与动态构造器内容相同的共享定义，不存在时创建，不再被效果引用的定义会被释放 */
+	static TSharedRef<const FFireflyEffectDefinition> FindOrCreateForDynamicConstructor(const FFireflyEffectDynamicConstructor& EffectSetup);
+};
+
+/** 不创建效果实例即可执行的Instant效果，引用效果类型的默认对象或外部传入的修改器，只在执行期间有效 */
+struct FIREFLYABILITYSYSTEM_API FFireflyEffectSpec
+{
+	/** 效果类型的默认对象，作为修改器的来源 */
+	UFireflyEffect* EffectCDO = nullptr;
+
+	/** 效果的ID，对应创建效果实例时为实例设置的EffectID */
+	FName EffectID = NAME_None;
+
+	/** 效果的发起者 */
+	AActor* Instigator = nullptr;
+
+	/** 效果携带的属性修改器 */
+	TArrayView<const FFireflyEffectModifierData> Modifiers;
+
+	/** 效果的资产标签 */
+	const FGameplayTagContainer* TagsForEffectAsset = nullptr;
+
+	/** 效果的应用需要管理器含有的标签 */
+	const FGameplayTagContainer* TagsRequireOwnerHasForApplication = nullptr;
+
+	/** 效果的应用期望管理器不含的标签 */
+	const FGameplayTagContainer* TagsBlockApplicationOnOwnerHas = nullptr;
+
+	/** 标签来自共享定义时，定义中预计算的标签位集合 */
+	const FFireflyEffectApplicationTagBits* ApplicationTagBits = nullptr;
+
+	FFireflyEffectSpec() {}
+
+	/** 使用效果类型的默认对象中配置的修改器和标签 */
+	explicit FFireflyEffectSpec(UFireflyEffect* InEffectCDO);
+
+	/** 使用外部传入的修改器，标签使用效果类型的默认对象中配置的标签 */
+	FFireflyEffectSpec(UFireflyEffect* InEffectCDO, TArrayView<const FFireflyEffectModifierData> InModifiers);
+
+	/** 使用动态构造器中的修改器和标签 */
+	FFireflyEffectSpec(UFireflyEffect* InEffectCDO, const FFireflyEffectDynamicConstructor& EffectSetup);
+
+	/** 效果类型没有原生或蓝图重写的逻辑，且修改器不使用计算器时，才能不创建效果实例直接执行 */
+	bool CanExecuteWithoutInstance() const;
+};
+
+/** 效果的配置，作为稀疏类数据每个效果类型只保存一份，效果实例上不含这些属性 */
+USTRUCT(BlueprintType)
+struct FIREFLYABILITYSYSTEM_API FFireflyEffectSparseClassData
+{
+	GENERATED_BODY()
+
+	/** 效果的持续性策略 */
+	UPROPERTY(EditDefaultsOnly, Category = Duration)
+	EFireflyEffectDurationPolicy DurationPolicy = EFireflyEffectDurationPolicy::Instant;
+
+	/** 效果的持续时间，仅在持续策略为“HasDuration”时起作用 */
+	UPROPERTY(EditDefaultsOnly, Category = Duration, Meta = (EditCondition = "DurationPolicy == EFireflyEffectDurationPolicy::HasDuration"))
+	float Duration = 0.f;
+
+	/** 效果在生效时是否按周期执行逻辑 */
+	UPROPERTY(EditDefaultsOnly, Category = Periodicity)
+	bool bIsEffectExecutionPeriodic = false;
+
+	/** 效果的周期间隔时间，尽在周期性策略为“true”时起作用 */
+	UPROPERTY(EditDefaultsOnly, Category = Periodicity, Meta = (EditCondition = "bIsEffectExecutionPeriodic == true"))
+	float PeriodicInterval = 0.f;
+
+	/** 该效果选择的堆叠策略 */
+	UPROPERTY(EditDefaultsOnly, Category = Stacking)
+	EFireflyEffectStackingPolicy StackingPolicy = EFireflyEffectStackingPolicy::None;
+
+	/** 效果的堆叠量上限，仅在堆叠策略为“StackHasLimit”时起作用 */
+	UPROPERTY(EditDefaultsOnly, Category = Stacking, Meta = (EditCondition = "StackingPolicy == EFireflyEffectStackingPolicy::StackHasLimit"))
+	int32 StackingLimitation = 0;
+
+	/** 效果有新的实例被执行或堆叠数量增加时，是否刷新持续时间 */
+	UPROPERTY(EditDefaultsOnly, Category = Stacking)
+	bool bShouldRefreshDurationOnStacking = false;
+
+	/** 效果有新的实例被执行或堆叠数量增加时，是否重置周期性 */
+	UPROPERTY(EditDefaultsOnly, Category = Stacking)
+	bool bShouldResetPeriodicityOnStacking = false;
+
+	/** 效果的堆叠数达到上限时，触发的额外的效果 */
+	UPROPERTY(EditDefaultsOnly, Category = Stacking)
+	TArray<TSubclassOf<UFireflyEffect>> OverflowEffects;
+
+	/** 效果的堆叠数达到上限时，是否拒绝新的堆叠应用 */
+	UPROPERTY(EditDefaultsOnly, Category = Stacking)
+	bool bDenyNewStackingOnOverflow = false;
+
+	/** 效果的堆叠数达到上限时，是否清除所有的堆叠数 */
+	UPROPERTY(EditDefaultsOnly, Category = Stacking)
+	bool bClearStackingOnOverflow = false;
+
+	/** 堆叠到期策略，即效果的持续时间的到期对堆叠的影响 */
+	UPROPERTY(EditDefaultsOnly, Category = Stacking)
+	EFireflyEffectDurationPolicyOnStackingExpired StackingExpirationPolicy = EFireflyEffectDurationPolicyOnStackingExpired::ClearEntireStack;
+
+	/** 该效果携带的属性修改器 */
+	UPROPERTY(EditDefaultsOnly, Category = Modifier)
+	TArray<FFireflyEffectModifierData> Modifiers;
+
+	/** 该效果携带的特殊属性 */
+	UPROPERTY(EditDefaultsOnly, Category = Modifier)
+	TArray<FFireflySpecificProperty> SpecificProperties;
+
+	/** 效果的发起者应用策略 */
+	UPROPERTY(EditDefaultsOnly, Category = Instancing)
+	EFireflyEffectInstigatorApplicationPolicy InstigatorApplicationPolicy = EFireflyEffectInstigatorApplicationPolicy::InstigatorsApplyTheirOwnOnly;
+
+	/** 效果的标签Tags，仅用于描述修饰效果资产 */
+	UPROPERTY(EditDefaultsOnly, Category = Tags)
+	FGameplayTagContainer TagsForEffectAsset;
+
+	/** 效果被应用时，会应用给管理器组件的Tags */
+	UPROPERTY(EditDefaultsOnly, Category = Tags)
+	FGameplayTagContainer TagsApplyToOwnerOnApplied;
+
+	/** 效果被应用时，管理器组件需要拥有这些Tags，该效果才能真的起作用 */
+	UPROPERTY(EditDefaultsOnly, Category = Tags)
+	FGameplayTagContainer TagsRequiredOngoing;
+
+	/** 效果被应用时，管理器组件需要没有这些Tags，该效果才能真的起作用 */
+	UPROPERTY(EditDefaultsOnly, Category = Tags)
+	FGameplayTagContainer TagsBlockedOngoing;
+
+	/** 该效果的激活应用会取消带有这些资产标记Tags的效果的应用 */
+	UPROPERTY(EditDefaultsOnly, Category = Tags)
+	FGameplayTagContainer TagsOfEffectsWillBeRemoved;
+
+	/** 该效果的激活应用会阻断带有这些资产标记Tags的效果的应用 */
+	UPROPERTY(EditDefaultsOnly, Category = Tags)
+	FGameplayTagContainer TagsOfEffectsWillBeBlocked;
+
+	/** 该效果的激活应用需要管理器含有如下Tags */
+	UPROPERTY(EditDefaultsOnly, Category = Tags)
+	FGameplayTagContainer TagsRequireOwnerHasForApplication;
+
+	/** 该效果的激活应用期望管理器不含如下Tags */
+	UPROPERTY(EditDefaultsOnly, Category = Tags)
+	FGameplayTagContainer TagsBlockApplicationOnOwnerHas;
+};
 
 /** 效果 */
-UCLASS( Blueprintable )
+UCLASS( Blueprintable, SparseClassDataTypes = FireflyEffectSparseClassData )
 class FIREFLYABILITYSYSTEM_API UFireflyEffect : public UObject
 {
 	GENERATED_UCLASS_BODY()
@@ -26,6 +294,121 @@ public:
 
 	virtual int32 GetFunctionCallspace(UFunction* Function, FFrame* Stack) override;
 
+	virtual void PostInitProperties() override;
+
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	virtual void MoveDataToSparseClassDataStruct() const override;
+#endif
+
+#pragma endregion
+
+
+#pragma region Definition 效果定义
+
+public:
+	/** 获取效果的定义，效果的持续、周期、堆叠、修改器和Tags等配置都从定义中读取 */
+	FORCEINLINE const FFireflyEffectDefinition& GetDefinition() const
+	{
+		if (!Definition.IsValid())
+		{
+			Definition = FFireflyEffectDefinition::FindOrCreateForClass(GetClass());
+		}
+
+		return *Definition;
+	}
+
+	/** 获取效果可修改的定义，定义仍与其他效果共享时先复制一份私有的定义 */
+	FFireflyEffectDefinition& GetMutableDefinition();
+
+protected:
+	/** 获取定义的强引用，执行过程中效果可能被移除或回收时，保证定义在执行期间有效 */
+	TSharedRef<const FFireflyEffectDefinition> PinDefinition() const;
+
+	/** 使效果引用一份共享的定义，丢弃动态修改后私有的定义 */
+	void BindSharedDefinition(const TSharedRef<const FFireflyEffectDefinition>& NewDefinition);
+
+	/** 效果引用的定义，类默认对象上为该类型共享的定义 */
+	mutable TSharedPtr<const FFireflyEffectDefinition> Definition;
+
+	/** 效果被动态修改后私有的定义，与Definition指向同一份数据 */
+	TSharedPtr<FFireflyEffectDefinition> PrivateDefinition;
+
+#if WITH_EDITORONLY_DATA
+	/** 配置移入稀疏类数据之前保存在蓝图类上的值，只在加载旧资产时迁移到稀疏类数据 */
+	UPROPERTY()
+	EFireflyEffectDurationPolicy DurationPolicy_DEPRECATED;
+
+	UPROPERTY()
+	float Duration_DEPRECATED;
+
+	UPROPERTY()
+	bool bIsEffectExecutionPeriodic_DEPRECATED;
+
+	UPROPERTY()
+	float PeriodicInterval_DEPRECATED;
+
+	UPROPERTY()
+	EFireflyEffectStackingPolicy StackingPolicy_DEPRECATED;
+
+	UPROPERTY()
+	int32 StackingLimitation_DEPRECATED;
+
+	UPROPERTY()
+	bool bShouldRefreshDurationOnStacking_DEPRECATED;
+
+	UPROPERTY()
+	bool bShouldResetPeriodicityOnStacking_DEPRECATED;
+
+	UPROPERTY()
+	TArray<TSubclassOf<UFireflyEffect>> OverflowEffects_DEPRECATED;
+
+	UPROPERTY()
+	bool bDenyNewStackingOnOverflow_DEPRECATED;
+
+	UPROPERTY()
+	bool bClearStackingOnOverflow_DEPRECATED;
+
+	UPROPERTY()
+	EFireflyEffectDurationPolicyOnStackingExpired StackingExpirationPolicy_DEPRECATED;
+
+	UPROPERTY()
+	TArray<FFireflyEffectModifierData> Modifiers_DEPRECATED;
+
+	UPROPERTY()
+	TArray<FFireflySpecificProperty> SpecificProperties_DEPRECATED;
+
+	UPROPERTY()
+	EFireflyEffectInstigatorApplicationPolicy InstigatorApplicationPolicy_DEPRECATED;
+
+	UPROPERTY()
+	FGameplayTagContainer TagsForEffectAsset_DEPRECATED;
+
+	UPROPERTY()
+	FGameplayTagContainer TagsApplyToOwnerOnApplied_DEPRECATED;
+
+	UPROPERTY()
+	FGameplayTagContainer TagsRequiredOngoing_DEPRECATED;
+
+	UPROPERTY()
+	FGameplayTagContainer TagsBlockedOngoing_DEPRECATED;
+
+	UPROPERTY()
+	FGameplayTagContainer TagsOfEffectsWillBeRemoved_DEPRECATED;
+
+	UPROPERTY()
+	FGameplayTagContainer TagsOfEffectsWillBeBlocked_DEPRECATED;
+
+	UPROPERTY()
+	FGameplayTagContainer TagsRequireOwnerHasForApplication_DEPRECATED;
+
+	UPROPERTY()
+	FGameplayTagContainer TagsBlockApplicationOnOwnerHas_DEPRECATED;
+#endif
+
 #pragma endregion
 
 
@@ -48,6 +431,15 @@ public:
 protected:
 	friend UFireflyAbilitySystemComponent;
 
+	friend struct FFireflyEffectSpec;
+
+	friend struct FFireflyEffectDefinition;
+
+	friend UFireflyEffectSchedulerSubsystem;
+
+	/** 获取效果所在世界的效果调度器 */
+	UFireflyEffectSchedulerSubsystem* GetEffectScheduler() const;
+
 	/** 效果的唯一标识ID */
 	UPROPERTY()
 	FName EffectID;
@@ -70,18 +462,15 @@ protected:
 	UFUNCTION()
 	void TryExecuteOrRefreshDuration();
 
-protected:
-	/** 效果的持续性策略 */
-	UPROPERTY(EditDefaultsOnly, Category = Duration)
-	EFireflyEffectDurationPolicy DurationPolicy;
+	/** 效果的持续时间是否正在计时 */
+	FORCEINLINE bool IsDurationTicking() const { return DurationEventSerial != 0; }
 
-	/** 效果的持续时间，仅在持续策略为“HasDuration”时起作用 */
-	UPROPERTY(EditDefaultsOnly, Category = Duration, Meta = (EditCondition = "DurationPolicy == EFireflyEffectDurationPolicy::HasDuration"))
-	float Duration;
+protected:
+	/** 效果的持续时间到期的世界时间 */
+	double DurationExpireTime = 0.0;
 
-	/** 效果的持续时间计时器句柄 */
-	UPROPERTY()
-	FTimerHandle DurationTimer;
+	/** 效果的持续时间在调度器中的事件序号，为0时持续时间没有在计时 */
+	uint64 DurationEventSerial = 0;
 
 #pragma endregion
 
@@ -92,19 +481,28 @@ protected:
 	/** 尝试执行或重置周期性逻辑 */
 	UFUNCTION()
 	void TryExecuteOrResetPeriodicity();
+
+	/** 效果的周期性执行是否正在计时，被暂停时不算在计时 */
+	FORCEINLINE bool IsPeriodicityTicking() const { return PeriodicityEventSerial != 0; }
+
+	/** 一次执行合并的多个周期，加减的操作值乘以周期数，乘除的操作值取周期数次幂 */
+	void ExecuteEffectPeriods(int32 PeriodCount);
+
+	/** 多个周期能否合并为一次执行，要求效果类型没有重写执行逻辑，修改器不使用计算器、不取值于该效果修改的属性，且只有一个修改器，或修改器作用的属性都不夹值且彼此可交换顺序 */
+	bool CanCoalescePeriods() const;
 	
 protected:
-	/** 效果在生效时是否按周期执行逻辑 */
-	UPROPERTY(EditDefaultsOnly, Category = Periodicity)
-	bool bIsEffectExecutionPeriodic;
+	/** 效果下一次周期性执行的世界时间 */
+	double NextPeriodicTime = 0.0;
 
-	/** 效果的周期间隔时间，尽在周期性策略为“true”时起作用 */
-	UPROPERTY(EditDefaultsOnly, Category = Periodicity, Meta = (EditCondition = "bIsEffectExecutionPeriodic == true"))
-	float PeriodicInterval;
+	/** 效果的周期性执行在调度器中的事件序号，为0时周期性执行没有在计时 */
+	uint64 PeriodicityEventSerial = 0;
 
-	/** 效果的周期时间计时器句柄 */
-	UPROPERTY()
-	FTimerHandle PeriodicityTimer;
+	/** 周期性执行被暂停时距离下一次执行的剩余时间，小于0时没有被暂停 */
+	double PeriodicityPausedRemaining = -1.0;
+
+	/** 当前这次执行合并的周期数 */
+	int32 ExecutingPeriodCount = 1;
 
 #pragma endregion
 
@@ -116,6 +514,9 @@ protected:
 	UFUNCTION()
 	virtual void AddEffectStack(int32 StackCountToAdd);
 
+	/** 效果是否已满堆叠且拒绝新的堆叠 */
+	bool IsNewStackingDenied() const;
+
 	/** 蓝图端实现的增加该效果的堆叠数 */
 	UFUNCTION(BlueprintImplementableEvent, Category = "FireflyAbilitySystem|Effect", Meta = (DisplayName = "AddEffectStack"))
 	void ReceiveAddEffectStack(int32 StackCountToAdd);
@@ -137,38 +538,6 @@ protected:
 	void ReceiveExecuteEffectStackOverflow();
 
 protected:
-	/** 该效果选择的堆叠策略 */
-	UPROPERTY(EditDefaultsOnly, Category = Stacking)
-	EFireflyEffectStackingPolicy StackingPolicy;
-
-	/** 效果的堆叠量上限，仅在堆叠策略为“StackHasLimit”时起作用 */
-	UPROPERTY(EditDefaultsOnly, Category = Stacking, Meta = (EditCondition = "StackingPolicy == EFireflyEffectStackingPolicy::StackHasLimit"))
-	int32 StackingLimitation;
-
-	/** 效果有新的实例被执行或堆叠数量增加时，是否刷新持续时间 */
-	UPROPERTY(EditDefaultsOnly, Category = Stacking)
-	bool bShouldRefreshDurationOnStacking;
-
-	/** 效果有新的实例被执行或堆叠数量增加时，是否重置周期性 */
-	UPROPERTY(EditDefaultsOnly, Category = Stacking)
-	bool bShouldResetPeriodicityOnStacking;
-
-	/** 效果的堆叠数达到上限时，触发的额外的效果 */
-	UPROPERTY(EditDefaultsOnly, Category = Stacking)
-	TArray<TSubclassOf<UFireflyEffect>> OverflowEffects;
-
-	/** 效果的堆叠数达到上限时，是否拒绝新的堆叠应用 */
-	UPROPERTY(EditDefaultsOnly, Category = Stacking)
-	bool bDenyNewStackingOnOverflow;
-
-	/** 效果的堆叠数达到上限时，是否清除所有的堆叠数 */
-	UPROPERTY(EditDefaultsOnly, Category = Stacking)
-	bool bClearStackingOnOverflow;
-
-	/** 堆叠到期策略，即效果的持续时间的到期对堆叠的影响 */
-	UPROPERTY(EditDefaultsOnly, Category = Stacking)
-	EFireflyEffectDurationPolicyOnStackingExpired StackingExpirationPolicy;
-
 	/** 效果的堆叠数 */
 	UPROPERTY()
 	int32 StackCount;
@@ -179,13 +548,15 @@ protected:
 #pragma region Modifiers 属性修改器
 
 protected:
-	/** 该效果携带的属性修改器 */
-	UPROPERTY(EditDefaultsOnly, Category = Modifier)
-	TArray<FFireflyEffectModifierData> Modifiers;
+	/** 该效果应用到目标属性上的修改器的句柄，与Modifiers一一对应 */
+	UPROPERTY()
+	TArray<FFireflyModifierHandle> ModifierHandles;
 
-	/** 该效果携带的特殊属性 */
-	UPROPERTY(EditDefaultsOnly, Category = Modifier)
-	TArray<FFireflySpecificProperty> SpecificProperties;
+	/** 通过句柄移除该效果应用的所有属性修改器 */
+	void RemoveAppliedModifiers(UFireflyAbilitySystemComponent* Manager);
+
+	/** 通过句柄将该效果应用的所有属性修改器的堆叠数同步为效果的堆叠数 */
+	void SyncAppliedModifierStacks();
 
 #pragma endregion
 
@@ -213,6 +584,12 @@ protected:
 	UFUNCTION(BlueprintImplementableEvent, Category = "FireflyAbilitySystem|Effect", Meta = (DisplayName = "Execute Effect"))
 	void ReceiveExecuteEffect();
 
+	/** 效果类型是否在原生子类或蓝图中重写了执行逻辑，重写的逻辑需要效果实例，且每次执行都要触发 */
+	static bool HasCustomExecuteLogic(const UClass* EffectClass);
+
+	/** 计算修改器本次执行使用的操作值 */
+	float CalculateModifierValueToUse(const FFireflyEffectModifierData& Modifier);
+
 	/** 效果持续时间到期时执行的逻辑 */
 	UFUNCTION()
 	virtual void ExecuteEffectExpiration();
@@ -239,10 +616,6 @@ public:
 	FORCEINLINE AActor* GetTarget() const { return Target; }
 
 protected:
-	/** 该效果携带的特殊属性 */
-	UPROPERTY(EditDefaultsOnly, Category = Instancing)
-	EFireflyEffectInstigatorApplicationPolicy InstigatorApplicationPolicy;
-
 	/** 效果执行的发起者 */
 	UPROPERTY()
 	TArray<AActor*> Instigators;
@@ -254,12 +627,31 @@ protected:
 #pragma endregion
 
 
+#pragma region Pooling 实例池化
+
+protected:
+	/** 效果实例被放回实例池前，取消调度事件和计时器，并将运行时属性恢复为默认对象的值，重新引用类型的共享定义 */
+	void ResetEffectInstance();
+
+protected:
+	/** 效果结束后是否允许其实例被管理器回收复用，蓝图中保存了额外状态或被外部长期引用的效果不应开启 */
+	UPROPERTY(EditDefaultsOnly, Category = Instancing)
+	bool bAllowInstancePooling = false;
+
+	/** 效果实例当前是否在管理器的实例池中 */
+	bool bIsInInstancePool = false;
+
+#pragma endregion
+
+
 #pragma region TagRequirement 应用条件
 
 protected:
-	/** 当拥有者的管理器的TagContainer更新时触发的代理 */
-	UFUNCTION()
-	void OnOwnerTagContainerUpdated(FGameplayTagContainer OwnerTagContainer);
+	/** 效果是否有持续生效条件 */
+	bool HasOngoingRequirement() const;
+
+	/** 持续生效条件引用的Tag在管理器中出现或消失时，重新检验效果是否生效 */
+	void EvaluateOngoingRequirement();
 
 	/** 切换效果运行时的生效和暂时无效 */
 	UFUNCTION()
@@ -270,41 +662,12 @@ protected:
 	void ExecuteEffectTagRequirementToOwner(bool bIsApplied);
 
 protected:
-	/** 效果的标签Tags，仅用于描述修饰效果资产 */
-	UPROPERTY(EditDefaultsOnly, Category = Tags)
-	FGameplayTagContainer TagsForEffectAsset;
-
-	/** 效果被应用时，会应用给管理器组件的Tags */
-	UPROPERTY(EditDefaultsOnly, Category = Tags)
-	FGameplayTagContainer TagsApplyToOwnerOnApplied;
-
-	/** 效果被应用时，管理器组件需要拥有这些Tags，该效果才能真的起作用 */
-	UPROPERTY(EditDefaultsOnly, Category = Tags)
-	FGameplayTagContainer TagsRequiredOngoing;
-
-	/** 效果被应用时，管理器组件需要没有这些Tags，该效果才能真的起作用 */
-	UPROPERTY(EditDefaultsOnly, Category = Tags)
-	FGameplayTagContainer TagsBlockedOngoing;
-
-	/** 该效果的激活应用会取消带有这些资产标记Tags的效果的应用 */
-	UPROPERTY(EditDefaultsOnly, Category = Tags)
-	FGameplayTagContainer TagsOfEffectsWillBeRemoved;
-
-	/** 该效果的激活应用会阻断带有这些资产标记Tags的效果的应用 */
-	UPROPERTY(EditDefaultsOnly, Category = Tags)
-	FGameplayTagContainer TagsOfEffectsWillBeBlocked;
-
-	/** 该效果的激活应用需要管理器含有如下Tags */
-	UPROPERTY(EditDefaultsOnly, Category = Tags)
-	FGameplayTagContainer TagsRequireOwnerHasForApplication;
-
-	/** 该效果的激活应用期望管理器不含如下Tags */
-	UPROPERTY(EditDefaultsOnly, Category = Tags)
-	FGameplayTagContainer TagsBlockApplicationOnOwnerHas;
-
 	/** 该效果在运行时是否处于生效状态 */
 	UPROPERTY()
 	bool bOngoingEffective = true;
 
+	/** 效果是否已登记到管理器的持续生效条件索引中 */
+	bool bOngoingRequirementRegistered = false;
+
 #pragma endregion	
 };
@@ -17,12 +17,20 @@ class FIREFLYABILITYSYSTEM_API UFireflyEffectModifierCalculator : public UObject
 public:
 	virtual UWorld* GetWorld() const override;
 
+	virtual void PostInitProperties() override;
+
 public:
 	/** 执行该计算器 */
 	UFUNCTION(BlueprintNativeEvent, Category = "FireflyAbilitySystem")
 	float CalculateModifierValue(UFireflyEffect* EffectInstance, float OriginModValue);
 
+	/** 执行该计算器，计算器的类没有在蓝图中重写计算逻辑时直接调用原生实现，不经过蓝图事件的调用 */
+	float Calculate(UFireflyEffect* EffectInstance, float OriginModValue);
+
 protected:
+	/** 计算器的类是否在蓝图中重写了计算逻辑 */
+	bool bHasBlueprintCalculate = false;
+
 	/** 是否每次计算都获取Instigator和Target的最新数值 */
 	UPROPERTY(EditDefaultsOnly)
 	bool bUpdateUsingAttribute = true;
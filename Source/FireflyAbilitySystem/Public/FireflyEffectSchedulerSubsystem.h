@@ -0,0 +1,148 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FireflyEffectSchedulerSubsystem.generated.h"
+
+class UFireflyEffect;
+
+/** 效果调度事件的类型 */
+enum class EFireflyScheduledEffectEventType : uint8
+{
+	/** 效果的持续时间到期 */
+	Expiration,
+	/** 效果的周期性执行 */
+	Periodicity
+};
+
+/** 效果调度器中的一个事件 */
+struct FFireflyScheduledEffectEvent
+{
+	/** 事件触发的世界时间 */
+	double FireTime = 0.0;
+
+	/** 事件的序号，与效果当前记录的序号不一致时，事件已被取消或重新调度 */
+	uint64 Serial = 0;
+
+	/** 事件所属的效果 */
+	TWeakObjectPtr<UFireflyEffect> Effect;
+
+	/** 事件的类型 */
+	EFireflyScheduledEffectEventType EventType = EFireflyScheduledEffectEventType::Expiration;
+
+	FFireflyScheduledEffectEvent() {}
+
+	FFireflyScheduledEffectEvent(double InFireTime, uint64 InSerial, UFireflyEffect* InEffect, EFireflyScheduledEffectEventType InEventType)
+		: FireTime(InFireTime), Serial(InSerial), Effect(InEffect), EventType(InEventType) {}
+
+	/** 按触发时间排序，同一时间到期事件先于周期性执行事件触发，使恰好落在到期时间上的周期不执行，其余按序号排序，保证触发顺序确定 */
+	FORCEINLINE bool operator<(const FFireflyScheduledEffectEvent& Other) const
+	{
+		if (FireTime != Other.FireTime)
+		{
+			return FireTime < Other.FireTime;
+		}
+
+		if (EventType != Other.EventType)
+		{
+			return EventType == EFireflyScheduledEffectEventType::Expiration;
+		}
+
+		return Serial < Other.Serial;
+	}
+};
+
+/** 效果调度器，以最小堆统一管理世界中所有效果的持续时间和周期性执行，每帧批量触发到期的事件
+ * 事件按触发时间、类型和序号的顺序触发，开启固定步长时只在全局步长网格的边界上触发，使执行顺序可以回放 */
+UCLASS()
+class FIREFLYABILITYSYSTEM_API UFireflyEffectSchedulerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+#pragma region Override 基类重载
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override;
+
+	virtual TStatId GetStatId() const override;
+
+#pragma endregion
+
+
+#pragma region Scheduling 调度
+
+public:
+	/** 调度器使用的当前世界时间，开启固定步长时向下对齐到最近的步长边界 */
+	double GetSchedulerTime() const;
+
+	/** 调度器是否按固定步长推进 */
+	FORCEINLINE bool IsFixedStep() const { return FixedStep > 0.0; }
+
+	/** 从现在起经过Delay后触发效果的持续时间到期，Delay不大于0时取消持续时间的计时 */
+	void ScheduleEffectExpiration(UFireflyEffect* Effect, float Delay);
+
+	/** 取消效果的持续时间的计时 */
+	void CancelEffectExpiration(UFireflyEffect* Effect);
+
+	/** 从现在起每经过Interval触发一次效果的周期性执行，Interval不大于0时取消周期性执行 */
+	void ScheduleEffectPeriodicity(UFireflyEffect* Effect, float Interval);
+
+	/** 取消效果的周期性执行 */
+	void CancelEffectPeriodicity(UFireflyEffect* Effect);
+
+	/** 暂停效果的周期性执行，保留距离下一次执行的剩余时间 */
+	void PauseEffectPeriodicity(UFireflyEffect* Effect);
+
+	/** 恢复被暂停的效果的周期性执行 */
+	void UnPauseEffectPeriodicity(UFireflyEffect* Effect);
+
+	/** 取消效果的所有调度事件 */
+	void CancelAllEffectEvents(UFireflyEffect* Effect);
+
+	/** 最小堆中的事件数，包含尚未剔除的失效事件 */
+	FORCEINLINE int32 GetNumScheduledEvents() const { return EventHeap.Num(); }
+
+	/** 最小堆中已失效但尚未剔除的事件数 */
+	FORCEINLINE int32 GetNumStaleEvents() const { return NumStaleEvents; }
+
+protected:
+	/** 将一个事件压入最小堆 */
+	void PushEvent(UFireflyEffect* Effect, double FireTime, uint64 Serial, EFireflyScheduledEffectEventType EventType);
+
+	/** 记录一个被取消的事件，失效事件过多时压缩最小堆 */
+	void MarkEventStale();
+
+	/** 事件是否仍然有效 */
+	static bool IsEventValid(const FFireflyScheduledEffectEvent& Event);
+
+	/** 触发所有已经到期的事件 */
+	void FireDueEvents(double Now);
+
+protected:
+	/** 按触发时间排序的事件最小堆，被取消的事件不会立即删除，在出堆时丢弃 */
+	TArray<FFireflyScheduledEffectEvent> EventHeap;
+
+	/** 下一个事件的序号，序号从1开始，0表示效果没有被调度 */
+	uint64 NextEventSerial = 1;
+
+	/** 最小堆中已失效的事件数 */
+	int32 NumStaleEvents = 0;
+
+	/** 固定步长，不大于0时按帧推进 */
+	double FixedStep = 0.0;
+
+	/** 是否将错过的多个周期合并为一次执行 */
+	bool bCoalesceMissedPeriods = false;
+
+#pragma endregion
+};
@@ -0,0 +1,80 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+/** 以稠密位索引表示的一组Tag，位索引由FFireflyGameplayTagBitRegistry统一分配，Tag判定只需按字进行与运算和比较 */
+struct FIREFLYABILITYSYSTEM_API FFireflyGameplayTagBits
+{
+	/** 每个位对应一个Tag的位索引，未分配到的高位视为0 */
+	TArray<uint64, TInlineAllocator<2>> Words;
+
+	FFireflyGameplayTagBits() {}
+
+	/** 设置某个位索引 */
+	void SetBit(int32 BitIndex);
+
+	/** 清除某个位索引 */
+	void ClearBit(int32 BitIndex);
+
+	/** 是否含有某个位索引 */
+	bool HasBit(int32 BitIndex) const;
+
+	/** 是否与另一组Tag有交集，Other为空时返回false */
+	bool HasAny(const FFireflyGameplayTagBits& Other) const;
+
+	/** 是否包含另一组Tag的所有位，Other为空时返回true */
+	bool HasAll(const FFireflyGameplayTagBits& Other) const;
+
+	/** 是否不含任何位 */
+	bool IsEmpty() const;
+
+	/** 清除所有位，保留内存 */
+	void Reset() { Words.Reset(); }
+
+	/** 按从低到高的顺序对每个被设置的位索引调用Func */
+	template<typename FuncType>
+	void ForEachSetBit(FuncType&& Func) const
+	{
+		for (int32 WordIndex = 0; WordIndex < Words.Num(); ++WordIndex)
+		{
+			for (uint64 Word = Words[WordIndex]; Word; Word &= Word - 1)
+			{
+				Func(WordIndex * 64 + static_cast<int32>(FMath::CountTrailingZeros64(Word)));
+			}
+		}
+	}
+
+	FFireflyGameplayTagBits& operator|=(const FFireflyGameplayTagBits& Other);
+
+	/** 只包含容器中显式添加的Tag，与HasTagExact、HasAnyExact、HasAllExact等精确判定对应，也作为非精确判定中的查询方 */
+	static FFireflyGameplayTagBits MakeExact(const FGameplayTagContainer& Tags);
+
+	/** 包含容器中的Tag及其所有父级Tag，作为HasAll、HasAny等非精确判定中的被查询方 */
+	static FFireflyGameplayTagBits MakeWithParents(const FGameplayTagContainer& Tags);
+};
+
+/** Tag到稠密位索引的注册表，只为插件实际用到的Tag及其父级Tag在第一次使用时分配位索引，位集合的长度与项目中Tag的总数无关 */
+class FIREFLYABILITYSYSTEM_API FFireflyGameplayTagBitRegistry
+{
+public:
+	static FFireflyGameplayTagBitRegistry& Get();
+
+	/** 获取Tag的位索引，尚未分配时分配新的位索引，无效的Tag返回INDEX_NONE */
+	int32 FindOrAddBitIndex(const FGameplayTag& Tag);
+
+	/** 获取Tag及其所有父级Tag的位集合 */
+	const FFireflyGameplayTagBits& GetTagAndParentBits(const FGameplayTag& Tag);
+
+	/** 已分配的位索引数 */
+	int32 Num() const { return TagBitIndices.Num(); }
+
+private:
+	/** Tag到位索引的映射 */
+	TMap<FGameplayTag, int32> TagBitIndices;
+
+	/** 按位索引排列的Tag及其所有父级Tag的位集合 */
+	TArray<FFireflyGameplayTagBits> TagAndParentBits;
+};
@@ -0,0 +1,63 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "FireflyReplicatedTagCount.generated.h"
+
+class UFireflyAbilitySystemComponent;
+struct FFireflyReplicatedTagCountContainer;
+
+/** 某个Tag在服务端的堆叠数，Tag以网络索引同步，客户端单独记录同步的堆叠数 */
+USTRUCT()
+struct FIREFLYABILITYSYSTEM_API FFireflyReplicatedTagCountEntry : public FFastArraySerializerItem
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	void PreReplicatedRemove(const FFireflyReplicatedTagCountContainer& InArraySerializer);
+
+	void PostReplicatedAdd(const FFireflyReplicatedTagCountContainer& InArraySerializer);
+
+	void PostReplicatedChange(const FFireflyReplicatedTagCountContainer& InArraySerializer);
+
+	/** 同步的Tag */
+	UPROPERTY()
+	FGameplayTag Tag;
+
+	/** Tag在服务端的堆叠数 */
+	UPROPERTY()
+	int32 Count = 0;
+};
+
+/** 技能管理器中所有Tag堆叠数的容器，以FastArray的形式增量同步，只有堆叠数改变的记录会被发送 */
+USTRUCT()
+struct FIREFLYABILITYSYSTEM_API FFireflyReplicatedTagCountContainer : public FFastArraySerializer
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FFireflyReplicatedTagCountEntry, FFireflyReplicatedTagCountContainer>(Items, DeltaParms, *this);
+	}
+
+	/** 所有Tag堆叠数的记录 */
+	UPROPERTY()
+	TArray<FFireflyReplicatedTagCountEntry> Items;
+
+	/** 容器所属的技能管理器 */
+	UPROPERTY(NotReplicated)
+	UFireflyAbilitySystemComponent* Owner = nullptr;
+};
+
+template<>
+struct TStructOpsTypeTraits<FFireflyReplicatedTagCountContainer> : public TStructOpsTypeTraitsBase2<FFireflyReplicatedTagCountContainer>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
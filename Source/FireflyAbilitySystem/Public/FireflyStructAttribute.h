@@ -0,0 +1,113 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireflyAttribute.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "FireflyStructAttribute.generated.h"
+
+class UFireflyAbilitySystemComponent;
+struct FFireflyStructAttributeContainer;
+
+/** 以结构体的形式存储在技能管理器中的属性，不创建UObject，适用于大量只使用默认计算逻辑的简单NPC */
+USTRUCT()
+struct FIREFLYABILITYSYSTEM_API FFireflyStructAttribute : public FFastArraySerializerItem
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	/** 从属性类的默认对象中复制属性的类型和夹值设置 */
+	void InitializeFromTemplate(const UFireflyAttribute* Template);
+
+	/** 获取该属性的当前值所依赖的所有源属性类型 */
+	void GetDependencySourceTypes(TArray<EFireflyAttributeType, TInlineAllocator<4>>& OutSourceTypes) const;
+
+	/** 将某个值夹在属性的值域中 */
+	float ClampValue(float InValue, const UFireflyAbilitySystemComponent* Manager) const;
+
+	/** 检测某个值是否在该属性的夹值范围中 */
+	bool IsValueInAttributeRange(float InValue, const UFireflyAbilitySystemComponent* Manager) const;
+
+	/** 获取属性的基础值或内部覆盖修改器的最新值 */
+	FORCEINLINE float GetBaseValueToUse() const { return Modifiers.GetBaseValueToUse(BaseValue); }
+
+	void PostReplicatedAdd(const FFireflyStructAttributeContainer& InArraySerializer);
+
+	void PostReplicatedChange(const FFireflyStructAttributeContainer& InArraySerializer);
+
+	/** 属性名 */
+	UPROPERTY()
+	TEnumAsByte<EFireflyAttributeType> AttributeType = AttributeType_Default;
+
+	/** 属性的基础值 */
+	UPROPERTY()
+	float BaseValue = 0.f;
+
+	/** 属性的当前值 */
+	UPROPERTY()
+	float CurrentValue = 0.f;
+
+	/** 如果为true，则属性值至少不能小于 LessBaseValue */
+	UPROPERTY(NotReplicated)
+	bool bAttributeMustNotLessThanSelection = true;
+
+	/** bAttributeMustMoreNotLessThanSelection为true时，属性不会小于该值 */
+	UPROPERTY(NotReplicated)
+	float LessBaseValue = 0.f;
+
+	/** 属性是否需要夹值 */
+	UPROPERTY(NotReplicated)
+	bool bAttributeHasRange = false;
+
+	/** 属性的范围最小值 */
+	UPROPERTY(NotReplicated)
+	float RangeMinValue = 0.f;
+
+	/** 属性的范围最大值 */
+	UPROPERTY(NotReplicated)
+	float RangeMaxValue = 0.f;
+
+	/** 属性的范围最大值属性类型 */
+	UPROPERTY(NotReplicated)
+	TEnumAsByte<EFireflyAttributeType> RangeMaxValueType = AttributeType_Default;
+
+	/** 客户端最近一次收到同步时的基础值，用于广播基础值的变化 */
+	float ReplicatedBaseValue = 0.f;
+
+	/** 客户端最近一次收到同步时的当前值，用于广播当前值的变化 */
+	float ReplicatedCurrentValue = 0.f;
+
+	/** 作用于该属性的所有修改器，仅存在于拥有权限端，由技能管理器维持修改器来源的引用 */
+	FFireflyAttributeModifierContainer Modifiers;
+};
+
+/** 技能管理器中所有结构体属性的容器，以FastArray的形式增量同步属性的基础值和当前值 */
+USTRUCT()
+struct FIREFLYABILITYSYSTEM_API FFireflyStructAttributeContainer : public FFastArraySerializer
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FFireflyStructAttribute, FFireflyStructAttributeContainer>(Items, DeltaParms, *this);
+	}
+
+	/** 所有结构体属性 */
+	UPROPERTY()
+	TArray<FFireflyStructAttribute> Items;
+
+	/** 容器所属的技能管理器 */
+	UPROPERTY(NotReplicated)
+	UFireflyAbilitySystemComponent* Owner = nullptr;
+};
+
+template<>
+struct TStructOpsTypeTraits<FFireflyStructAttributeContainer> : public TStructOpsTypeTraitsBase2<FFireflyStructAttributeContainer>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
@@ -0,0 +1,47 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "FireflyAbilitySystemComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+/** 自动化测试期间存在的游戏世界，世界时间由测试手动推进，析构时销毁 */
+struct FFireflyAutomationTestWorld
+{
+	FFireflyAutomationTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->TimeSeconds = 0.0;
+	}
+
+	~FFireflyAutomationTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	FFireflyAutomationTestWorld(const FFireflyAutomationTestWorld&) = delete;
+	FFireflyAutomationTestWorld& operator=(const FFireflyAutomationTestWorld&) = delete;
+
+	/** 生成一个拥有权限的Actor，并为其注册技能系统组件 */
+	UFireflyAbilitySystemComponent* SpawnAbilitySystem() const
+	{
+		AActor* Actor = World->SpawnActor<AActor>();
+		UFireflyAbilitySystemComponent* AbilitySystem = NewObject<UFireflyAbilitySystemComponent>(Actor);
+		AbilitySystem->RegisterComponent();
+
+		return AbilitySystem;
+	}
+
+	UWorld* World = nullptr;
+};
+
+#endif
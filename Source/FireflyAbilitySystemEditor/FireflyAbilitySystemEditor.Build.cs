@@ -40,6 +40,7 @@ public class FireflyAbilitySystemEditor : ModuleRules
 				"SlateCore",
                 "FireflyAbilitySystem",
                 "UnrealEd",
+                "BlueprintGraph",
                 "EditorStyle",
                 "DeveloperSettings",
 				// ... add private dependencies that you statically link with here ...	
@@ -0,0 +1,575 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyEffectSchedulerTestEffect.h"
+
+#include "FireflyAbilitySystemComponent.h"
+#include "FireflyAbilitySystemSettings.h"
+#include "Tests/FireflyAutomationTestWorld.h"
+#include "FireflyEffectSchedulerSubsystem.h"
+#include "Engine/Blueprint.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "K2Node_Event.h"
+#include "Kismet2/BlueprintEditorUtils.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+UFireflyEffectSchedulerTestEffect::UFireflyEffectSchedulerTestEffect(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	if (!HasAnyFlags(RF_ClassDefaultObject))
+	{
+		return;
+	}
+
+	/** 配置保存在该类型的稀疏类数据中，只需在默认对象构造时设置 */
+	FFireflyEffectSparseClassData* ClassData = static_cast<FFireflyEffectSparseClassData*>(GetClass()->GetOrCreateSparseClassData());
+	ClassData->DurationPolicy = EFireflyEffectDurationPolicy::HasDuration;
+	ClassData->Duration = 2.f;
+	ClassData->bIsEffectExecutionPeriodic = true;
+	ClassData->PeriodicInterval = 1.f;
+}
+
+void UFireflyEffectSchedulerTestEffect::ExecuteEffect()
+{
+	++NumExecutions;
+	NumExecutedPeriods += ExecutingPeriodCount;
+}
+
+void UFireflyEffectSchedulerTestEffect::ExecuteEffectExpiration()
+{
+	++NumExpirations;
+
+	/** 与效果结束时一致，到期后不再周期性执行 */
+	if (UFireflyEffectSchedulerSubsystem* Scheduler = GetEffectScheduler())
+	{
+		Scheduler->CancelEffectPeriodicity(this);
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FireflyEffectSchedulerTest
+{
+	/** 在调度器被创建前临时修改调度设置，析构时还原 */
+	struct FScopedSchedulerSettings
+	{
+		explicit FScopedSchedulerSettings(bool bCoalesceMissedPeriods)
+		{
+			UFireflyAbilitySystemSettings* Settings = UFireflyAbilitySystemSettings::Get();
+			bOldUseFixedStep = Settings->bUseFixedStepEffectScheduling;
+			bOldCoalesceMissedPeriods = Settings->bCoalesceMissedEffectPeriods;
+			Settings->bUseFixedStepEffectScheduling = false;
+			Settings->bCoalesceMissedEffectPeriods = bCoalesceMissedPeriods;
+		}
+
+		~FScopedSchedulerSettings()
+		{
+			UFireflyAbilitySystemSettings* Settings = UFireflyAbilitySystemSettings::Get();
+			Settings->bUseFixedStepEffectScheduling = bOldUseFixedStep;
+			Settings->bCoalesceMissedEffectPeriods = bOldCoalesceMissedPeriods;
+		}
+
+		bool bOldUseFixedStep = false;
+
+		bool bOldCoalesceMissedPeriods = false;
+	};
+
+	/** 测试期间存在的游戏世界，按指定的设置创建效果调度器 */
+	struct FScopedSchedulerWorld
+	{
+		explicit FScopedSchedulerWorld(bool bCoalesceMissedPeriods)
+			: Settings(bCoalesceMissedPeriods)
+		{
+			World = TestWorld.World;
+			Scheduler = World->GetSubsystem<UFireflyEffectSchedulerSubsystem>();
+		}
+
+		UFireflyEffectSchedulerTestEffect* NewEffect() const
+		{
+			return NewObject<UFireflyEffectSchedulerTestEffect>(World);
+		}
+
+		UFireflyAbilitySystemComponent* SpawnAbilitySystem() const
+		{
+			return TestWorld.SpawnAbilitySystem();
+		}
+
+		/** 生成技能系统组件，并构建一个初始值为InitValue的属性 */
+		UFireflyAbilitySystemComponent* SpawnAbilitySystemWithAttribute(EFireflyAttributeType AttributeType, float InitValue) const
+		{
+			UFireflyAbilitySystemComponent* AbilitySystem = SpawnAbilitySystem();
+			FFireflyAttributeConstructor Constructor;
+			Constructor.AttributeType = AttributeType;
+			AbilitySystem->ConstructAttributeByConstructor(Constructor);
+			AbilitySystem->InitializeAttributeByType(AttributeType, InitValue);
+
+			return AbilitySystem;
+		}
+
+		/** 将世界时间推进到Time，并触发所有到期的事件 */
+		void AdvanceTo(double Time) const
+		{
+			World->TimeSeconds = Time;
+			Scheduler->Tick(0.f);
+		}
+
+		/** 先于世界构造，世界析构后还原 */
+		FScopedSchedulerSettings Settings;
+
+		FFireflyAutomationTestWorld TestWorld;
+
+		UWorld* World = nullptr;
+
+		UFireflyEffectSchedulerSubsystem* Scheduler = nullptr;
+	};
+
+	/** 每秒执行一次、每次使属性加10的周期性效果，只有一个修改器，可以合并多个周期 */
+	FFireflyEffectDynamicConstructor MakePeriodicPlusEffect(EFireflyAttributeType AttributeType, float Duration)
+	{
+		FFireflyEffectDynamicConstructor EffectSetup;
+		EffectSetup.DurationPolicy = EFireflyEffectDurationPolicy::HasDuration;
+		EffectSetup.Duration = Duration;
+		EffectSetup.bIsEffectExecutionPeriodic = true;
+		EffectSetup.PeriodicInterval = 1.f;
+
+		FFireflyEffectModifierData Modifier;
+		Modifier.AttributeType = AttributeType;
+		Modifier.ModOperator = EFireflyAttributeModOperator::Plus;
+		Modifier.ModValue = 10.f;
+		EffectSetup.Modifiers.Add(Modifier);
+
+		return EffectSetup;
+	}
+
+	/** 编译一个在事件图表中实现了Execute Effect事件的效果蓝图，返回其生成的类 */
+	UClass* CompileScriptHookedEffectClass()
+	{
+		UPackage* Package = GetTransientPackage();
+		UBlueprint* Blueprint = FKismetEditorUtilities::CreateBlueprint(UFireflyEffect::StaticClass(), Package,
+			MakeUniqueObjectName(Package, UBlueprint::StaticClass(), TEXT("FireflyScriptHookedEffect")),
+			BPTYPE_Normal, UBlueprint::StaticClass(), UBlueprintGeneratedClass::StaticClass());
+
+		UEdGraph* EventGraph = FBlueprintEditorUtils::FindEventGraph(Blueprint);
+		UK2Node_Event* EventNode = NewObject<UK2Node_Event>(EventGraph);
+		EventNode->EventReference.SetExternalMember(TEXT("ReceiveExecuteEffect"), UFireflyEffect::StaticClass());
+		EventNode->bOverrideFunction = true;
+		EventGraph->AddNode(EventNode, false, false);
+		EventNode->CreateNewGuid();
+		EventNode->PostPlacedNewNode();
+		EventNode->AllocateDefaultPins();
+
+		FKismetEditorUtilities::CompileBlueprint(Blueprint, EBlueprintCompileOptions::SkipGarbageCollection);
+
+		return Blueprint->GeneratedClass;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyEffectSchedulerExpirationTest, "FireflyAbilitySystem.EffectScheduler.ExpirationAndRefresh",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyEffectSchedulerExpirationTest::RunTest(const FString& Parameters)
+{
+	FireflyEffectSchedulerTest::FScopedSchedulerWorld TestWorld(false);
+	if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+	{
+		return false;
+	}
+
+	UFireflyEffectSchedulerTestEffect* Effect = TestWorld.NewEffect();
+	TestWorld.Scheduler->ScheduleEffectExpiration(Effect, 2.f);
+
+	TestWorld.AdvanceTo(1.5);
+	TestEqual(TEXT("Expirations before the duration elapses"), Effect->NumExpirations, 0);
+
+	/** 刷新持续时间后，旧的到期事件失效 */
+	TestWorld.Scheduler->ScheduleEffectExpiration(Effect, 2.f);
+	TestEqual(TEXT("Stale events after refresh"), TestWorld.Scheduler->GetNumStaleEvents(), 1);
+
+	TestWorld.AdvanceTo(2.5);
+	TestEqual(TEXT("Expirations at the original expiry time"), Effect->NumExpirations, 0);
+	TestTrue(TEXT("Expiration is still scheduled after refresh"), Effect->IsExpirationScheduled());
+
+	TestWorld.AdvanceTo(3.5);
+	TestEqual(TEXT("Expirations at the refreshed expiry time"), Effect->NumExpirations, 1);
+	TestFalse(TEXT("Expiration is cleared after firing"), Effect->IsExpirationScheduled());
+
+	/** 被取消的到期事件不再触发 */
+	TestWorld.Scheduler->ScheduleEffectExpiration(Effect, 1.f);
+	TestWorld.Scheduler->CancelEffectExpiration(Effect);
+	TestWorld.AdvanceTo(10.0);
+	TestEqual(TEXT("Expirations after cancel"), Effect->NumExpirations, 1);
+	TestEqual(TEXT("Scheduled events after all events fired or were discarded"), TestWorld.Scheduler->GetNumScheduledEvents(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyEffectSchedulerPauseTest, "FireflyAbilitySystem.EffectScheduler.PauseAndResume",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyEffectSchedulerPauseTest::RunTest(const FString& Parameters)
+{
+	FireflyEffectSchedulerTest::FScopedSchedulerWorld TestWorld(false);
+	if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+	{
+		return false;
+	}
+
+	UFireflyEffectSchedulerTestEffect* Effect = TestWorld.NewEffect();
+	TestWorld.Scheduler->ScheduleEffectPeriodicity(Effect, 1.f);
+
+	/** 暂停时保留距离下一次执行的剩余时间 */
+	TestWorld.AdvanceTo(0.25);
+	TestWorld.Scheduler->PauseEffectPeriodicity(Effect);
+
+	TestWorld.AdvanceTo(5.0);
+	TestEqual(TEXT("Executions while paused"), Effect->NumExecutions, 0);
+
+	/** 恢复后从恢复时刻起经过剩余时间再执行 */
+	TestWorld.Scheduler->UnPauseEffectPeriodicity(Effect);
+	TestEqual(TEXT("Next periodic time after resume"), Effect->GetNextPeriodicTime(), 5.75);
+
+	TestWorld.AdvanceTo(5.5);
+	TestEqual(TEXT("Executions before the remaining time elapses"), Effect->NumExecutions, 0);
+
+	TestWorld.AdvanceTo(5.75);
+	TestEqual(TEXT("Executions after the remaining time elapses"), Effect->NumExecutions, 1);
+	TestEqual(TEXT("Next periodic time after execution"), Effect->GetNextPeriodicTime(), 6.75);
+
+	/** 未被暂停的效果恢复时不做任何事 */
+	TestWorld.Scheduler->UnPauseEffectPeriodicity(Effect);
+	TestEqual(TEXT("Next periodic time after a redundant resume"), Effect->GetNextPeriodicTime(), 6.75);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyEffectSchedulerCompactionTest, "FireflyAbilitySystem.EffectScheduler.StaleEventCompaction",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyEffectSchedulerCompactionTest::RunTest(const FString& Parameters)
+{
+	FireflyEffectSchedulerTest::FScopedSchedulerWorld TestWorld(false);
+	if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+	{
+		return false;
+	}
+
+	/** 大量有效事件存在时，失效事件超过1024个但不超过一半，不压缩最小堆 */
+	constexpr int32 NumLiveEffects = 1100;
+	for (int32 i = 0; i < NumLiveEffects; ++i)
+	{
+		TestWorld.Scheduler->ScheduleEffectExpiration(TestWorld.NewEffect(), 100.f);
+	}
+
+	UFireflyEffectSchedulerTestEffect* Effect = TestWorld.NewEffect();
+	TestWorld.Scheduler->ScheduleEffectExpiration(Effect, 100.f);
+
+	/** 每次刷新持续时间使上一个事件失效，第NumLiveEffects次刷新时失效事件达到一半 */
+	for (int32 i = 1; i < NumLiveEffects; ++i)
+	{
+		TestWorld.Scheduler->ScheduleEffectExpiration(Effect, 100.f);
+	}
+
+	TestEqual(TEXT("Stale events below half of the heap"), TestWorld.Scheduler->GetNumStaleEvents(), NumLiveEffects - 1);
+	TestEqual(TEXT("Scheduled events before compaction"), TestWorld.Scheduler->GetNumScheduledEvents(), NumLiveEffects * 2);
+
+	TestWorld.Scheduler->ScheduleEffectExpiration(Effect, 100.f);
+	TestEqual(TEXT("Stale events after compaction"), TestWorld.Scheduler->GetNumStaleEvents(), 0);
+	TestEqual(TEXT("Scheduled events after compaction"), TestWorld.Scheduler->GetNumScheduledEvents(), NumLiveEffects + 1);
+
+	/** 压缩后剩余的事件仍然按时触发 */
+	TestWorld.AdvanceTo(100.0);
+	TestEqual(TEXT("Expirations after compaction"), Effect->NumExpirations, 1);
+	TestEqual(TEXT("Scheduled events after all expirations"), TestWorld.Scheduler->GetNumScheduledEvents(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyEffectSchedulerScaleTest, "FireflyAbilitySystem.EffectScheduler.ManyActiveEffects",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyEffectSchedulerScaleTest::RunTest(const FString& Parameters)
+{
+	FireflyEffectSchedulerTest::FScopedSchedulerWorld TestWorld(false);
+	if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+	{
+		return false;
+	}
+
+	/** 两万个周期性效果，首次执行在0.5秒到2.25秒之间错开，之后按效果定义的1秒间隔执行 */
+	constexpr int32 NumEffects = 20000;
+	constexpr int32 NumFirstDelays = 8;
+	TArray<UFireflyEffectSchedulerTestEffect*> Effects;
+	Effects.Reserve(NumEffects);
+	for (int32 i = 0; i < NumEffects; ++i)
+	{
+		UFireflyEffectSchedulerTestEffect* Effect = TestWorld.NewEffect();
+		TestWorld.Scheduler->ScheduleEffectPeriodicity(Effect, 0.5f + 0.25f * (i % NumFirstDelays));
+		Effects.Add(Effect);
+	}
+	TestEqual(TEXT("Scheduled events"), TestWorld.Scheduler->GetNumScheduledEvents(), NumEffects);
+
+	/** 以每帧0.125秒推进5秒 */
+	const double StartSeconds = FPlatformTime::Seconds();
+	constexpr int32 NumFrames = 40;
+	for (int32 Frame = 1; Frame <= NumFrames; ++Frame)
+	{
+		TestWorld.AdvanceTo(Frame * 0.125);
+	}
+	AddInfo(FString::Printf(TEXT("Fired the events of %d effects over %d frames in %.2f ms"),
+		NumEffects, NumFrames, (FPlatformTime::Seconds() - StartSeconds) * 1000.0));
+
+	/** 每个效果都逐周期执行，最小堆中始终只有每个效果的下一次事件 */
+	int32 NumMismatchedEffects = 0;
+	for (int32 i = 0; i < NumEffects; ++i)
+	{
+		const double FirstDelay = 0.5 + 0.25 * (i % NumFirstDelays);
+		if (Effects[i]->NumExecutions != 1 + FMath::FloorToInt32(5.0 - FirstDelay))
+		{
+			++NumMismatchedEffects;
+		}
+	}
+	TestEqual(TEXT("Effects with unexpected execution counts"), NumMismatchedEffects, 0);
+	TestEqual(TEXT("Scheduled events after advancing"), TestWorld.Scheduler->GetNumScheduledEvents(), NumEffects);
+	TestEqual(TEXT("Stale events after advancing"), TestWorld.Scheduler->GetNumStaleEvents(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyEffectSchedulerCatchUpTest, "FireflyAbilitySystem.EffectScheduler.MissedPeriodCatchUp",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyEffectSchedulerCatchUpTest::RunTest(const FString& Parameters)
+{
+	constexpr EFireflyAttributeType AttributeType = AttributeType001;
+
+	for (const bool bCoalesceMissedPeriods : { false, true })
+	{
+		FireflyEffectSchedulerTest::FScopedSchedulerWorld TestWorld(bCoalesceMissedPeriods);
+		if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+		{
+			return false;
+		}
+
+		UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystemWithAttribute(AttributeType, 1.f);
+		AbilitySystem->ApplyEffectDynamicConstructorToOwner(nullptr, FireflyEffectSchedulerTest::MakePeriodicPlusEffect(AttributeType, 10.f));
+
+		/** 每次执行在事务结束时广播一次属性值的变化，广播次数即执行次数 */
+		int32 NumExecutions = 0;
+		AbilitySystem->GetAttributeValueChangeDelegate(AttributeType).AddLambda([&NumExecutions](EFireflyAttributeType, float, float)
+		{
+			++NumExecutions;
+		});
+
+		/** 一次卡顿错过4个周期 */
+		TestWorld.AdvanceTo(4.5);
+
+		const TCHAR* Mode = bCoalesceMissedPeriods ? TEXT("coalesced") : TEXT("per-period");
+		TestEqual(FString::Printf(TEXT("Executions (%s)"), Mode), NumExecutions, bCoalesceMissedPeriods ? 1 : 4);
+		TestEqual(FString::Printf(TEXT("Attribute value (%s)"), Mode), AbilitySystem->GetAttributeValue(AttributeType), 51.f);
+
+		/** 补齐后恢复逐周期执行 */
+		TestWorld.AdvanceTo(5.0);
+		TestEqual(FString::Printf(TEXT("Executions after catch-up (%s)"), Mode), NumExecutions, bCoalesceMissedPeriods ? 2 : 5);
+		TestEqual(FString::Printf(TEXT("Attribute value after catch-up (%s)"), Mode), AbilitySystem->GetAttributeValue(AttributeType), 61.f);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyEffectSchedulerNativeOverrideTest, "FireflyAbilitySystem.EffectScheduler.NativeExecuteOverrideNotCoalesced",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyEffectSchedulerNativeOverrideTest::RunTest(const FString& Parameters)
+{
+	FireflyEffectSchedulerTest::FScopedSchedulerWorld TestWorld(true);
+	if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+	{
+		return false;
+	}
+
+	/** 测试效果在原生子类中重写了ExecuteEffect，开启合并时也逐个周期执行 */
+	UFireflyEffectSchedulerTestEffect* Effect = TestWorld.NewEffect();
+	TestWorld.Scheduler->ScheduleEffectPeriodicity(Effect, 1.f);
+
+	/** 一次卡顿错过4个周期 */
+	TestWorld.AdvanceTo(4.5);
+	TestEqual(TEXT("Executions"), Effect->NumExecutions, 4);
+	TestEqual(TEXT("Executed periods"), Effect->NumExecutedPeriods, 4);
+	TestEqual(TEXT("Next periodic time"), Effect->GetNextPeriodicTime(), 5.0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyEffectSchedulerScriptHookTest, "FireflyAbilitySystem.EffectScheduler.ScriptExecuteHookNotCoalesced",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyEffectSchedulerScriptHookTest::RunTest(const FString& Parameters)
+{
+	constexpr EFireflyAttributeType AttributeType = AttributeType001;
+
+	UClass* ScriptClass = FireflyEffectSchedulerTest::CompileScriptHookedEffectClass();
+	if (!TestNotNull(TEXT("Script hooked effect class"), ScriptClass))
+	{
+		return false;
+	}
+	TestTrue(TEXT("Execute Effect is implemented in script"), ScriptClass->IsFunctionImplementedInScript(TEXT("ReceiveExecuteEffect")));
+
+	FireflyEffectSchedulerTest::FScopedSchedulerWorld TestWorld(true);
+	if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+	{
+		return false;
+	}
+
+	/** 蓝图实现了Execute Effect的效果每个周期都要触发蓝图逻辑，开启合并时也逐个周期执行 */
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystemWithAttribute(AttributeType, 1.f);
+	FFireflyEffectDynamicConstructor EffectSetup = FireflyEffectSchedulerTest::MakePeriodicPlusEffect(AttributeType, 10.f);
+	EffectSetup.EffectType = ScriptClass;
+	AbilitySystem->ApplyEffectDynamicConstructorToOwner(nullptr, EffectSetup);
+
+	int32 NumExecutions = 0;
+	AbilitySystem->GetAttributeValueChangeDelegate(AttributeType).AddLambda([&NumExecutions](EFireflyAttributeType, float, float)
+	{
+		++NumExecutions;
+	});
+
+	/** 一次卡顿错过4个周期 */
+	TestWorld.AdvanceTo(4.5);
+	TestEqual(TEXT("Executions"), NumExecutions, 4);
+	TestEqual(TEXT("Attribute value"), AbilitySystem->GetAttributeValue(AttributeType), 51.f);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyEffectSchedulerExpiryCapTest, "FireflyAbilitySystem.EffectScheduler.CoalescedPeriodsStopAtExpiry",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyEffectSchedulerExpiryCapTest::RunTest(const FString& Parameters)
+{
+	constexpr EFireflyAttributeType AttributeType = AttributeType001;
+
+	for (const bool bCoalesceMissedPeriods : { false, true })
+	{
+		FireflyEffectSchedulerTest::FScopedSchedulerWorld TestWorld(bCoalesceMissedPeriods);
+		if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+		{
+			return false;
+		}
+
+		UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystemWithAttribute(AttributeType, 1.f);
+		AbilitySystem->ApplyEffectDynamicConstructorToOwner(nullptr, FireflyEffectSchedulerTest::MakePeriodicPlusEffect(AttributeType, 2.5f));
+
+		/** 一次卡顿越过了到期时间，到期之后的周期不应执行 */
+		TestWorld.AdvanceTo(10.0);
+
+		const TCHAR* Mode = bCoalesceMissedPeriods ? TEXT("coalesced") : TEXT("per-period");
+		TestEqual(FString::Printf(TEXT("Attribute value after expiry (%s)"), Mode), AbilitySystem->GetAttributeValue(AttributeType), 31.f);
+		TestEqual(FString::Printf(TEXT("Scheduled events after expiry (%s)"), Mode), TestWorld.Scheduler->GetNumScheduledEvents(), 0);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyEffectSchedulerExpiryBoundaryTest, "FireflyAbilitySystem.EffectScheduler.PeriodOnExpiryBoundary",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyEffectSchedulerExpiryBoundaryTest::RunTest(const FString& Parameters)
+{
+	constexpr EFireflyAttributeType AttributeType = AttributeType001;
+
+	for (const bool bCoalesceMissedPeriods : { false, true })
+	{
+		FireflyEffectSchedulerTest::FScopedSchedulerWorld TestWorld(bCoalesceMissedPeriods);
+		if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+		{
+			return false;
+		}
+
+		UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystemWithAttribute(AttributeType, 1.f);
+		AbilitySystem->ApplyEffectDynamicConstructorToOwner(nullptr, FireflyEffectSchedulerTest::MakePeriodicPlusEffect(AttributeType, 3.f));
+
+		/** 第3个周期恰好落在到期时间上，两种执行方式都不执行该周期 */
+		TestWorld.AdvanceTo(10.0);
+
+		const TCHAR* Mode = bCoalesceMissedPeriods ? TEXT("coalesced") : TEXT("per-period");
+		TestEqual(FString::Printf(TEXT("Attribute value after expiry (%s)"), Mode), AbilitySystem->GetAttributeValue(AttributeType), 31.f);
+		TestEqual(FString::Printf(TEXT("Scheduled events after expiry (%s)"), Mode), TestWorld.Scheduler->GetNumScheduledEvents(), 0);
+	}
+
+	FireflyEffectSchedulerTest::FScopedSchedulerWorld TestWorld(false);
+	if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+	{
+		return false;
+	}
+
+	/** 到期事件晚于周期性执行事件被调度，序号更大，同一时间仍先于周期性执行触发 */
+	UFireflyEffectSchedulerTestEffect* Effect = TestWorld.NewEffect();
+	TestWorld.Scheduler->ScheduleEffectPeriodicity(Effect, 1.f);
+	TestWorld.Scheduler->ScheduleEffectExpiration(Effect, 3.f);
+
+	TestWorld.AdvanceTo(3.0);
+	TestEqual(TEXT("Expirations at the boundary"), Effect->NumExpirations, 1);
+	TestEqual(TEXT("Executed periods before the boundary"), Effect->NumExecutedPeriods, 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyEffectSchedulerScaledModifierTest, "FireflyAbilitySystem.EffectScheduler.CoalescedModifierValues",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyEffectSchedulerScaledModifierTest::RunTest(const FString& Parameters)
+{
+	constexpr EFireflyAttributeType AdditiveType = AttributeType001;
+	constexpr EFireflyAttributeType MultiplicativeType = AttributeType002;
+
+	for (const bool bCoalesceMissedPeriods : { false, true })
+	{
+		FireflyEffectSchedulerTest::FScopedSchedulerWorld TestWorld(bCoalesceMissedPeriods);
+		if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+		{
+			return false;
+		}
+
+		UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+		for (const EFireflyAttributeType AttributeType : { AdditiveType, MultiplicativeType })
+		{
+			FFireflyAttributeConstructor Constructor;
+			Constructor.AttributeType = AttributeType;
+			AbilitySystem->ConstructAttributeByConstructor(Constructor);
+			AbilitySystem->InitializeAttributeByType(AttributeType, 1.f);
+		}
+
+		/** 两个修改器作用于不同的不夹值属性，可以合并多个周期 */
+		FFireflyEffectDynamicConstructor EffectSetup;
+		EffectSetup.DurationPolicy = EFireflyEffectDurationPolicy::HasDuration;
+		EffectSetup.Duration = 10.f;
+		EffectSetup.bIsEffectExecutionPeriodic = true;
+		EffectSetup.PeriodicInterval = 1.f;
+
+		FFireflyEffectModifierData AdditiveModifier;
+		AdditiveModifier.AttributeType = AdditiveType;
+		AdditiveModifier.ModOperator = EFireflyAttributeModOperator::Plus;
+		AdditiveModifier.ModValue = 10.f;
+		EffectSetup.Modifiers.Add(AdditiveModifier);
+
+		FFireflyEffectModifierData MultiplicativeModifier;
+		MultiplicativeModifier.AttributeType = MultiplicativeType;
+		MultiplicativeModifier.ModOperator = EFireflyAttributeModOperator::Multiply;
+		MultiplicativeModifier.ModValue = 2.f;
+		EffectSetup.Modifiers.Add(MultiplicativeModifier);
+
+		/** 应用时执行一次，之后一次卡顿错过4个周期 */
+		AbilitySystem->ApplyEffectDynamicConstructorToOwner(nullptr, EffectSetup);
+		TestWorld.AdvanceTo(4.5);
+
+		/** 合并执行时加法的操作值乘以周期数，乘法的操作值取周期数次幂，结果与逐周期执行一致 */
+		const TCHAR* Mode = bCoalesceMissedPeriods ? TEXT("coalesced") : TEXT("per-period");
+		TestEqual(FString::Printf(TEXT("Additive attribute (%s)"), Mode), AbilitySystem->GetAttributeValue(AdditiveType), 51.f);
+		TestEqual(FString::Printf(TEXT("Multiplicative attribute (%s)"), Mode), AbilitySystem->GetAttributeValue(MultiplicativeType), 32.f);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,37 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireflyEffect.h"
+#include "FireflyEffectSchedulerTestEffect.generated.h"
+
+/** 效果调度器的自动化测试使用的效果，只记录被调度器触发的次数，不修改任何属性，到期时停止周期性执行 */
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class UFireflyEffectSchedulerTestEffect : public UFireflyEffect
+{
+	GENERATED_BODY()
+
+public:
+	UFireflyEffectSchedulerTestEffect(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	virtual void ExecuteEffect() override;
+
+	virtual void ExecuteEffectExpiration() override;
+
+	/** 效果下一次周期性执行的世界时间 */
+	FORCEINLINE double GetNextPeriodicTime() const { return NextPeriodicTime; }
+
+	/** 效果的持续时间是否正在计时 */
+	FORCEINLINE bool IsExpirationScheduled() const { return IsDurationTicking(); }
+
+public:
+	/** 周期性执行的次数，合并的多个周期只算一次 */
+	int32 NumExecutions = 0;
+
+	/** 执行过的周期数，合并的多个周期按周期数计算 */
+	int32 NumExecutedPeriods = 0;
+
+	/** 持续时间到期的次数 */
+	int32 NumExpirations = 0;
+};
@@ -0,0 +1,203 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireflyModifierCalculatorTestCalculator.h"
+#include "FireflyModifierCalculatorTestAbility.h"
+
+#include "FireflyAbilitySystemComponent.h"
+#include "FireflyEffect.h"
+#include "Tests/FireflyAutomationTestWorld.h"
+#include "FireflyEffectSchedulerSubsystem.h"
+#include "Misc/AutomationTest.h"
+
+int32 UFireflyModifierCalculatorTestCalculator::NumInstancesCreated = 0;
+
+UFireflyModifierCalculatorTestCalculator::UFireflyModifierCalculatorTestCalculator(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+	{
+		++NumInstancesCreated;
+	}
+}
+
+float UFireflyModifierCalculatorTestCalculator::CalculateModifierValue_Implementation(UFireflyEffect* EffectInstance, float OriginModValue)
+{
+	++NumCalculations;
+
+	return OriginModValue * 2.f;
+}
+
+UFireflyModifierCalculatorTestAbility::UFireflyModifierCalculatorTestAbility(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
+
+bool UFireflyModifierCalculatorTestAbility::CheckAndApplyCost(const TArray<FFireflyEffectModifierData>& NewCostSettings)
+{
+	CostSettings = NewCostSettings;
+	if (!CheckAbilityCost())
+	{
+		return false;
+	}
+
+	ApplyAbilityCost();
+
+	return true;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FireflyModifierCalculatorTest
+{
+	/** 测试期间存在的游戏世界，通过效果调度器推进周期性执行 */
+	struct FScopedTestWorld
+	{
+		FScopedTestWorld()
+		{
+			Scheduler = TestWorld.World->GetSubsystem<UFireflyEffectSchedulerSubsystem>();
+		}
+
+		UFireflyAbilitySystemComponent* SpawnAbilitySystem() const
+		{
+			return TestWorld.SpawnAbilitySystem();
+		}
+
+		/** 将世界时间推进到Time，并触发所有到期的事件 */
+		void AdvanceTo(double Time) const
+		{
+			TestWorld.World->TimeSeconds = Time;
+			Scheduler->Tick(0.f);
+		}
+
+		FFireflyAutomationTestWorld TestWorld;
+
+		UFireflyEffectSchedulerSubsystem* Scheduler = nullptr;
+	};
+
+	/** 统计当前存在的效果实例数，不包括类默认对象 */
+	int32 CountEffectInstances()
+	{
+		int32 NumInstances = 0;
+		for (TObjectIterator<UFireflyEffect> It; It; ++It)
+		{
+			if (!It->HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+			{
+				++NumInstances;
+			}
+		}
+
+		return NumInstances;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyModifierCalculatorReuseTest, "FireflyAbilitySystem.ModifierCalculator.ReuseAcrossPeriods",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyModifierCalculatorReuseTest::RunTest(const FString& Parameters)
+{
+	constexpr EFireflyAttributeType AttributeType = AttributeType001;
+	constexpr int32 NumPeriods = 8;
+
+	FireflyModifierCalculatorTest::FScopedTestWorld TestWorld;
+	if (!TestNotNull(TEXT("Effect scheduler"), TestWorld.Scheduler))
+	{
+		return false;
+	}
+
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+	FFireflyAttributeConstructor Constructor;
+	Constructor.AttributeType = AttributeType;
+	AbilitySystem->ConstructAttributeByConstructor(Constructor);
+	AbilitySystem->InitializeAttributeByType(AttributeType, 0.f);
+
+	FFireflyEffectDynamicConstructor EffectSetup;
+	EffectSetup.DurationPolicy = EFireflyEffectDurationPolicy::HasDuration;
+	EffectSetup.Duration = NumPeriods + 0.5f;
+	EffectSetup.bIsEffectExecutionPeriodic = true;
+	EffectSetup.PeriodicInterval = 1.f;
+
+	FFireflyEffectModifierData Modifier;
+	Modifier.AttributeType = AttributeType;
+	Modifier.ModOperator = EFireflyAttributeModOperator::Plus;
+	Modifier.ModValue = 1.f;
+	Modifier.ModValueMethod = EFireflyEffectModifierValueMethod::CustomCalculator;
+	Modifier.CalculatorClass = UFireflyModifierCalculatorTestCalculator::StaticClass();
+	EffectSetup.Modifiers.Add(Modifier);
+
+	const int32 NumInstancesBefore = UFireflyModifierCalculatorTestCalculator::NumInstancesCreated;
+
+	/** 应用时执行一次，之后逐个周期推进 */
+	AbilitySystem->ApplyEffectDynamicConstructorToOwner(nullptr, EffectSetup);
+	for (int32 Period = 1; Period <= NumPeriods; ++Period)
+	{
+		TestWorld.AdvanceTo(Period);
+	}
+
+	/** 所有周期共用管理器中的同一个计算器，执行期间不再创建新的计算器 */
+	TestEqual(TEXT("Calculators created"), UFireflyModifierCalculatorTestCalculator::NumInstancesCreated - NumInstancesBefore, 1);
+
+	const UFireflyModifierCalculatorTestCalculator* Calculator = Cast<UFireflyModifierCalculatorTestCalculator>(
+		AbilitySystem->GetModifierCalculator(UFireflyModifierCalculatorTestCalculator::StaticClass()));
+	if (!TestNotNull(TEXT("Shared calculator"), Calculator))
+	{
+		return false;
+	}
+
+	TestEqual(TEXT("Calculations"), Calculator->NumCalculations, NumPeriods + 1);
+	TestEqual(TEXT("Attribute value"), AbilitySystem->GetAttributeValue(AttributeType), 2.f * (NumPeriods + 1));
+	TestEqual(TEXT("Calculators created after lookup"), UFireflyModifierCalculatorTestCalculator::NumInstancesCreated - NumInstancesBefore, 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireflyModifierCalculatorAbilityCostTest, "FireflyAbilitySystem.ModifierCalculator.AbilityCostWithoutEffectInstance",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FFireflyModifierCalculatorAbilityCostTest::RunTest(const FString& Parameters)
+{
+	constexpr EFireflyAttributeType AttributeType = AttributeType001;
+
+	FireflyModifierCalculatorTest::FScopedTestWorld TestWorld;
+	UFireflyAbilitySystemComponent* AbilitySystem = TestWorld.SpawnAbilitySystem();
+	FFireflyAttributeConstructor Constructor;
+	Constructor.AttributeType = AttributeType;
+	Constructor.bAttributeHasRange = true;
+	Constructor.RangeMinValue = 0.f;
+	Constructor.RangeMaxValue = 100.f;
+	AbilitySystem->ConstructAttributeByConstructor(Constructor);
+	AbilitySystem->InitializeAttributeByType(AttributeType, 30.f);
+
+	AbilitySystem->GrantAbilityByClass(UFireflyModifierCalculatorTestAbility::StaticClass());
+	UFireflyModifierCalculatorTestAbility* Ability = Cast<UFireflyModifierCalculatorTestAbility>(
+		AbilitySystem->GetGrantedAbilityByClass(UFireflyModifierCalculatorTestAbility::StaticClass()));
+	if (!TestNotNull(TEXT("Granted ability"), Ability))
+	{
+		return false;
+	}
+
+	FFireflyEffectModifierData CostModifier;
+	CostModifier.AttributeType = AttributeType;
+	CostModifier.ModOperator = EFireflyAttributeModOperator::Minus;
+	CostModifier.ModValue = 10.f;
+	CostModifier.ModValueMethod = EFireflyEffectModifierValueMethod::CustomCalculator;
+	CostModifier.CalculatorClass = UFireflyModifierCalculatorTestCalculator::StaticClass();
+	const TArray<FFireflyEffectModifierData> CostSettings = { CostModifier };
+
+	const int32 NumEffectsBefore = FireflyModifierCalculatorTest::CountEffectInstances();
+
+	/** 计算器将消耗翻倍，30足以支付一次20的消耗 */
+	TestTrue(TEXT("First cost committed"), Ability->CheckAndApplyCost(CostSettings));
+	TestEqual(TEXT("Value after first cost"), AbilitySystem->GetAttributeValue(AttributeType), 10.f);
+
+	/** 检验同样经过计算器，剩余的10不足以支付20的消耗 */
+	TestFalse(TEXT("Second cost committed"), Ability->CheckAndApplyCost(CostSettings));
+	TestEqual(TEXT("Value after rejected cost"), AbilitySystem->GetAttributeValue(AttributeType), 10.f);
+
+	/** 消耗以效果类型的默认对象为上下文计算，不创建效果实例 */
+	TestEqual(TEXT("Effects created"), FireflyModifierCalculatorTest::CountEffectInstances() - NumEffectsBefore, 0);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,20 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireflyAbility.h"
+#include "FireflyModifierCalculatorTestAbility.generated.h"
+
+/** 修改器计算器的自动化测试使用的技能，不经过激活流程直接检验并应用技能的消耗 */
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class UFireflyModifierCalculatorTestAbility : public UFireflyAbility
+{
+	GENERATED_BODY()
+
+public:
+	UFireflyModifierCalculatorTestAbility(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	/** 设置技能的消耗，检验通过时应用消耗并返回true */
+	bool CheckAndApplyCost(const TArray<FFireflyEffectModifierData>& NewCostSettings);
+};
@@ -0,0 +1,26 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireflyEffectModifierCalculator.h"
+#include "FireflyModifierCalculatorTestCalculator.generated.h"
+
+/** 修改器计算器的自动化测试使用的计算器，将操作值翻倍，并记录被创建的实例数和计算次数 */
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class UFireflyModifierCalculatorTestCalculator : public UFireflyEffectModifierCalculator
+{
+	GENERATED_BODY()
+
+public:
+	UFireflyModifierCalculatorTestCalculator(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	virtual float CalculateModifierValue_Implementation(UFireflyEffect* EffectInstance, float OriginModValue) override;
+
+public:
+	/** 被创建的计算器实例数，不包括类默认对象 */
+	static int32 NumInstancesCreated;
+
+	/** 该实例执行计算的次数 */
+	int32 NumCalculations = 0;
+};